@@ -94,6 +94,12 @@ t_aggregate::init()
                         t_aggimpl_sum<t_uint8, t_uint64, t_uint64>>();
                 }
                 break;
+                case DTYPE_F64PAIR:
+                {
+                    build_aggregate<
+                        t_aggimpl_pair_sum<t_f64pair, t_f64pair, t_f64pair>>();
+                }
+                break;
                 default:
                 {
                     PSP_COMPLAIN_AND_ABORT("Unexpected dtype");
@@ -260,80 +266,9 @@ t_aggregate::init()
         }
         break;
         case AGGTYPE_MEAN:
+        case AGGTYPE_WEIGHTED_MEAN:
         {
-            switch (m_icolumns[0]->get_dtype())
-            {
-                case DTYPE_INT64:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_int64, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_INT32:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_int32, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_INT16:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_int16, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_INT8:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_int8, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_UINT64:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_uint64, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_UINT32:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_uint32, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_UINT16:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_uint16, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_UINT8:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_uint8, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_FLOAT64:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_float64, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_FLOAT32:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_float32, t_f64pair, t_float64>>();
-                }
-                break;
-                case DTYPE_BOOL:
-                {
-                    build_aggregate<
-                        t_aggimpl_mean<t_uint8, t_f64pair, t_float64>>();
-                }
-                break;
-                default:
-                {
-                    PSP_COMPLAIN_AND_ABORT("Unexpected dtype");
-                }
-            }
+            build_aggregate<t_aggimpl_mean<t_f64pair, t_f64pair, t_float64>>();
         }
         break;
         case AGGTYPE_LAST_VALUE:
@@ -53,6 +53,7 @@ t_aggspec::t_aggspec(const t_aggspec_recipe& v)
     m_agg_one_weight = v.m_agg_one_weight;
     m_agg_two_weight = v.m_agg_two_weight;
     m_invmode = v.m_invmode;
+    m_reducer = v.m_reducer;
 }
 
 t_aggspec::t_aggspec(
@@ -129,6 +130,17 @@ t_aggspec::t_aggspec(const t_str& name, t_aggtype agg,
 }
 #endif
 
+t_aggspec::t_aggspec(const t_str& name, t_aggtype agg,
+    const t_depvec& dependencies, const t_str& reducer)
+    : m_name(name)
+    , m_disp_name(name)
+    , m_agg(agg)
+    , m_dependencies(dependencies)
+    , m_kernel(0)
+    , m_reducer(reducer)
+{
+}
+
 t_aggspec::~t_aggspec() {}
 
 t_str
@@ -306,6 +318,10 @@ t_aggspec::agg_str() const
         {
             return "js_reduce_float64";
         }
+        case AGGTYPE_UDF_CPP_REDUCE_FLOAT64:
+        {
+            return "cpp_reduce_float64";
+        }
         default:
         {
             PSP_COMPLAIN_AND_ABORT("Unknown agg type");
@@ -439,6 +455,7 @@ t_aggspec::get_output_specs(const t_schema& schema) const
         case AGGTYPE_SCALED_DIV:
         case AGGTYPE_SCALED_ADD:
         case AGGTYPE_SCALED_MUL:
+        case AGGTYPE_UDF_CPP_REDUCE_FLOAT64:
         {
             return mk_col_name_type_vec(name(), DTYPE_FLOAT64);
         }
@@ -508,6 +525,79 @@ t_aggspec::is_non_delta() const
     return false;
 }
 
+t_bool
+t_aggspec::is_mean_agg() const
+{
+    return m_agg == AGGTYPE_MEAN || m_agg == AGGTYPE_WEIGHTED_MEAN;
+}
+
+t_str
+t_aggspec::get_mean_delta_colname() const
+{
+    return "psp_mean_delta_" + m_name;
+}
+
+t_bool
+t_aggspec::is_nan_tracked_sum(const t_schema& schema) const
+{
+    switch (m_agg)
+    {
+        case AGGTYPE_SUM:
+        case AGGTYPE_PCT_SUM_PARENT:
+        case AGGTYPE_PCT_SUM_GRAND_TOTAL:
+            break;
+        default:
+            return false;
+    }
+
+    const t_str& depname = get_first_depname();
+    if (!schema.has_column(depname))
+        return false;
+
+    t_dtype dtype = schema.get_dtype(depname);
+    return dtype == DTYPE_FLOAT64 || dtype == DTYPE_FLOAT32;
+}
+
+t_str
+t_aggspec::get_nan_sum_colname() const
+{
+    return "psp_nan_sum_" + m_name;
+}
+
+const t_str&
+t_aggspec::get_reducer_name() const
+{
+    return m_reducer;
+}
+
+t_udf_reducer_csptr
+t_aggspec::get_udf_reducer() const
+{
+    return perspective::get_udf_reducer(m_reducer);
+}
+
+t_bool
+t_aggspec::is_incremental_udf() const
+{
+    if (m_agg != AGGTYPE_UDF_CPP_REDUCE_FLOAT64)
+        return false;
+
+    auto reducer = get_udf_reducer();
+    return reducer && reducer->is_incremental();
+}
+
+t_str
+t_aggspec::get_udf_retract_colname() const
+{
+    return "psp_udf_retract_" + m_name;
+}
+
+t_str
+t_aggspec::get_udf_combine_colname() const
+{
+    return "psp_udf_combine_" + m_name;
+}
+
 t_str
 t_aggspec::get_first_depname() const
 {
@@ -541,6 +631,7 @@ t_aggspec::get_recipe() const
     rv.m_agg_one_weight = m_agg_one_weight;
     rv.m_agg_two_weight = m_agg_two_weight;
     rv.m_invmode = m_invmode;
+    rv.m_reducer = m_reducer;
 
     return rv;
 }
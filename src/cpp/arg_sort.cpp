@@ -11,6 +11,7 @@
 #include <functional>
 #include <perspective/arg_sort.h>
 #include <perspective/multi_sort.h>
+#include <perspective/parallel.h>
 #include <perspective/scalar.h>
 #ifdef PSP_PARALLEL_FOR
 #include <tbb/parallel_sort.h>
@@ -26,7 +27,7 @@ argsort(std::vector<t_index>& output, const t_multisorter& sorter)
     // Output should be the same size is v
     for (t_index i = 0, loop_end = output.size(); i != loop_end; ++i)
         output[i] = i;
-    std::sort(output.begin(), output.end(), sorter);
+    parallel_sort(output.begin(), output.end(), sorter);
 }
 
 t_argsort_comparator::t_argsort_comparator(
@@ -0,0 +1,403 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/arrow_loader.h>
+#include <perspective/loader.h>
+#include <perspective/column.h>
+#include <perspective/storage.h>
+#include <perspective/schema.h>
+#include <perspective/vocab.h>
+#include <perspective/date.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace perspective
+{
+
+namespace
+{
+
+// Days since 1970-01-01 to a t_date, using the proleptic gregorian calendar.
+// Months are zero based to match the js loader.
+t_date
+days_to_date(t_int64 z)
+{
+    z += 719468;
+    t_int64 era = (z >= 0 ? z : z - 146096) / 146097;
+    t_int64 doe = z - era * 146097;
+    t_int64 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    t_int64 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    t_int64 mp = (5 * doy + 2) / 153;
+    t_int64 d = doy - (153 * mp + 2) / 5 + 1;
+    t_int64 m = mp < 10 ? mp + 3 : mp - 9;
+    t_int64 y = yoe + era * 400 + (m <= 2);
+    return t_date(static_cast<t_int16>(y), static_cast<t_int8>(m - 1),
+        static_cast<t_int8>(d));
+}
+
+// Rounds toward negative infinity, so pre epoch timestamps don't move
+// forward when converted to a coarser unit.
+inline t_int64
+floor_div(t_int64 v, t_int64 divisor)
+{
+    return v / divisor - (v % divisor < 0 ? 1 : 0);
+}
+
+// Dictionary indices are signed or unsigned integers of up to 64 bits
+t_bool
+is_dictionary_index(t_dtype dtype)
+{
+    switch (dtype)
+    {
+        case DTYPE_INT8:
+        case DTYPE_UINT8:
+        case DTYPE_INT16:
+        case DTYPE_UINT16:
+        case DTYPE_INT32:
+        case DTYPE_UINT32:
+        case DTYPE_INT64:
+        case DTYPE_UINT64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const t_uint8*
+validity_buffer(const ArrowArray* array)
+{
+    if (array->null_count == 0 || array->n_buffers == 0)
+        return nullptr;
+    return static_cast<const t_uint8*>(array->buffers[0]);
+}
+
+void
+fill_status(
+    t_column* col, const t_uint8* valid, t_uindex offset, t_uindex nrows)
+{
+    if (!col->is_status_enabled())
+        return;
+
+    t_status* status = col->_get_status_lstore()->get_nth<t_status>(0);
+    if (valid)
+    {
+        expand_validity(valid, offset, nrows, status);
+    }
+    else
+    {
+        std::fill(status, status + nrows, STATUS_VALID);
+    }
+}
+
+template <typename IDX_T>
+void
+remap_dictionary(const void* indices, t_uindex offset, t_uindex nrows,
+    const std::vector<t_stridx>& xlat, t_stridx* out)
+{
+    const IDX_T* idx = static_cast<const IDX_T*>(indices) + offset;
+    t_uindex dsize = xlat.size();
+    for (t_uindex ridx = 0; ridx < nrows; ++ridx)
+    {
+        // null slots may hold arbitrary indices
+        t_uindex key = static_cast<t_uindex>(idx[ridx]);
+        out[ridx] = key < dsize ? xlat[key] : 0;
+    }
+}
+
+void
+fill_dictionary_column(t_column* col, const ArrowSchema* schema,
+    const ArrowArray* array, t_uindex offset, t_uindex nrows)
+{
+    const ArrowArray* dict = array->dictionary;
+    const t_int32* doffsets
+        = static_cast<const t_int32*>(dict->buffers[1]) + dict->offset;
+    const char* ddata = static_cast<const char*>(dict->buffers[2]);
+    t_uindex dsize = dict->length;
+
+    // Intern every dictionary entry once, then translate the indices.
+    t_vocab* vocab = col->_get_vocab();
+    vocab->reserve(vocab->get_vlendata()->size()
+            + (doffsets[dsize] - doffsets[0]) + dsize,
+        vocab->get_vlenidx() + dsize + 1);
+
+    std::vector<t_stridx> xlat(dsize);
+    t_str elem;
+    for (t_uindex didx = 0; didx < dsize; ++didx)
+    {
+        t_int32 bidx = doffsets[didx];
+        elem.assign(ddata + bidx, doffsets[didx + 1] - bidx);
+        xlat[didx] = vocab->get_interned(elem);
+    }
+
+    t_stridx* out = col->get_nth<t_stridx>(0);
+    const void* indices = array->buffers[1];
+
+    switch (schema->format[0])
+    {
+        case 'c':
+            remap_dictionary<t_int8>(indices, offset, nrows, xlat, out);
+            break;
+        case 'C':
+            remap_dictionary<t_uint8>(indices, offset, nrows, xlat, out);
+            break;
+        case 's':
+            remap_dictionary<t_int16>(indices, offset, nrows, xlat, out);
+            break;
+        case 'S':
+            remap_dictionary<t_uint16>(indices, offset, nrows, xlat, out);
+            break;
+        case 'i':
+            remap_dictionary<t_int32>(indices, offset, nrows, xlat, out);
+            break;
+        case 'I':
+            remap_dictionary<t_uint32>(indices, offset, nrows, xlat, out);
+            break;
+        case 'l':
+            remap_dictionary<t_int64>(indices, offset, nrows, xlat, out);
+            break;
+        case 'L':
+            remap_dictionary<t_uint64>(indices, offset, nrows, xlat, out);
+            break;
+        default:
+        {
+            PSP_COMPLAIN_AND_ABORT("Unexpected dictionary index type");
+        }
+    }
+}
+
+template <typename SRC_T>
+void
+fill_date_column(t_column* col, const void* data, t_uindex offset,
+    t_uindex nrows, t_int64 divisor)
+{
+    const SRC_T* src = static_cast<const SRC_T*>(data) + offset;
+    t_date* out = col->get_nth<t_date>(0);
+    for (t_uindex ridx = 0; ridx < nrows; ++ridx)
+    {
+        out[ridx] = days_to_date(
+            floor_div(static_cast<t_int64>(src[ridx]), divisor));
+    }
+}
+
+void
+fill_arrow_column(t_column* col, const ArrowSchema* schema,
+    const ArrowArray* array, t_uindex parent_offset, t_uindex nrows)
+{
+    t_uindex offset = parent_offset + array->offset;
+    const t_uint8* valid = validity_buffer(array);
+    const char* format = schema->format;
+
+    if (schema->dictionary)
+    {
+        fill_dictionary_column(col, schema, array, offset, nrows);
+        fill_status(col, valid, offset, nrows);
+        return;
+    }
+
+    switch (col->get_dtype())
+    {
+        case DTYPE_BOOL:
+        {
+            unpack_bits(static_cast<const t_uint8*>(array->buffers[1]), offset,
+                nrows, col->get_nth<t_uint8>(0));
+            fill_status(col, valid, offset, nrows);
+        }
+        break;
+        case DTYPE_DATE:
+        {
+            if (format[2] == 'D')
+            {
+                fill_date_column<t_int32>(
+                    col, array->buffers[1], offset, nrows, 1);
+            }
+            else
+            {
+                fill_date_column<t_int64>(col, array->buffers[1], offset,
+                    nrows, 24 * 3600 * 1000LL);
+            }
+            fill_status(col, valid, offset, nrows);
+        }
+        break;
+        case DTYPE_TIME:
+        {
+            t_column_buffer buf(
+                "", DTYPE_TIME, array->buffers[1], nrows, valid);
+            buf.m_offset = offset;
+            fill_column(col, buf);
+
+            // perspective times are milliseconds since epoch
+            t_int64* out = col->get_nth<t_int64>(0);
+            switch (format[2])
+            {
+                case 's':
+                {
+                    for (t_uindex ridx = 0; ridx < nrows; ++ridx)
+                        out[ridx] *= 1000;
+                }
+                break;
+                case 'u':
+                {
+                    for (t_uindex ridx = 0; ridx < nrows; ++ridx)
+                        out[ridx] = floor_div(out[ridx], 1000);
+                }
+                break;
+                case 'n':
+                {
+                    for (t_uindex ridx = 0; ridx < nrows; ++ridx)
+                        out[ridx] = floor_div(out[ridx], 1000000);
+                }
+                break;
+                default:
+                    break;
+            }
+        }
+        break;
+        case DTYPE_STR:
+        {
+            t_column_buffer buf("",
+                static_cast<const char*>(array->buffers[2]),
+                static_cast<const t_int32*>(array->buffers[1]), nrows, valid);
+            buf.m_offset = offset;
+            fill_column(col, buf);
+        }
+        break;
+        default:
+        {
+            t_column_buffer buf(
+                "", col->get_dtype(), array->buffers[1], nrows, valid);
+            buf.m_offset = offset;
+            fill_column(col, buf);
+        }
+    }
+}
+
+} // namespace
+
+t_dtype
+arrow_format_to_dtype(const char* format)
+{
+    if (format == nullptr || format[0] == '\0')
+        return DTYPE_NONE;
+
+    if (format[1] == '\0')
+    {
+        switch (format[0])
+        {
+            case 'b':
+                return DTYPE_BOOL;
+            case 'c':
+                return DTYPE_INT8;
+            case 'C':
+                return DTYPE_UINT8;
+            case 's':
+                return DTYPE_INT16;
+            case 'S':
+                return DTYPE_UINT16;
+            case 'i':
+                return DTYPE_INT32;
+            case 'I':
+                return DTYPE_UINT32;
+            case 'l':
+                return DTYPE_INT64;
+            case 'L':
+                return DTYPE_UINT64;
+            case 'f':
+                return DTYPE_FLOAT32;
+            case 'g':
+                return DTYPE_FLOAT64;
+            case 'u':
+                return DTYPE_STR;
+            default:
+                return DTYPE_NONE;
+        }
+    }
+
+    if (format[0] == 't' && format[1] == 'd'
+        && (format[2] == 'D' || format[2] == 'm') && format[3] == '\0')
+    {
+        return DTYPE_DATE;
+    }
+
+    if (format[0] == 't' && format[1] == 's' && format[2] != '\0'
+        && format[3] == ':')
+    {
+        return DTYPE_TIME;
+    }
+
+    return DTYPE_NONE;
+}
+
+t_table_sptr
+load_arrow_table(const ArrowSchema* schema, const ArrowArray* array,
+    const t_str& index, t_bool is_delete)
+{
+    if (std::strcmp(schema->format, "+s") != 0)
+    {
+        throw std::invalid_argument(
+            t_str("Expected a struct array, got format ") + schema->format);
+    }
+
+    if (schema->n_children != array->n_children)
+    {
+        throw std::invalid_argument(
+            "Arrow schema and array have a different number of children");
+    }
+
+    t_uindex nrows = array->length;
+    std::vector<t_str> colnames;
+    std::vector<t_dtype> dtypes;
+    std::vector<t_uindex> children;
+
+    for (t_index cidx = 0; cidx < schema->n_children; ++cidx)
+    {
+        const ArrowSchema* child = schema->children[cidx];
+        t_dtype dtype = child->dictionary
+            ? arrow_format_to_dtype(child->dictionary->format)
+            : arrow_format_to_dtype(child->format);
+
+        if (dtype == DTYPE_NONE
+            || (child->dictionary
+                && (dtype != DTYPE_STR
+                    || !is_dictionary_index(
+                        arrow_format_to_dtype(child->format)))))
+        {
+            // Dropping the column would hand back a different schema than
+            // the caller exported
+            throw std::invalid_argument(t_str("Arrow column ") + child->name
+                + " has unsupported format " + child->format);
+        }
+
+        colnames.push_back(child->name);
+        dtypes.push_back(dtype);
+        children.push_back(cidx);
+    }
+
+    auto tbl = std::make_shared<t_table>(t_schema(colnames, dtypes), nrows);
+    tbl->init();
+    tbl->extend(nrows);
+
+    if (nrows > 0)
+    {
+        for (t_uindex idx = 0, loop_end = children.size(); idx < loop_end;
+             ++idx)
+        {
+            t_uindex cidx = children[idx];
+            fill_arrow_column(tbl->_get_column(colnames[idx]),
+                schema->children[cidx], array->children[cidx], array->offset,
+                nrows);
+        }
+    }
+
+    add_index_columns(tbl.get(), index, is_delete);
+    return tbl;
+}
+
+} // end namespace perspective
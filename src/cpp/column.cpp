@@ -409,12 +409,24 @@ t_column::_get_data_lstore()
     return m_data.get();
 }
 
+t_lstore*
+t_column::_get_status_lstore()
+{
+    return m_status.get();
+}
+
 t_vocab*
 t_column::_get_vocab()
 {
     return m_vocab.get();
 }
 
+const t_vocab*
+t_column::_get_vocab() const
+{
+    return m_vocab.get();
+}
+
 t_uindex
 t_column::get_vlenidx() const
 {
@@ -836,11 +848,21 @@ t_column::append(const t_column& other)
         }
         else
         {
-            for (t_uindex idx = 0, loop_end = other.size(); idx < loop_end;
-                 ++idx)
+            t_uindex base = size();
+            t_uindex nrows = other.size();
+            m_data->reserve(m_elemsize * (base + nrows));
+            m_data->set_size(m_elemsize * (base + nrows));
+            m_size = base + nrows;
+
+            if (nrows > 0)
             {
-                const char* s = other.get_nth<const char>(idx);
-                push_back(s);
+                const t_uindex* o_ids = other.m_data->get_nth<t_uindex>(0);
+                t_uindex* ids = m_data->get_nth<t_uindex>(base);
+                t_vocab_translation translation(*other.m_vocab, *m_vocab);
+                for (t_uindex idx = 0; idx < nrows; ++idx)
+                {
+                    ids[idx] = translation.translate(o_ids[idx]);
+                }
             }
 
             if (is_status_enabled())
@@ -1085,10 +1107,27 @@ t_column::copy_helper<const char>(const t_column* other,
     t_uindex eidx
         = std::min(other->size(), static_cast<t_uindex>(indices.size()));
     reserve(eidx + offset);
+    if (eidx == 0)
+        return;
+
+    const t_uindex* o_base = other->m_data->get_nth<t_uindex>(0);
+    t_uindex* base = m_data->get_nth<t_uindex>(0);
+    t_vocab_translation translation(*other->m_vocab, *m_vocab);
 
     for (t_uindex idx = 0; idx < eidx; ++idx)
     {
-        set_scalar(offset + idx, other->get_scalar(indices[idx]));
+        base[idx + offset] = translation.translate(o_base[indices[idx]]);
+    }
+
+    if (is_status_enabled())
+    {
+        t_bool o_status = other->is_status_enabled();
+        for (t_uindex idx = 0; idx < eidx; ++idx)
+        {
+            set_status(idx + offset,
+                o_status ? *other->get_nth_status(indices[idx])
+                         : STATUS_VALID);
+        }
     }
     COLUMN_CHECK_VALUES();
 }
@@ -15,7 +15,7 @@
 #include <perspective/sparse_tree.h>
 #include <perspective/tree_context_common.h>
 #include <perspective/sparse_tree_node.h>
-#include <perspective/logtime.h>
+#include <perspective/trace.h>
 #include <perspective/traversal.h>
 #include <perspective/env_vars.h>
 #include <perspective/filter_utils.h>
@@ -316,14 +316,13 @@ t_ctx_grouped_pkey::sort_by(const t_sortsvec& sortby)
 {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
-    psp_log_time(repr() + " sort_by.enter");
+    t_trace_scope scope(TRACE_CTX_GROUPED_PKEY_SORT_BY);
     m_sortby = sortby;
     if (m_sortby.empty())
     {
         return;
     }
     m_traversal->sort_by(m_config, sortby, *this);
-    psp_log_time(repr() + " sort_by.exit");
 }
 
 void
@@ -461,6 +460,13 @@ t_ctx_grouped_pkey::set_minmax_enabled(bool enabled_state)
     m_tree->set_minmax_enabled(enabled_state);
 }
 
+void
+t_ctx_grouped_pkey::set_order_stats_enabled(bool enabled_state)
+{
+    m_features[CTX_FEAT_ORDER_STATS] = enabled_state;
+    m_tree->set_order_stats_enabled(enabled_state);
+}
+
 t_minmaxvec
 t_ctx_grouped_pkey::get_min_max() const
 {
@@ -512,6 +518,7 @@ t_ctx_grouped_pkey::reset()
         pivots, m_config.get_aggregates(), m_schema, m_config);
     m_tree->init();
     m_tree->set_deltas_enabled(get_feature_state(CTX_FEAT_DELTA));
+    m_tree->set_order_stats_enabled(get_feature_state(CTX_FEAT_ORDER_STATS));
     m_traversal = std::shared_ptr<t_traversal>(
         new t_traversal(m_tree, m_config.handle_nan_sort()));
 }
@@ -563,6 +570,7 @@ rebuild_helper(t_column*)
 void
 t_ctx_grouped_pkey::rebuild()
 {
+    t_trace_scope scope(TRACE_CTX_GROUPED_PKEY_REBUILD);
     auto tbl = m_state->get_pkeyed_table();
 
     if (m_config.has_filters())
@@ -729,7 +737,6 @@ t_ctx_grouped_pkey::rebuild()
         }
     }
 
-    psp_log_time(repr() + " rebuild.post_queue");
     auto aggtable = m_tree->_get_aggtable();
     aggtable->extend(nrows + 1);
 
@@ -769,12 +776,10 @@ t_ctx_grouped_pkey::rebuild()
 
     set_expansion_state(expansion_state);
 
-    psp_log_time(repr() + " rebuild.pre_sortby");
     if (!m_sortby.empty())
     {
         m_traversal->sort_by(m_config, m_sortby, *this);
     }
-    psp_log_time(repr() + " rebuild.exit");
 }
 
 void
@@ -788,9 +793,8 @@ t_ctx_grouped_pkey::notify(const t_table& flattened)
 {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
-    psp_log_time(repr() + " notify.enter");
+    t_trace_scope scope(TRACE_CTX_GROUPED_PKEY_NOTIFY);
     rebuild();
-    psp_log_time(repr() + " notify.exit");
 }
 
 // aggregates should be presized to be same size
@@ -15,7 +15,7 @@
 #include <perspective/filter.h>
 #include <perspective/sparse_tree.h>
 #include <perspective/tree_context_common.h>
-#include <perspective/logtime.h>
+#include <perspective/trace.h>
 #include <perspective/env_vars.h>
 #include <perspective/traversal.h>
 
@@ -183,11 +183,11 @@ t_ctx1::notify(const t_table& flattened, const t_table& delta,
 {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
-    psp_log_time(repr() + " notify.enter");
+    t_trace_scope scope(TRACE_CTX1_NOTIFY);
     notify_sparse_tree(m_tree, m_traversal, true, m_config.get_aggregates(),
         m_config.get_sortby_pairs(), m_sortby, flattened, delta, prev, current,
-        transitions, existed, m_config, *m_state);
-    psp_log_time(repr() + " notify.exit");
+        transitions, existed, m_config, *m_state, m_filter_cache.get(),
+        m_strand_cache.get());
 }
 
 void
@@ -375,6 +375,13 @@ t_ctx1::set_minmax_enabled(bool enabled_state)
     m_tree->set_minmax_enabled(enabled_state);
 }
 
+void
+t_ctx1::set_order_stats_enabled(bool enabled_state)
+{
+    m_features[CTX_FEAT_ORDER_STATS] = enabled_state;
+    m_tree->set_order_stats_enabled(enabled_state);
+}
+
 t_minmaxvec
 t_ctx1::get_min_max() const
 {
@@ -426,6 +433,7 @@ t_ctx1::reset()
         pivots, m_config.get_aggregates(), m_schema, m_config);
     m_tree->init();
     m_tree->set_deltas_enabled(get_feature_state(CTX_FEAT_DELTA));
+    m_tree->set_order_stats_enabled(get_feature_state(CTX_FEAT_ORDER_STATS));
     m_traversal = std::shared_ptr<t_traversal>(
         new t_traversal(m_tree, m_config.handle_nan_sort()));
 }
@@ -557,7 +565,8 @@ t_ctx1::notify(const t_table& flattened)
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     notify_sparse_tree(m_tree, m_traversal, true, m_config.get_aggregates(),
-        m_config.get_sortby_pairs(), m_sortby, flattened, m_config, *m_state);
+        m_config.get_sortby_pairs(), m_sortby, flattened, m_config, *m_state,
+        m_filter_cache.get(), m_strand_cache.get());
 }
 
 void
@@ -753,14 +762,20 @@ t_ctx1::unity_init_load_step_end()
 t_table_sptr
 t_ctx1::get_table() const
 {
-    auto schema = m_tree->get_aggtable()->get_schema();
+    // the tree's aggregate table may carry hidden columns after the
+    // aggregates themselves
+    const t_schema& aggschema = m_tree->get_aggtable()->get_schema();
+    auto n_aggs = m_config.get_num_aggregates();
+    t_schema schema(std::vector<t_str>(aggschema.m_columns.begin(),
+                        aggschema.m_columns.begin() + n_aggs),
+        std::vector<t_dtype>(
+            aggschema.m_types.begin(), aggschema.m_types.begin() + n_aggs));
     auto pivots = m_config.get_row_pivots();
     auto tbl = std::make_shared<t_table>(schema, m_tree->size());
     tbl->init();
     tbl->extend(m_tree->size());
 
     t_colptrvec aggcols = tbl->get_columns();
-    auto n_aggs = aggcols.size();
     t_colptrvec pivcols;
 
     std::stringstream ss;
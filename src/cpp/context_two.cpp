@@ -13,7 +13,7 @@
 #include <perspective/extract_aggregate.h>
 #include <perspective/sparse_tree.h>
 #include <perspective/tree_context_common.h>
-#include <perspective/logtime.h>
+#include <perspective/trace.h>
 #include <perspective/traversal.h>
 
 namespace perspective
@@ -350,43 +350,67 @@ t_ctx2::reset_sortby()
     m_sortby = t_sortsvec();
 }
 
+template <typename NOTIFY_T>
+void
+t_ctx2::notify_trees(const NOTIFY_T& notify_tree)
+{
+    // Each tree builds its own strands, dense tree and traversal from the
+    // shared input tables, so the trees are updated concurrently.
+    t_uindex ntrees = m_trees.size();
+#ifdef PSP_PARALLEL_FOR
+    PSP_PFOR(0, int(ntrees), 1,
+        [&notify_tree](int tree_idx)
+#else
+    for (t_uindex tree_idx = 0; tree_idx < ntrees; ++tree_idx)
+#endif
+        { notify_tree(tree_idx); }
+
+#ifdef PSP_PARALLEL_FOR
+    );
+#endif
+}
+
 void
 t_ctx2::notify(const t_table& flattened, const t_table& delta,
     const t_table& prev, const t_table& current, const t_table& transitions,
     const t_table& existed)
 {
-    psp_log_time(repr() + " notify.enter");
-    for (t_uindex tree_idx = 0, loop_end = m_trees.size(); tree_idx < loop_end;
-         ++tree_idx)
-    {
+    t_trace_scope scope(TRACE_CTX2_NOTIFY);
+
+    auto notify_tree = [&](t_uindex tree_idx) {
+        t_trace_scope tree_scope(TRACE_CTX2_NOTIFY_TREE);
         if (is_rtree_idx(tree_idx))
         {
             notify_sparse_tree(rtree(), m_rtraversal, true,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
                 m_row_sortby, flattened, delta, prev, current, transitions,
-                existed, m_config, *m_state);
+                existed, m_config, *m_state, m_filter_cache.get(),
+                m_strand_cache.get());
         }
         else if (is_ctree_idx(tree_idx))
         {
             notify_sparse_tree(ctree(), m_ctraversal, true,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
                 m_column_sortby, flattened, delta, prev, current, transitions,
-                existed, m_config, *m_state);
+                existed, m_config, *m_state, m_filter_cache.get(),
+                m_strand_cache.get());
         }
         else
         {
             notify_sparse_tree(m_trees[tree_idx], t_trav_sptr(0), false,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
                 t_sortsvec(), flattened, delta, prev, current, transitions,
-                existed, m_config, *m_state);
+                existed, m_config, *m_state, m_filter_cache.get(),
+                m_strand_cache.get());
         }
-    }
+    };
+
+    notify_trees(notify_tree);
 
     if (!m_sortby.empty())
     {
         sort_by(m_sortby);
     }
-    psp_log_time(repr() + " notify.exit");
 }
 
 t_uindex
@@ -855,6 +879,8 @@ t_ctx2::reset()
             pivots, m_config.get_aggregates(), m_schema, m_config);
         m_trees[treeidx]->init();
         m_trees[treeidx]->set_deltas_enabled(get_feature_state(CTX_FEAT_DELTA));
+        m_trees[treeidx]->set_order_stats_enabled(
+            get_feature_state(CTX_FEAT_ORDER_STATS));
     }
 
     m_rtraversal
@@ -915,6 +941,16 @@ t_ctx2::set_minmax_enabled(bool enabled_state)
     }
 }
 
+void
+t_ctx2::set_order_stats_enabled(bool enabled_state)
+{
+    m_features[CTX_FEAT_ORDER_STATS] = enabled_state;
+    for (auto& tr : m_trees)
+    {
+        tr->set_order_stats_enabled(enabled_state);
+    }
+}
+
 t_streeptr_vec
 t_ctx2::get_trees()
 {
@@ -1084,28 +1120,32 @@ t_ctx2::has_deltas() const
 void
 t_ctx2::notify(const t_table& flattened)
 {
-    for (t_uindex tree_idx = 0, loop_end = m_trees.size(); tree_idx < loop_end;
-         ++tree_idx)
-    {
+    auto notify_tree = [&](t_uindex tree_idx) {
+        t_trace_scope tree_scope(TRACE_CTX2_NOTIFY_TREE);
         if (is_rtree_idx(tree_idx))
         {
             notify_sparse_tree(rtree(), m_rtraversal, true,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
-                m_row_sortby, flattened, m_config, *m_state);
+                m_row_sortby, flattened, m_config, *m_state,
+                m_filter_cache.get(), m_strand_cache.get());
         }
         else if (is_ctree_idx(tree_idx))
         {
             notify_sparse_tree(ctree(), m_ctraversal, true,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
-                m_column_sortby, flattened, m_config, *m_state);
+                m_column_sortby, flattened, m_config, *m_state,
+                m_filter_cache.get(), m_strand_cache.get());
         }
         else
         {
             notify_sparse_tree(m_trees[tree_idx], t_trav_sptr(0), false,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
-                t_sortsvec(), flattened, m_config, *m_state);
+                t_sortsvec(), flattened, m_config, *m_state,
+                m_filter_cache.get(), m_strand_cache.get());
         }
-    }
+    };
+
+    notify_trees(notify_tree);
 }
 
 void
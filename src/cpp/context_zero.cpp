@@ -13,7 +13,7 @@
 #include <perspective/context_zero.h>
 #include <perspective/flat_traversal.h>
 #include <perspective/sym_table.h>
-#include <perspective/logtime.h>
+#include <perspective/trace.h>
 #include <perspective/filter_utils.h>
 
 namespace perspective
@@ -64,7 +64,9 @@ t_ctx0::step_end()
     t_uindex ncols = m_config.get_num_columns();
     t_minmaxvec rval(ncols);
 
-    auto pkeys = m_traversal->get_pkeys();
+    // Column minmax don't depend on row order, so a windowed traversal
+    // doesn't need to sort its tail here.
+    auto pkeys = m_traversal->get_pkeys_unordered();
     auto stbl = m_state->get_table();
 
 #ifdef PSP_PARALLEL_FOR
@@ -283,15 +285,17 @@ t_ctx0::get_cell_delta(t_tvidx bidx, t_tvidx eidx) const
         }
 
         t_tscaltvimap r_indices;
-        m_traversal->get_row_indices(pkeys, r_indices);
+        m_traversal->get_row_indices(bidx,
+            std::min(eidx + 1, m_traversal->size()), pkeys, r_indices);
 
         for (iter_by_zc_pkey_colidx iter
              = m_deltas->get<by_zc_pkey_colidx>().begin();
              iter != m_deltas->get<by_zc_pkey_colidx>().end(); ++iter)
         {
-            t_tvidx row = r_indices[iter->m_pkey];
-            if (bidx <= row && row <= eidx)
+            auto riter = r_indices.find(iter->m_pkey);
+            if (riter != r_indices.end())
             {
+                t_tvidx row = riter->second;
                 t_cellupd cellupd;
                 cellupd.row = row;
                 cellupd.column = iter->m_colidx;
@@ -329,6 +333,12 @@ t_ctx0::get_sort_by() const
     return m_traversal->get_sort_by();
 }
 
+void
+t_ctx0::set_sort_window(t_uindex nrows)
+{
+    m_traversal->set_sort_window(nrows);
+}
+
 void
 t_ctx0::reset()
 {
@@ -336,6 +346,7 @@ t_ctx0::reset()
     m_deltas = std::make_shared<t_zcdeltas>();
     m_minmax = t_minmaxvec(m_config.get_num_columns());
     m_has_delta = false;
+    m_filter_pass.clear();
 }
 
 t_index
@@ -349,7 +360,7 @@ t_ctx0::notify(const t_table& flattened, const t_table& delta,
     const t_table& prev, const t_table& curr, const t_table& transitions,
     const t_table& existed)
 {
-    psp_log_time(repr() + " notify.enter");
+    t_trace_scope scope(TRACE_CTX0_NOTIFY);
     t_uindex nrecs = flattened.size();
     t_col_csptr pkey_sptr = flattened.get_const_column("psp_pkey");
     t_col_csptr op_sptr = flattened.get_const_column("psp_op");
@@ -362,8 +373,14 @@ t_ctx0::notify(const t_table& flattened, const t_table& delta,
     t_bool delete_encountered = false;
     if (m_config.has_filters())
     {
-        auto msk_prev = filter_table_for_config(prev, m_config);
-        auto msk_curr = filter_table_for_config(curr, m_config);
+        // The previous result of a row that existed is the one stored for
+        // it, and only added rows and rows with a changed filter column
+        // are filtered again.
+        std::vector<t_rlookup> lkup;
+        m_state->lookup_batch(*pkey_col, lkup);
+        auto changed = get_filter_changes(flattened, transitions, existed);
+        auto msk_curr = filter_table_for_config(
+            curr, m_config, &changed, m_filter_cache.get());
 
         for (t_uindex idx = 0; idx < nrecs; ++idx)
         {
@@ -378,8 +395,11 @@ t_ctx0::notify(const t_table& flattened, const t_table& delta,
             {
                 case OP_INSERT:
                 {
-                    t_bool filter_curr = msk_curr->get(idx);
-                    t_bool filter_prev = msk_prev->get(idx) && existed;
+                    t_uindex sidx = lkup[idx].m_idx;
+                    t_bool filter_prev = existed && get_filter_pass(sidx);
+                    t_bool filter_curr = changed.get(idx) ? msk_curr->get(idx)
+                                                          : filter_prev;
+                    set_filter_pass(sidx, filter_curr);
 
                     if (filter_prev)
                     {
@@ -414,10 +434,8 @@ t_ctx0::notify(const t_table& flattened, const t_table& delta,
                 break;
             }
         }
-        psp_log_time(repr() + " notify.has_filter_path.updated_traversal");
         calc_step_delta(flattened, prev, curr, transitions);
         m_has_delta = m_deltas->size() > 0 || delete_encountered;
-        psp_log_time(repr() + " notify.has_filter_path.exit");
 
         return;
     }
@@ -458,10 +476,8 @@ t_ctx0::notify(const t_table& flattened, const t_table& delta,
         }
     }
 
-    psp_log_time(repr() + " notify.no_filter_path.updated_traversal");
     calc_step_delta(flattened, prev, curr, transitions);
     m_has_delta = m_deltas->size() > 0 || delete_encountered;
-    psp_log_time(repr() + " notify.no_filter_path.exit");
 }
 
 void
@@ -568,7 +584,10 @@ t_ctx0::notify(const t_table& flattened)
 
     if (m_config.has_filters())
     {
-        auto msk = filter_table_for_config(flattened, m_config);
+        auto msk = filter_table_for_config(
+            flattened, m_config, nullptr, m_filter_cache.get());
+        std::vector<t_rlookup> lkup;
+        m_state->lookup_batch(*pkey_col, lkup);
 
         for (t_uindex idx = 0; idx < nrecs; ++idx)
         {
@@ -581,6 +600,7 @@ t_ctx0::notify(const t_table& flattened)
             {
                 case OP_INSERT:
                 {
+                    set_filter_pass(lkup[idx].m_idx, msk->get(idx));
                     if (msk->get(idx))
                     {
                         m_traversal->add_row(m_state, m_config, pkey);
@@ -619,6 +639,72 @@ t_ctx0::notify(const t_table& flattened)
     }
 }
 
+t_mask
+t_ctx0::get_filter_changes(const t_table& flattened, const t_table& transitions,
+    const t_table& existed) const
+{
+    t_uindex nrecs = flattened.size();
+    const t_column* op_col = flattened.get_const_column("psp_op").get();
+    const t_column* existed_col
+        = existed.get_const_column("psp_existed").get();
+
+    std::vector<const t_column*> tcols;
+    t_bool all_changed = false;
+    for (const auto& fterm : m_config.get_fterms())
+    {
+        if (!transitions.get_schema().has_column(fterm.m_colname))
+        {
+            all_changed = true;
+            break;
+        }
+        tcols.push_back(transitions.get_const_column(fterm.m_colname).get());
+    }
+    std::sort(tcols.begin(), tcols.end());
+    tcols.erase(std::unique(tcols.begin(), tcols.end()), tcols.end());
+
+    t_mask changed(nrecs);
+    for (t_uindex idx = 0; idx < nrecs; ++idx)
+    {
+        if (*(op_col->get_nth<t_uint8>(idx)) != OP_INSERT)
+            continue;
+
+        t_bool row_changed
+            = all_changed || !*(existed_col->get_nth<t_bool>(idx));
+
+        for (t_uindex cidx = 0; !row_changed && cidx < tcols.size(); ++cidx)
+        {
+            auto tr = static_cast<t_value_transition>(
+                *(tcols[cidx]->get_nth<t_uint8>(idx)));
+            row_changed = tr != VALUE_TRANSITION_EQ_TT
+                && tr != VALUE_TRANSITION_EQ_FF;
+        }
+
+        if (row_changed)
+            changed.set(idx);
+    }
+
+    return changed;
+}
+
+t_bool
+t_ctx0::get_filter_pass(t_uindex sidx) const
+{
+    return sidx < m_filter_pass.size() && m_filter_pass[sidx];
+}
+
+void
+t_ctx0::set_filter_pass(t_uindex sidx, t_bool pass)
+{
+    if (sidx >= m_filter_pass.size())
+    {
+        if (!pass)
+            return;
+        m_filter_pass.resize(
+            std::max<t_uindex>(sidx + 1, 2 * m_filter_pass.size()));
+    }
+    m_filter_pass[sidx] = pass;
+}
+
 void
 t_ctx0::pprint() const
 {
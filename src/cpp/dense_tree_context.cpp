@@ -71,6 +71,15 @@ t_dtree_ctx::build_aggregates()
         }
     }
 
+    for (const auto& spec : m_aggspecs)
+    {
+        if (spec.is_nan_tracked_sum(delta_schema))
+        {
+            columns.push_back(spec.get_nan_sum_colname());
+            dtypes.push_back(DTYPE_F64PAIR);
+        }
+    }
+
     t_schema aggschema(columns, dtypes);
 
     m_aggregates = std::make_shared<t_table>(aggschema, m_tree.size());
@@ -87,15 +96,37 @@ t_dtree_ctx::build_aggregates()
             = aggspec.is_non_delta() ? m_strands.get() : m_strand_deltas.get();
 
         t_colcsptrvec icolumns;
-        for (const auto& d : deps)
+        if (aggspec.is_mean_agg())
+        {
+            icolumns.push_back(
+                tbl->get_const_column(aggspec.get_mean_delta_colname()));
+        }
+        else if (aggspec.agg() == AGGTYPE_UDF_CPP_REDUCE_FLOAT64)
         {
-            icolumns.push_back(tbl->get_const_column(d.name()));
+            // folded by the sparse tree, the strands don't carry its
+            // dependencies
+        }
+        else
+        {
+            for (const auto& d : deps)
+            {
+                icolumns.push_back(tbl->get_const_column(d.name()));
+            }
         }
 
         auto output_col = m_aggregates->get_column(aggspec.name());
 
         t_aggregate agg(m_tree, aggspec.agg(), icolumns, output_col);
         agg.init();
+
+        if (aggspec.is_nan_tracked_sum(delta_schema))
+        {
+            const t_str& colname = aggspec.get_nan_sum_colname();
+            t_aggregate nan_agg(m_tree, AGGTYPE_SUM,
+                t_colcsptrvec{tbl->get_const_column(colname)},
+                m_aggregates->get_column(colname));
+            nan_agg.init();
+        }
     }
 }
 
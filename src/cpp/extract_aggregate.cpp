@@ -75,6 +75,7 @@ extract_aggregate(const t_aggspec& aggspec, const t_column* aggcol,
         case AGGTYPE_DISTINCT_COUNT:
         case AGGTYPE_DISTINCT_LEAF:
         case AGGTYPE_UDF_JS_REDUCE_FLOAT64:
+        case AGGTYPE_UDF_CPP_REDUCE_FLOAT64:
         {
             t_tscalar rval = aggcol->get_scalar(ridx);
             return rval;
@@ -21,8 +21,6 @@ t_fterm::t_fterm(const t_fterm_recipe& v)
     m_op = v.m_op;
     m_threshold = v.m_threshold;
     m_bag = v.m_bag;
-    m_use_interned = (m_op == FILTER_OP_EQ || m_op == FILTER_OP_NE)
-        && m_threshold.m_type == DTYPE_STR;
 }
 
 t_fterm::t_fterm(const t_str& colname, t_filter_op op, t_tscalar threshold,
@@ -34,8 +32,6 @@ t_fterm::t_fterm(const t_str& colname, t_filter_op op, t_tscalar threshold,
     , m_negated(negated)
     , m_is_primary(is_primary)
 {
-    m_use_interned = (op == FILTER_OP_EQ || op == FILTER_OP_NE)
-        && threshold.m_type == DTYPE_STR;
 }
 
 t_fterm::t_fterm(const t_str& colname, t_filter_op op, t_tscalar threshold,
@@ -47,8 +43,6 @@ t_fterm::t_fterm(const t_str& colname, t_filter_op op, t_tscalar threshold,
     , m_negated(false)
     , m_is_primary(false)
 {
-    m_use_interned = (op == FILTER_OP_EQ || op == FILTER_OP_NE)
-        && threshold.m_type == DTYPE_STR;
 }
 
 void
@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/config.h>
+#include <perspective/filter_cache.h>
+#include <perspective/filter_utils.h>
+#include <algorithm>
+#include <sstream>
+
+namespace perspective
+{
+
+namespace
+{
+
+void
+append_scalar(std::ostream& os, const t_tscalar& value)
+{
+    // Raw bits rather than to_string, which rounds floats
+    os << ' ' << t_uindex(value.m_type) << ':' << t_uindex(value.m_status)
+       << ':';
+    if (value.m_type == DTYPE_STR)
+    {
+        const char* str = value.get_char_ptr();
+        os << strlen(str) << ':' << str;
+    }
+    else
+    {
+        os << value.m_data.m_uint64;
+    }
+}
+
+} // namespace
+
+t_filter_cache::t_filter_cache()
+    : m_active(false)
+{
+}
+
+void
+t_filter_cache::begin_step()
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_entries.clear();
+    m_active = true;
+}
+
+void
+t_filter_cache::end_step()
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_active = false;
+}
+
+t_masksptr
+t_filter_cache::filter(
+    const t_table& tbl, const t_config& config, const t_mask* select)
+{
+    if (config.get_fmode() != FMODE_SIMPLE_CLAUSES)
+        return filter_table_for_config(tbl, config, select);
+
+    t_key key(&tbl, get_filter_key(config),
+        select ? select->get_words() : std::vector<t_uint64>());
+    std::shared_ptr<t_entry> entry;
+
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (m_active)
+        {
+            auto& slot = m_entries[key];
+            if (!slot)
+                slot = std::make_shared<t_entry>();
+            entry = slot;
+        }
+    }
+
+    if (!entry)
+        return filter_table_for_config(tbl, config, select);
+
+    // Contexts asking for the same mask wait for the first one to compute
+    // it instead of holding the lock while filtering
+    std::call_once(entry->m_once, [&entry, &tbl, &config, select]() {
+        entry->m_mask = filter_table_for_config(tbl, config, select);
+    });
+
+    return entry->m_mask;
+}
+
+t_uindex
+t_filter_cache::get_num_masks() const
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_entries.size();
+}
+
+t_str
+t_filter_cache::get_filter_key(const t_config& config)
+{
+    std::vector<t_str> terms;
+    for (const auto& fterm : config.get_fterms())
+    {
+        std::stringstream ss;
+        ss << fterm.m_colname.size() << ':' << fterm.m_colname << ' '
+           << fterm.m_op << ' ' << fterm.m_negated;
+        append_scalar(ss, fterm.m_threshold);
+        for (const auto& value : fterm.m_bag)
+        {
+            append_scalar(ss, value);
+        }
+        terms.push_back(ss.str());
+    }
+
+    // AND and OR don't depend on the order or repetition of their terms
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    std::stringstream ss;
+    ss << config.get_combiner();
+    for (const auto& term : terms)
+    {
+        ss << '\n' << term;
+    }
+    return ss.str();
+}
+
+} // end namespace perspective
@@ -0,0 +1,550 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/column.h>
+#include <perspective/filter_eval.h>
+#include <perspective/vocab.h>
+#include <cstring>
+
+namespace perspective
+{
+
+namespace
+{
+
+typedef std::vector<t_uint64> t_words;
+
+const t_uindex WORD_BITS = 64;
+
+// Words of rows a block, terms stop being evaluated on a block once all of
+// its rows are decided.
+const t_uindex BLOCK_WORDS = 64;
+
+// Bits of the rows of word widx below nrows
+inline t_uint64
+word_rows(t_uindex widx, t_uindex nrows)
+{
+    t_uindex nbits = std::min(WORD_BITS, nrows - widx * WORD_BITS);
+    return nbits == WORD_BITS ? ~t_uint64(0) : (t_uint64(1) << nbits) - 1;
+}
+
+// Equality the way t_tscalar::operator== sees it, on the value bits, so
+// equal NaNs match and 0.0 and -0.0 don't.
+template <typename DATA_T>
+inline bool
+raw_eq(DATA_T a, DATA_T b)
+{
+    return a == b;
+}
+
+template <>
+inline bool
+raw_eq<t_float64>(t_float64 a, t_float64 b)
+{
+    t_uint64 abits;
+    t_uint64 bbits;
+    std::memcpy(&abits, &a, sizeof(a));
+    std::memcpy(&bbits, &b, sizeof(b));
+    return abits == bbits;
+}
+
+template <>
+inline bool
+raw_eq<t_float32>(t_float32 a, t_float32 b)
+{
+    t_uint32 abits;
+    t_uint32 bbits;
+    std::memcpy(&abits, &a, sizeof(a));
+    std::memcpy(&bbits, &b, sizeof(b));
+    return abits == bbits;
+}
+
+template <typename DATA_T>
+inline DATA_T
+raw_threshold(const t_tscalar& threshold)
+{
+    DATA_T rv;
+    std::memcpy(&rv, &threshold.m_data, sizeof(rv));
+    return rv;
+}
+
+class t_term_eval
+{
+public:
+    t_term_eval(const t_fterm& fterm, const t_column* column, t_bool is_and,
+        t_uindex nrows);
+
+    // Combines the term into the words of acc listed in live
+    void operator()(const std::vector<t_uindex>& live, t_words& acc) const;
+
+private:
+    enum t_kind
+    {
+        KIND_SCALAR,
+        KIND_TYPED,
+        KIND_VOCAB
+    };
+
+    t_bool is_typed_dtype(t_dtype dtype) const;
+
+    void init_vocab();
+    void set_vocab_id(const t_tscalar& value);
+
+    void eval_vocab(const std::vector<t_uindex>& live, t_words& acc) const;
+
+    template <typename DATA_T>
+    void eval_typed(const std::vector<t_uindex>& live, t_words& acc) const;
+
+    template <typename PRED_T>
+    void eval_words(
+        const std::vector<t_uindex>& live, t_words& acc, PRED_T pred) const;
+
+    void eval_scalar(const std::vector<t_uindex>& live, t_words& acc) const;
+
+    t_bool eval_row(t_uindex ridx) const;
+
+    const t_fterm& m_fterm;
+    const t_column* m_column;
+    t_bool m_is_and;
+    t_uindex m_nrows;
+    t_kind m_kind;
+    const t_status* m_status;
+
+    // Bit id is set when the string of vocabulary id passes the term
+    t_words m_vocab_ids;
+};
+
+t_term_eval::t_term_eval(const t_fterm& fterm, const t_column* column,
+    t_bool is_and, t_uindex nrows)
+    : m_fterm(fterm)
+    , m_column(column)
+    , m_is_and(is_and)
+    , m_nrows(nrows)
+    , m_kind(KIND_SCALAR)
+    , m_status(0)
+{
+    t_dtype dtype = m_column->get_dtype();
+
+    if (m_column->is_status_enabled() && nrows > 0)
+        m_status = m_column->get_nth_status(0);
+
+    if (dtype == DTYPE_STR)
+    {
+        init_vocab();
+        return;
+    }
+
+    const t_tscalar& thr = m_fterm.m_threshold;
+
+    switch (m_fterm.m_op)
+    {
+        case FILTER_OP_LT:
+        case FILTER_OP_LTEQ:
+        case FILTER_OP_GT:
+        case FILTER_OP_GTEQ:
+        case FILTER_OP_EQ:
+        case FILTER_OP_NE:
+        {
+            if (is_typed_dtype(dtype) && thr.get_dtype() == dtype
+                && thr.is_valid())
+            {
+                m_kind = KIND_TYPED;
+            }
+        }
+        break;
+        default:
+            break;
+    }
+}
+
+t_bool
+t_term_eval::is_typed_dtype(t_dtype dtype) const
+{
+    switch (dtype)
+    {
+        case DTYPE_INT64:
+        case DTYPE_INT32:
+        case DTYPE_INT16:
+        case DTYPE_INT8:
+        case DTYPE_UINT64:
+        case DTYPE_UINT32:
+        case DTYPE_UINT16:
+        case DTYPE_UINT8:
+        case DTYPE_FLOAT64:
+        case DTYPE_FLOAT32:
+        case DTYPE_BOOL:
+        case DTYPE_DATE:
+        case DTYPE_TIME:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void
+t_term_eval::init_vocab()
+{
+    const t_vocab* vocab = m_column->_get_vocab();
+    t_uindex nids = vocab->get_vlenidx();
+    const t_tscalar& thr = m_fterm.m_threshold;
+
+    switch (m_fterm.m_op)
+    {
+        case FILTER_OP_EQ:
+        case FILTER_OP_NE:
+        {
+            m_vocab_ids.assign((nids + WORD_BITS - 1) / WORD_BITS, 0);
+            set_vocab_id(thr);
+        }
+        break;
+        case FILTER_OP_IN:
+        case FILTER_OP_NOT_IN:
+        {
+            m_vocab_ids.assign((nids + WORD_BITS - 1) / WORD_BITS, 0);
+            for (const auto& value : m_fterm.m_bag)
+            {
+                set_vocab_id(value);
+            }
+        }
+        break;
+        case FILTER_OP_LT:
+        case FILTER_OP_LTEQ:
+        case FILTER_OP_GT:
+        case FILTER_OP_GTEQ:
+        case FILTER_OP_BEGINS_WITH:
+        case FILTER_OP_ENDS_WITH:
+        case FILTER_OP_CONTAINS:
+        {
+            // Only worth it when there are fewer strings than rows to test
+            if (nids > m_nrows)
+                return;
+
+            m_vocab_ids.assign((nids + WORD_BITS - 1) / WORD_BITS, 0);
+            t_tscalar value;
+            for (t_uindex id = 0; id < nids; ++id)
+            {
+                value.set(vocab->unintern_c(id));
+                if (m_fterm(value))
+                    m_vocab_ids[id / WORD_BITS] |= t_uint64(1)
+                        << (id % WORD_BITS);
+            }
+            m_kind = KIND_VOCAB;
+            return;
+        }
+        break;
+        default:
+            return;
+    }
+
+    // Equality matches the ids looked up above, so the rest of the
+    // vocabulary passes for NE and NOT_IN and negation flips every id.
+    t_bool invert = m_fterm.m_op == FILTER_OP_NE
+        || m_fterm.m_op == FILTER_OP_NOT_IN;
+    if (invert != m_fterm.m_negated)
+    {
+        for (auto& word : m_vocab_ids)
+        {
+            word = ~word;
+        }
+    }
+    m_kind = KIND_VOCAB;
+}
+
+void
+t_term_eval::set_vocab_id(const t_tscalar& value)
+{
+    // Scalars that aren't valid strings never equal a valid string row
+    t_stridx id;
+    if (value.get_dtype() != DTYPE_STR || !value.is_valid()
+        || !m_column->_get_vocab()->string_exists(value.get_char_ptr(), id))
+        return;
+    m_vocab_ids[id / WORD_BITS] |= t_uint64(1) << (id % WORD_BITS);
+}
+
+void
+t_term_eval::operator()(const std::vector<t_uindex>& live, t_words& acc) const
+{
+    switch (m_kind)
+    {
+        case KIND_VOCAB:
+        {
+            eval_vocab(live, acc);
+        }
+        break;
+        case KIND_TYPED:
+        {
+            switch (m_column->get_dtype())
+            {
+                case DTYPE_INT64:
+                case DTYPE_TIME:
+                    eval_typed<t_int64>(live, acc);
+                    break;
+                case DTYPE_INT32:
+                    eval_typed<t_int32>(live, acc);
+                    break;
+                case DTYPE_INT16:
+                    eval_typed<t_int16>(live, acc);
+                    break;
+                case DTYPE_INT8:
+                    eval_typed<t_int8>(live, acc);
+                    break;
+                case DTYPE_UINT64:
+                    eval_typed<t_uint64>(live, acc);
+                    break;
+                case DTYPE_UINT32:
+                case DTYPE_DATE:
+                    eval_typed<t_uint32>(live, acc);
+                    break;
+                case DTYPE_UINT16:
+                    eval_typed<t_uint16>(live, acc);
+                    break;
+                case DTYPE_UINT8:
+                    eval_typed<t_uint8>(live, acc);
+                    break;
+                case DTYPE_FLOAT64:
+                    eval_typed<t_float64>(live, acc);
+                    break;
+                case DTYPE_FLOAT32:
+                    eval_typed<t_float32>(live, acc);
+                    break;
+                case DTYPE_BOOL:
+                    eval_typed<t_bool>(live, acc);
+                    break;
+                default:
+                    PSP_COMPLAIN_AND_ABORT("Unexpected dtype");
+            }
+        }
+        break;
+        default:
+        {
+            eval_scalar(live, acc);
+        }
+    }
+}
+
+template <typename DATA_T>
+void
+t_term_eval::eval_typed(const std::vector<t_uindex>& live, t_words& acc) const
+{
+    const DATA_T* data = m_column->get_nth<DATA_T>(0);
+    DATA_T thr = raw_threshold<DATA_T>(m_fterm.m_threshold);
+
+    switch (m_fterm.m_op)
+    {
+        case FILTER_OP_LT:
+        {
+            eval_words(live, acc,
+                [data, thr](t_uindex ridx) { return data[ridx] < thr; });
+        }
+        break;
+        case FILTER_OP_LTEQ:
+        {
+            eval_words(live, acc, [data, thr](t_uindex ridx) {
+                return data[ridx] < thr || raw_eq(data[ridx], thr);
+            });
+        }
+        break;
+        case FILTER_OP_GT:
+        {
+            eval_words(live, acc,
+                [data, thr](t_uindex ridx) { return data[ridx] > thr; });
+        }
+        break;
+        case FILTER_OP_GTEQ:
+        {
+            eval_words(live, acc, [data, thr](t_uindex ridx) {
+                return data[ridx] > thr || raw_eq(data[ridx], thr);
+            });
+        }
+        break;
+        case FILTER_OP_EQ:
+        {
+            eval_words(live, acc,
+                [data, thr](t_uindex ridx) { return raw_eq(data[ridx], thr); });
+        }
+        break;
+        case FILTER_OP_NE:
+        {
+            eval_words(live, acc, [data, thr](t_uindex ridx) {
+                return !raw_eq(data[ridx], thr);
+            });
+        }
+        break;
+        default:
+        {
+            PSP_COMPLAIN_AND_ABORT("Unexpected filter op");
+        }
+    }
+}
+
+template <typename PRED_T>
+void
+t_term_eval::eval_words(
+    const std::vector<t_uindex>& live, t_words& acc, PRED_T pred) const
+{
+    for (auto widx : live)
+    {
+        t_uindex base = widx * WORD_BITS;
+        t_uindex nbits = std::min(WORD_BITS, m_nrows - base);
+        t_uint64 bits = 0;
+
+        // Branch free so the compiler can vectorize the comparisons
+        for (t_uindex idx = 0; idx < nbits; ++idx)
+        {
+            bits |= t_uint64(pred(base + idx)) << idx;
+        }
+
+        if (m_fterm.m_negated && m_kind == KIND_TYPED)
+            bits = ~bits & word_rows(widx, m_nrows);
+
+        // Rows that aren't valid compare on their status, leave them to
+        // t_fterm
+        if (m_status)
+        {
+            for (t_uindex idx = 0; idx < nbits; ++idx)
+            {
+                if (m_status[base + idx] == STATUS_VALID)
+                    continue;
+
+                t_uint64 bit = t_uint64(1) << idx;
+                bits = eval_row(base + idx) ? bits | bit : bits & ~bit;
+            }
+        }
+
+        if (m_is_and)
+            acc[widx] &= bits;
+        else
+            acc[widx] |= bits;
+    }
+}
+
+void
+t_term_eval::eval_vocab(const std::vector<t_uindex>& live, t_words& acc) const
+{
+    const t_stridx* data = m_column->get_nth<t_stridx>(0);
+    const t_uint64* ids = m_vocab_ids.data();
+
+    // Negation is already folded into the ids
+    eval_words(live, acc, [data, ids](t_uindex ridx) {
+        t_stridx id = data[ridx];
+        return (ids[id / WORD_BITS] >> (id % WORD_BITS)) & 1;
+    });
+}
+
+void
+t_term_eval::eval_scalar(const std::vector<t_uindex>& live, t_words& acc) const
+{
+    for (auto widx : live)
+    {
+        t_uindex base = widx * WORD_BITS;
+        t_uint64 todo
+            = m_is_and ? acc[widx] : ~acc[widx] & word_rows(widx, m_nrows);
+        t_uint64 bits = 0;
+
+        for (t_uindex idx = 0; todo != 0; ++idx, todo >>= 1)
+        {
+            if ((todo & 1) && eval_row(base + idx))
+                bits |= t_uint64(1) << idx;
+        }
+
+        if (m_is_and)
+            acc[widx] &= bits;
+        else
+            acc[widx] |= bits;
+    }
+}
+
+t_bool
+t_term_eval::eval_row(t_uindex ridx) const
+{
+    t_tscalar cell_val = m_column->get_scalar(ridx);
+    t_bool tval = m_fterm(cell_val);
+    return m_is_and ? cell_val.is_valid() && tval : tval;
+}
+
+} // namespace
+
+t_masksptr
+filter_columns(t_filter_op combiner, const t_ftermvec& fterms,
+    const t_colcptrvec& columns, t_uindex nrows, const t_mask* select)
+{
+    if (combiner != FILTER_OP_AND && combiner != FILTER_OP_OR)
+    {
+        PSP_COMPLAIN_AND_ABORT("Unknown filter op");
+    }
+
+    if (nrows == 0)
+        return std::make_shared<t_mask>(0);
+
+    t_bool is_and = combiner == FILTER_OP_AND;
+    t_uindex nwords = (nrows + WORD_BITS - 1) / WORD_BITS;
+
+    std::vector<t_term_eval> terms;
+    terms.reserve(fterms.size());
+    for (t_uindex idx = 0, loop_end = fterms.size(); idx < loop_end; ++idx)
+    {
+        terms.emplace_back(fterms[idx], columns[idx], is_and, nrows);
+    }
+
+    t_words selected;
+    if (select)
+    {
+        selected = select->get_words();
+        selected.resize(nwords);
+    }
+
+    t_words acc(nwords);
+    std::vector<t_uindex> live;
+    live.reserve(BLOCK_WORDS);
+
+    for (t_uindex bword = 0; bword < nwords; bword += BLOCK_WORDS)
+    {
+        t_uindex eword = std::min(bword + BLOCK_WORDS, nwords);
+
+        // Rows that aren't selected start out decided, failing under AND
+        // and passing under OR until they are cleared below.
+        for (t_uindex widx = bword; widx < eword; ++widx)
+        {
+            t_uint64 rows = word_rows(widx, nrows);
+            t_uint64 sel = select ? selected[widx] & rows : rows;
+            acc[widx] = is_and ? sel : rows & ~sel;
+        }
+
+        for (const auto& term : terms)
+        {
+            live.clear();
+            for (t_uindex widx = bword; widx < eword; ++widx)
+            {
+                t_bool decided = is_and ? acc[widx] == 0
+                                        : acc[widx] == word_rows(widx, nrows);
+                if (!decided)
+                    live.push_back(widx);
+            }
+
+            if (live.empty())
+                break;
+
+            term(live, acc);
+        }
+
+        if (select && !is_and)
+        {
+            for (t_uindex widx = bword; widx < eword; ++widx)
+            {
+                acc[widx] &= selected[widx];
+            }
+        }
+    }
+
+    return std::make_shared<t_mask>(acc, nrows);
+}
+
+} // end namespace perspective
@@ -10,12 +10,11 @@
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/config.h>
+#include <perspective/env_vars.h>
 #include <perspective/flat_traversal.h>
+#include <perspective/parallel.h>
 #include <perspective/scalar.h>
 #include <perspective/schema.h>
-#ifdef PSP_PARALLEL_FOR
-#include <tbb/parallel_sort.h>
-#endif
 
 namespace perspective
 {
@@ -23,15 +22,19 @@ namespace perspective
 t_ftrav::t_ftrav(t_bool handle_nan_sort)
     : m_step_deletes(0)
     , m_step_inserts(0)
+    , m_sorted_end(0)
+    , m_window(0)
     , m_handle_nan_sort(handle_nan_sort)
 {
-    m_index = std::make_shared<t_mselemvec>();
+    m_keys.init(get_sort_orders(m_sortby), m_handle_nan_sort);
 }
 
 void
 t_ftrav::init()
 {
-    m_index = std::make_shared<t_mselemvec>();
+    m_index.clear();
+    m_sorted_end = 0;
+    m_keys.init(get_sort_orders(m_sortby), m_handle_nan_sort);
 }
 
 t_tscalvec
@@ -41,10 +44,10 @@ t_ftrav::get_all_pkeys(const std::vector<t_uidxpair>& cells) const
     // cells
     t_tscalvec rval;
     rval.reserve(cells.size());
-    t_mselemvec* index = m_index.get();
     for (auto iter = cells.begin(); iter != cells.end(); ++iter)
     {
-        rval.push_back((*index)[iter->first].m_pkey);
+        sort_window(iter->first + 1);
+        rval.push_back(m_keys.get_pkey(m_index[iter->first]));
     }
     return rval;
 }
@@ -61,12 +64,15 @@ t_ftrav::get_pkeys(const std::vector<t_uidxpair>& cells) const
         all_rows.insert(cells[idx].first);
     }
 
+    if (!all_rows.empty())
+        sort_window(*all_rows.rbegin() + 1);
+
     t_tscalvec rval(all_rows.size());
     std::set<t_tvidx>::iterator it;
     t_index count = 0;
     for (it = all_rows.begin(); it != all_rows.end(); ++it)
     {
-        rval[count] = (*m_index)[*it].m_pkey;
+        rval[count] = m_keys.get_pkey(m_index[*it]);
         ++count;
     }
     return rval;
@@ -75,12 +81,13 @@ t_ftrav::get_pkeys(const std::vector<t_uidxpair>& cells) const
 t_tscalvec
 t_ftrav::get_pkeys(t_tvidx begin_row, t_tvidx end_row) const
 {
-    t_tvidx index_size = m_index->size();
+    t_tvidx index_size = m_index.size();
     end_row = std::min(end_row, index_size);
+    sort_window(end_row);
     t_tscalvec rval(end_row - begin_row);
     for (t_tvidx ridx = begin_row; ridx < end_row; ++ridx)
     {
-        rval[ridx - begin_row] = (*m_index)[ridx].m_pkey;
+        rval[ridx - begin_row] = m_keys.get_pkey(m_index[ridx]);
     }
     return rval;
 }
@@ -91,43 +98,109 @@ t_ftrav::get_pkeys() const
     return get_pkeys(0, size());
 }
 
+t_tscalvec
+t_ftrav::get_pkeys_unordered() const
+{
+    t_tscalvec rval(m_index.size());
+    for (t_uindex idx = 0, loop_end = m_index.size(); idx < loop_end; ++idx)
+    {
+        rval[idx] = m_keys.get_pkey(m_index[idx]);
+    }
+    return rval;
+}
+
 t_tscalar
 t_ftrav::get_pkey(t_tvidx idx) const
 {
-    return (*m_index)[idx].m_pkey;
+    sort_window(idx + 1);
+    return m_keys.get_pkey(m_index[idx]);
+}
+
+void
+t_ftrav::reindex(t_index idx) const
+{
+    m_pkeyidx[m_keys.get_pkey(m_index[idx])] = idx;
 }
 
 void
-t_ftrav::fill_sort_elem(t_gstate_csptr state, const t_config& config,
-    t_tscalar pkey, t_mselem& out_elem)
+t_ftrav::sort_window(t_index end) const
 {
-    out_elem.m_pkey = pkey;
-    t_index sortby_size = m_sortby.size();
-    out_elem.m_row.reserve(sortby_size);
-    for (t_index idx = 0; idx < sortby_size; ++idx)
+    t_index size = m_index.size();
+    end = std::min(end, size);
+    if (end <= m_sorted_end)
+        return;
+
+    if (m_window > 0)
     {
-        t_index sortby_idx = m_sortby[idx].m_agg_index;
-        const t_str& colname = config.col_at(sortby_idx);
-        const t_str sortby_colname = config.get_sort_by(colname);
-        out_elem.m_row.push_back(
-            m_symtable.get_interned_tscalar(state->get(pkey, sortby_colname)));
+        end = std::min(
+            size, std::max<t_index>(end, m_sorted_end + m_window));
+    }
+
+    auto sorter
+        = [this](t_uindex a, t_uindex b) { return m_keys.less(a, b); };
+
+    auto begin = m_index.begin() + m_sorted_end;
+    if (end < size)
+    {
+        std::nth_element(begin, m_index.begin() + end, m_index.end(), sorter);
+    }
+    parallel_sort(begin, m_index.begin() + end, sorter);
+
+    for (t_index idx = m_sorted_end; idx < size; ++idx)
+    {
+        reindex(idx);
+    }
+
+    m_sorted_end = end;
+}
+
+void
+t_ftrav::set_sort_window(t_uindex nrows)
+{
+    m_window = nrows;
+
+    if (m_window == 0)
+    {
+        sort_window(size());
+    }
+    else
+    {
+        m_sorted_end = std::min<t_index>(m_sorted_end, m_window);
     }
 }
 
+t_uindex
+t_ftrav::get_sort_window() const
+{
+    return m_window;
+}
+
+std::vector<t_col_csptr>
+t_ftrav::get_sort_columns(t_gstate_csptr state, const t_config& config) const
+{
+    auto tbl = state->get_table();
+    std::vector<t_col_csptr> rval;
+    rval.reserve(m_sortby.size());
+    for (const auto& sort : m_sortby)
+    {
+        const t_str& colname = config.col_at(sort.m_agg_index);
+        rval.push_back(tbl->get_const_column(config.get_sort_by(colname)));
+    }
+    return rval;
+}
+
 void
-t_ftrav::fill_sort_elem(t_gstate_csptr state, const t_config& config,
-    const t_tscalvec& row, t_mselem& out_elem) const
+t_ftrav::fill_slot(const std::vector<t_col_csptr>& columns,
+    const t_rlookup& lookup, t_uindex slot)
 {
-    out_elem.m_pkey = mknone();
-    t_index sortby_size = m_sortby.size();
-    out_elem.m_row.reserve(sortby_size);
-    for (t_index idx = 0; idx < sortby_size; ++idx)
+    for (t_uindex cidx = 0, loop_end = columns.size(); cidx < loop_end;
+         ++cidx)
     {
-        t_index sortby_idx = m_sortby[idx].m_agg_index;
-        const t_str& colname = config.col_at(sortby_idx);
-        const t_str sortby_colname = config.get_sort_by(colname);
-        out_elem.m_row.push_back(
-            get_interned_tscalar(row.at(config.get_colidx(sortby_colname))));
+        t_tscalar key = lookup.m_exists
+            ? m_symtable.get_interned_tscalar(
+                  columns[cidx]->get_scalar(lookup.m_idx))
+            : mknone();
+        m_keys.set_key(cidx, slot, key);
     }
 }
 
@@ -137,39 +210,95 @@ t_ftrav::sort_by(
 {
     if (sortby.empty())
         return;
-    t_multisorter sorter(get_sort_orders(sortby), m_handle_nan_sort);
-    t_index size = m_index->size();
-    auto sort_elems = std::make_shared<t_mselemvec>(static_cast<size_t>(size));
+
+    // Rows deleted or queued in the current step are carried over to the
+    // new keys.
+    t_tscalvec deleted;
+    for (auto didx : m_step_dirty)
+    {
+        deleted.push_back(m_keys.get_pkey(m_index[didx]));
+    }
+
+    t_tscalvec pkeys = get_pkeys_unordered();
+    t_index size = pkeys.size();
+    for (const auto& pkelem : m_new_elems)
+    {
+        pkeys.push_back(pkelem.first);
+    }
+
     m_sortby = sortby;
+    auto columns = get_sort_columns(state, config);
+
+    std::vector<t_dtype> dtypes;
+    if (!t_env::backout_sort_byte_keys())
+    {
+        for (const auto& col : columns)
+        {
+            dtypes.push_back(col->get_dtype());
+        }
+    }
+
+    m_keys.init(get_sort_orders(sortby), m_handle_nan_sort, dtypes);
 
+    // Each pkey is looked up once, the keys are then gathered a column at
+    // a time.
+    std::vector<t_rlookup> lookups(pkeys.size());
+    for (t_uindex idx = 0, loop_end = pkeys.size(); idx < loop_end; ++idx)
+    {
+        m_keys.alloc(pkeys[idx]);
+        lookups[idx] = state->lookup(pkeys[idx]);
+    }
+
+    for (t_uindex cidx = 0, loop_end = columns.size(); cidx < loop_end;
+         ++cidx)
+    {
+        const t_column* col = columns[cidx].get();
+        for (t_uindex idx = 0, nkeys = pkeys.size(); idx < nkeys; ++idx)
+        {
+            const t_rlookup& lookup = lookups[idx];
+            t_tscalar key = lookup.m_exists
+                ? m_symtable.get_interned_tscalar(col->get_scalar(lookup.m_idx))
+                : mknone();
+            m_keys.set_key(cidx, idx, key);
+        }
+    }
+
+    for (t_uindex idx = size, loop_end = pkeys.size(); idx < loop_end; ++idx)
+    {
+        m_new_elems[pkeys[idx]] = idx;
+    }
+
+    m_index.resize(size);
     for (t_index idx = 0; idx < size; ++idx)
     {
-        t_mselem& elem = (*sort_elems)[idx];
-        t_tscalar pkey = (*m_index)[idx].m_pkey;
-        fill_sort_elem(state, config, pkey, elem);
+        m_index[idx] = idx;
     }
 
-    std::swap(m_index, sort_elems);
-    std::sort(m_index->begin(), m_index->end(), sorter);
     m_pkeyidx.clear();
-    for (t_index idx = 0, loop_end = m_index->size(); idx < loop_end; ++idx)
+    m_sorted_end = 0;
+    sort_window(m_window > 0 ? m_window : size);
+
+    m_step_dirty.clear();
+    for (const auto& pkey : deleted)
     {
-        m_pkeyidx[(*m_index)[idx].m_pkey] = idx;
+        m_step_dirty.push_back(m_pkeyidx[pkey]);
     }
 }
 
 t_index
 t_ftrav::size() const
 {
-    return m_index->size();
+    return m_index.size();
 }
 
 void
 t_ftrav::get_row_indices(const t_tscalset& pkeys, t_tscaltvimap& out_map) const
 {
+    sort_window(size());
+
     for (t_tvidx idx = 0, loop_end = size(); idx < loop_end; ++idx)
     {
-        const t_tscalar& pkey = (*m_index)[idx].m_pkey;
+        const t_tscalar& pkey = m_keys.get_pkey(m_index[idx]);
         if (pkeys.find(pkey) != pkeys.end())
         {
             out_map[pkey] = idx;
@@ -181,9 +310,11 @@ void
 t_ftrav::get_row_indices(t_tvidx bidx, t_tvidx eidx, const t_tscalset& pkeys,
     t_tscaltvimap& out_map) const
 {
+    sort_window(eidx);
+
     for (t_tvidx idx = bidx; idx < eidx; ++idx)
     {
-        const t_tscalar& pkey = (*m_index)[idx].m_pkey;
+        const t_tscalar& pkey = m_keys.get_pkey(m_index[idx]);
         if (pkeys.find(pkey) != pkeys.end())
         {
             out_map[pkey] = idx;
@@ -194,24 +325,28 @@ t_ftrav::get_row_indices(t_tvidx bidx, t_tvidx eidx, const t_tscalset& pkeys,
 void
 t_ftrav::reset()
 {
-    if (m_index.get())
-        m_index->clear();
+    m_index.clear();
+    m_sorted_end = 0;
+    m_keys.clear();
+    m_pkeyidx.clear();
+    m_new_elems.clear();
+    m_step_dirty.clear();
 }
 
 void
 t_ftrav::check_size()
 {
     t_tscalset pkey_set;
-    for (t_index idx = 0, loop_end = m_index->size(); idx < loop_end; ++idx)
+    for (t_index idx = 0, loop_end = m_index.size(); idx < loop_end; ++idx)
     {
-        if (pkey_set.find((*m_index)[idx].m_pkey) != pkey_set.end())
+        t_tscalar pkey = m_keys.get_pkey(m_index[idx]);
+        if (pkey_set.find(pkey) != pkey_set.end())
         {
-            std::cout << "Duplicate entry for " << (*m_index)[idx].m_pkey
-                      << std::endl;
+            std::cout << "Duplicate entry for " << pkey << std::endl;
             PSP_COMPLAIN_AND_ABORT("Exiting");
         }
 
-        pkey_set.insert((*m_index)[idx].m_pkey);
+        pkey_set.insert(pkey);
     }
 }
 
@@ -232,66 +367,324 @@ t_ftrav::validate_cells(const std::vector<t_uidxpair>& cells) const
 void
 t_ftrav::step_begin()
 {
-    m_step_deletes = 0;
-    m_step_inserts = 0;
-    m_new_elems.clear();
+    reset_step_state();
 }
 
 void
 t_ftrav::step_end()
 {
-    t_index new_size = m_index->size() + m_step_inserts - m_step_deletes;
+    // The index is still ordered on the keys it held before the step:
+    // updated rows only left a dirty position behind and their new sort
+    // keys in a slot of m_new_elems. The changed rows are sorted on their
+    // own and merged back in.
+    auto sorter
+        = [this](t_uindex a, t_uindex b) { return m_keys.less(a, b); };
+
+    std::vector<t_index> dirty;
+    std::swap(dirty, m_step_dirty);
+
+    std::vector<t_uindex> changes;
+    changes.reserve(m_new_elems.size());
+
+    for (auto& pkelem : m_new_elems)
+    {
+        auto pkiter = m_pkeyidx.find(pkelem.first);
+        if (pkiter != m_pkeyidx.end())
+            dirty.push_back(pkiter->second);
+        changes.push_back(pkelem.second);
+    }
+
+    m_new_elems.clear();
+
+    if (dirty.empty() && changes.empty())
+        return;
+
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    parallel_sort(changes.begin(), changes.end(), sorter);
+
+    if (m_window > 0)
+    {
+        merge_window(dirty, changes);
+    }
+    else
+    {
+        merge_sorted(dirty, changes);
+    }
+}
+
+void
+t_ftrav::merge_sorted(
+    const std::vector<t_index>& dirty, std::vector<t_uindex>& changes)
+{
+    // Only the span of the index the changes can affect is merged, rows
+    // after it are only reindexed if the index grew or shrank.
+    auto sorter
+        = [this](t_uindex a, t_uindex b) { return m_keys.less(a, b); };
+    std::vector<t_uindex>& index = m_index;
+
+    t_index lo = index.size();
+    t_index hi = 0;
+
+    if (!dirty.empty())
+    {
+        lo = dirty.front();
+        hi = dirty.back() + 1;
+    }
+
+    if (!changes.empty())
+    {
+        auto first = std::upper_bound(
+            index.begin(), index.end(), changes.front(), sorter);
+        auto last = std::upper_bound(
+            index.begin(), index.end(), changes.back(), sorter);
+        lo = std::min<t_index>(lo, std::distance(index.begin(), first));
+        hi = std::max<t_index>(hi, std::distance(index.begin(), last));
+    }
+
+    // Updated rows get their pkeys back when the merged span is reindexed
+    for (auto didx : dirty)
+    {
+        m_pkeyidx.erase(m_keys.get_pkey(index[didx]));
+        m_keys.release(index[didx]);
+    }
+
+    std::vector<t_uindex> merged;
+    merged.reserve(hi - lo - dirty.size() + changes.size());
+
+    auto diter = dirty.begin();
+    auto citer = changes.begin();
+
+    for (t_index idx = lo; idx < hi; ++idx)
+    {
+        if (diter != dirty.end() && *diter == idx)
+        {
+            ++diter;
+            continue;
+        }
+
+        t_uindex elem = index[idx];
+        while (citer != changes.end() && sorter(*citer, elem))
+        {
+            merged.push_back(*citer);
+            ++citer;
+        }
+        merged.push_back(elem);
+    }
+
+    for (; citer != changes.end(); ++citer)
+    {
+        merged.push_back(*citer);
+    }
+
+    t_index old_span = hi - lo;
+    t_index new_span = merged.size();
+
+    if (new_span > old_span)
+    {
+        index.insert(index.begin() + hi, new_span - old_span, 0);
+    }
+    else if (new_span < old_span)
+    {
+        index.erase(index.begin() + lo + new_span, index.begin() + hi);
+    }
+
+    std::copy(merged.begin(), merged.end(), index.begin() + lo);
+
+    t_index reindex_end
+        = new_span == old_span ? lo + new_span : t_index(index.size());
+
+    for (t_index idx = lo; idx < reindex_end; ++idx)
+    {
+        m_pkeyidx[m_keys.get_pkey(index[idx])] = idx;
+    }
+
+    m_sorted_end = index.size();
+}
+
+void
+t_ftrav::merge_window(
+    const std::vector<t_index>& dirty, std::vector<t_uindex>& changes)
+{
+    auto sorter
+        = [this](t_uindex a, t_uindex b) { return m_keys.less(a, b); };
+    std::vector<t_uindex>& index = m_index;
+    t_index nsorted = m_sorted_end;
+
+    // The old keys of the last sorted row still bound the rows left in the
+    // sorted window from above and the unordered tail from below. Changes
+    // up to it are merged into the window, the others join the tail.
+    auto csplit = changes.begin();
+    if (nsorted > 0)
+    {
+        csplit = std::upper_bound(
+            changes.begin(), changes.end(), index[nsorted - 1], sorter);
+    }
+
+    auto dsplit = std::lower_bound(dirty.begin(), dirty.end(), nsorted);
+
+    for (auto didx : dirty)
+    {
+        m_pkeyidx.erase(m_keys.get_pkey(index[didx]));
+        m_keys.release(index[didx]);
+    }
+
+    // Tail positions whose rows changed place
+    std::vector<t_index> moved;
 
-    auto new_index = std::make_shared<t_mselemvec>();
-    new_index->reserve(new_size);
+    // Tail changes take the holes left by dirty tail rows, then go at the
+    // end. Holes left over are filled from the end, highest first.
+    auto hole = dsplit;
+    auto citer = csplit;
+
+    for (; citer != changes.end() && hole != dirty.end(); ++citer, ++hole)
+    {
+        index[*hole] = *citer;
+        moved.push_back(*hole);
+    }
 
-    t_pkeyidx_map added;
+    for (; citer != changes.end(); ++citer)
+    {
+        index.push_back(*citer);
+        moved.push_back(index.size() - 1);
+    }
 
-    for (t_index idx = 0, loop_end = m_index->size(); idx < loop_end; ++idx)
+    for (auto hiter = dirty.end(); hiter != hole;)
     {
-        t_mselem& elem = (*m_index)[idx];
-        if (!elem.m_deleted)
+        --hiter;
+        t_index last = index.size() - 1;
+        if (*hiter != last)
         {
-            new_index->push_back(elem);
-            added[elem.m_pkey] = idx;
+            index[*hiter] = index[last];
+            moved.push_back(*hiter);
         }
+        index.pop_back();
     }
 
-    for (t_pkmselem_map::const_iterator pkelem_iter = m_new_elems.begin();
-         pkelem_iter != m_new_elems.end(); ++pkelem_iter)
+    t_index nmerged = nsorted;
+
+    if (dsplit != dirty.begin() || csplit != changes.begin())
     {
+        std::vector<t_uindex> merged;
+        merged.reserve(nsorted + (csplit - changes.begin()));
 
-        const t_mselem& elem = pkelem_iter->second;
-        t_pkeyidx_map::const_iterator iter = added.find(pkelem_iter->first);
-        if (iter == added.end())
+        auto diter = dirty.begin();
+        citer = changes.begin();
+
+        for (t_index idx = 0; idx < nsorted; ++idx)
         {
-            new_index->push_back(elem);
+            if (diter != dsplit && *diter == idx)
+            {
+                ++diter;
+                continue;
+            }
+
+            t_uindex elem = index[idx];
+            while (citer != csplit && sorter(*citer, elem))
+            {
+                merged.push_back(*citer);
+                ++citer;
+            }
+            merged.push_back(elem);
         }
-        else
+
+        for (; citer != csplit; ++citer)
         {
-            (*new_index)[iter->second] = elem;
+            merged.push_back(*citer);
+        }
+
+        // The tail is unordered, so resizing the window only moves as
+        // many tail rows as it grew or shrank by.
+        nmerged = merged.size();
+        t_index size = index.size();
+
+        if (nmerged > nsorted)
+        {
+            t_index ngrow = nmerged - nsorted;
+            if (size - nsorted <= ngrow)
+            {
+                std::vector<t_uindex> tail(
+                    index.begin() + nsorted, index.end());
+                index.resize(nmerged);
+                index.insert(index.end(), tail.begin(), tail.end());
+                for (t_index idx = nmerged; idx < t_index(index.size()); ++idx)
+                {
+                    moved.push_back(idx);
+                }
+            }
+            else
+            {
+                for (t_index idx = nsorted; idx < nmerged; ++idx)
+                {
+                    index.push_back(index[idx]);
+                    moved.push_back(index.size() - 1);
+                }
+            }
+        }
+        else if (nmerged < nsorted)
+        {
+            t_index nshrink = nsorted - nmerged;
+            t_index nmove = std::min(nshrink, size - nsorted);
+            for (t_index idx = 0; idx < nmove; ++idx)
+            {
+                index[nmerged + idx] = index[size - 1 - idx];
+                moved.push_back(nmerged + idx);
+            }
+            index.resize(size - nshrink);
+        }
+
+        std::copy(merged.begin(), merged.end(), index.begin());
+
+        for (t_index idx = 0; idx < nmerged; ++idx)
+        {
+            reindex(idx);
         }
     }
-    std::swap(new_index, m_index);
-    t_multisorter sorter(get_sort_orders(m_sortby), m_handle_nan_sort);
-    std::sort(m_index->begin(), m_index->end(), sorter);
 
-    m_pkeyidx.clear();
+    for (auto idx : moved)
+    {
+        if (idx >= nmerged && idx < t_index(index.size()))
+            reindex(idx);
+    }
 
-    m_new_elems.clear();
+    m_sorted_end = nmerged;
 
-    for (t_index idx = 0, loop_end = m_index->size(); idx < loop_end; ++idx)
+    // Keep the window between one and two windows of rows, refilling it
+    // from the tail when rows left it.
+    t_index target = std::min<t_index>(m_window, index.size());
+    if (m_sorted_end < target)
+    {
+        sort_window(target);
+    }
+    else if (m_sorted_end > t_index(2 * m_window))
     {
-        m_pkeyidx[(*m_index)[idx].m_pkey] = idx;
+        m_sorted_end = m_window;
     }
 }
 
+void
+t_ftrav::queue_row(
+    t_gstate_csptr state, const t_config& config, t_tscalar pkey)
+{
+    t_uindex slot;
+    auto iter = m_new_elems.find(pkey);
+    if (iter == m_new_elems.end())
+    {
+        slot = m_keys.alloc(pkey);
+        m_new_elems[pkey] = slot;
+    }
+    else
+    {
+        slot = iter->second;
+    }
+
+    fill_slot(get_sort_columns(state, config), state->lookup(pkey), slot);
+}
+
 void
 t_ftrav::add_row(t_gstate_csptr state, const t_config& config, t_tscalar pkey)
 {
-    t_mselem mselem;
-    fill_sort_elem(state, config, pkey, mselem);
-    m_new_elems[pkey] = mselem;
+    queue_row(state, config, pkey);
     ++m_step_inserts;
 }
 
@@ -307,9 +700,9 @@ t_ftrav::update_row(
         add_row(state, config, pkey);
         return;
     }
-    t_mselem mselem;
-    fill_sort_elem(state, config, pkey, mselem);
-    (*m_index)[pkiter->second] = mselem;
+    // Leave the indexed slot alone so the index stays sorted until
+    // step_end merges the new sort keys in.
+    queue_row(state, config, pkey);
 }
 
 void
@@ -318,8 +711,14 @@ t_ftrav::delete_row(t_tscalar pkey)
     t_pkeyidx_map::iterator pkiter = m_pkeyidx.find(pkey);
     if (pkiter == m_pkeyidx.end())
         return;
-    (*m_index)[pkiter->second].m_deleted = true;
-    m_new_elems.erase(pkey);
+    m_step_dirty.push_back(pkiter->second);
+
+    auto iter = m_new_elems.find(pkey);
+    if (iter != m_new_elems.end())
+    {
+        m_keys.release(iter->second);
+        m_new_elems.erase(iter);
+    }
     ++m_step_deletes;
 }
 
@@ -340,27 +739,43 @@ t_ftrav::reset_step_state()
 {
     m_step_deletes = 0;
     m_step_inserts = 0;
+    for (const auto& pkelem : m_new_elems)
+    {
+        m_keys.release(pkelem.second);
+    }
     m_new_elems.clear();
+    m_step_dirty.clear();
 }
 
 t_uindex
 t_ftrav::lower_bound_row_idx(
     t_gstate_csptr state, const t_config& config, const t_tscalvec& row) const
 {
-    t_multisorter sorter(get_sort_orders(m_sortby), m_handle_nan_sort);
-    t_mselem target_val;
+    t_tscalvec keys;
+    keys.reserve(m_sortby.size());
+    for (const auto& sort : m_sortby)
+    {
+        const t_str& colname = config.col_at(sort.m_agg_index);
+        const t_str sortby_colname = config.get_sort_by(colname);
+        keys.push_back(
+            get_interned_tscalar(row.at(config.get_colidx(sortby_colname))));
+    }
 
-    fill_sort_elem(state, config, row, target_val);
+    t_tscalar pkey = mknone();
+    sort_window(size());
 
-    auto iter = std::lower_bound(
-        m_index->begin(), m_index->end(), target_val, sorter);
+    auto iter = std::lower_bound(m_index.begin(), m_index.end(), keys,
+        [this, &pkey](t_uindex slot, const t_tscalvec& keys) {
+            return m_keys.less(slot, keys, pkey);
+        });
 
-    return std::distance(m_index->begin(), iter);
+    return std::distance(m_index.begin(), iter);
 }
 
 t_index
 t_ftrav::get_row_idx(t_tscalar pkey) const
 {
+    sort_window(size());
     auto pkiter = m_pkeyidx.find(pkey);
     if (pkiter == m_pkeyidx.end())
         return -1;
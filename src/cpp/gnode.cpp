@@ -16,7 +16,7 @@
 #include <perspective/gnode_state.h>
 #include <perspective/mask.h>
 #include <perspective/env_vars.h>
-#include <perspective/logtime.h>
+#include <perspective/trace.h>
 #include <perspective/utils.h>
 
 namespace perspective
@@ -54,7 +54,6 @@ t_gnode::t_gnode(const t_gnode_recipe& recipe)
         m_custom_columns.push_back(t_custom_column(cc));
     }
 
-    m_epoch = std::chrono::high_resolution_clock::now();
 
     for (const auto& ccol : m_custom_columns)
     {
@@ -103,7 +102,6 @@ t_gnode::t_gnode(const t_gnode_options& options)
     m_ischemas = t_schemavec{port_schema};
     m_oschemas = t_schemavec{port_schema, m_tblschema, m_tblschema, m_tblschema,
         trans_schema, existed_schema};
-    m_epoch = std::chrono::high_resolution_clock::now();
 }
 
 t_gnode_sptr
@@ -130,6 +128,8 @@ t_gnode::init()
 
     m_state = std::make_shared<t_gstate>(m_tblschema, m_ischemas[0]);
     m_state->init();
+    m_filter_cache = std::make_shared<t_filter_cache>();
+    m_strand_cache = std::make_shared<t_strand_cache>();
 
     for (t_uindex idx = 0, loop_end = m_ischemas.size(); idx < loop_end; ++idx)
     {
@@ -162,6 +162,7 @@ void
 t_gnode::_send_and_process(const t_table& fragments)
 {
     _send(0, fragments);
+    _swap_input_ports();
     _process();
 }
 
@@ -182,6 +183,34 @@ t_gnode::_send(t_uindex portid, const t_table& fragments)
     iport->send(fragments);
 }
 
+void
+t_gnode::_send(t_uindex portid, t_table_sptr fragments)
+{
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(
+        portid == 0, "Only simple dataflows supported currently");
+
+    if (m_gnode_type == GNODE_TYPE_IMPLICIT_PKEYED &&
+        fragments->is_pkey_table()) {
+        PSP_COMPLAIN_AND_ABORT("gnode type specified as implicit pkey, however input table has psp_pkey column.");
+    }
+
+    t_port_sptr& iport = m_iports[portid];
+    iport->send(std::move(fragments));
+}
+
+void
+t_gnode::_swap_input_ports()
+{
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    for (const auto& p : m_iports)
+    {
+        p->swap();
+    }
+}
+
 void
 t_gnode::populate_icols_in_flattened(
     const std::vector<t_rlookup>& lkup, t_table_sptr& flat) const
@@ -240,8 +269,7 @@ t_gnode::_process()
     m_was_updated = false;
     PSP_VERBOSE_ASSERT(m_mode == NODE_PROCESSING_SIMPLE_DATAFLOW,
         "Only simple dataflows supported currently");
-    psp_log_time(repr() + " _process.enter");
-    auto t1 = std::chrono::high_resolution_clock::now();
+    t_trace_scope process_scope(TRACE_GNODE_PROCESS);
 
     t_port_sptr& iport = m_iports[0];
 
@@ -270,12 +298,12 @@ t_gnode::_process()
         }
     }
 
+    t_trace_scope flatten_scope(TRACE_GNODE_FLATTEN);
     t_table_sptr flattened(iport->get_table()->flatten());
+    flatten_scope.end();
     PSP_GNODE_VERIFY_TABLE(flattened);
     PSP_GNODE_VERIFY_TABLE(get_table());
 
-    psp_log_time(repr() + " _process.post_flatten");
-
     if (t_env::log_data_gnode_flattened())
     {
         std::cout << std::endl << repr() << "gnode_process_flattened" << std::endl;
@@ -290,20 +318,14 @@ t_gnode::_process()
 
     if (m_state->mapping_size() == 0)
     {
-        psp_log_time(repr() + " _process.init_path.post_fill_expr");
-
+        t_trace_scope history_scope(TRACE_GNODE_UPDATE_HISTORY);
         m_state->update_history(flattened.get());
-        psp_log_time(repr() + " _process.init_path.post_update_history");
+        history_scope.end();
         _update_contexts_from_state(*flattened);
-        psp_log_time(
-            repr() + " _process.init_path.post_update_contexts_from_state");
         m_oports[PSP_PORT_FLATTENED]->set_table(flattened);
 
         release_inputs();
-        psp_log_time(repr() + " _process.init_path.post_release_inputs");
-
         release_outputs();
-        psp_log_time(repr() + " _process.init_path.exit");
 
 #ifdef PSP_GNODE_VERIFY
         auto stable = get_table();
@@ -406,13 +428,15 @@ t_gnode::_process()
     std::vector<t_rlookup> lkup(fnrows);
     std::vector<t_bool> prev_pkey_eq_vec(fnrows);
 
+    t_trace_scope lookup_scope(TRACE_GNODE_LOOKUP);
+    cstate.lookup_batch(*pkey_col, lkup);
+
     for (t_uindex idx = 0; idx < fnrows; ++idx)
     {
         t_tscalar pkey = pkey_col->get_scalar(idx);
         t_uint8 op_ = op_base[idx];
         t_op op = static_cast<t_op>(op_);
 
-        lkup[idx] = cstate.lookup(pkey);
         t_bool row_pre_existed = lkup[idx].m_exists;
         prev_pkey_eq_vec[idx] = pkey == prev_pkey;
 
@@ -461,13 +485,15 @@ t_gnode::_process()
     transitions->set_size(mask_count);
     existed->set_size(mask_count);
 
-    psp_log_time(repr() + " _process.noinit_path.post_rlkup_loop");
+    lookup_scope.end();
     if (!m_expr_icols.empty())
     {
         populate_icols_in_flattened(lkup, flattened);
     }
 
+    t_trace_scope columns_scope(TRACE_GNODE_PROCESS_COLUMNS);
 #ifdef PSP_PARALLEL_FOR
+    PSP_PFOR(0, int(ncols), 1,
         [&fcolumns, &scolumns, &dcolumns, &pcolumns, &ccolumns, &tcolumns,
             &col_translation, &op_base, &lkup, &prev_pkey_eq_vec, &added_offset,
             this](int colidx)
@@ -594,7 +620,7 @@ t_gnode::_process()
     );
 #endif
 
-        psp_log_time(repr() + " _process.noinit_path.post_process_helper");
+        columns_scope.end();
 
         t_table_sptr flattened_masked = mask.count() == flattened->size()
             ? flattened
@@ -606,7 +632,9 @@ t_gnode::_process()
             PSP_GNODE_VERIFY_TABLE(updated_table);
         }
 #endif
+        t_trace_scope history_scope(TRACE_GNODE_UPDATE_HISTORY);
         m_state->update_history(flattened_masked.get());
+        history_scope.end();
 #ifdef PSP_GNODE_VERIFY
         {
             auto updated_table = get_table();
@@ -614,8 +642,6 @@ t_gnode::_process()
         }
 #endif
 
-        psp_log_time(repr() + " _process.noinit_path.post_update_history");
-
         m_oports[PSP_PORT_FLATTENED]->set_table(flattened_masked);
 
         if (t_env::log_data_gnode_flattened_mask())
@@ -654,24 +680,7 @@ t_gnode::_process()
             existed->pprint();
         }
 
-        if (t_env::log_time_gnode_process())
-        {
-            auto t2 = std::chrono::high_resolution_clock::now();
-            std::cout << std::endl << repr() << " gnode_process_time "
-                      << std::chrono::duration_cast<std::chrono::milliseconds>(
-                             t2 - t1)
-                             .count()
-                      << std::endl;
-            std::cout << std::endl << repr() << "gnode_process_time since begin=> "
-                      << std::chrono::duration_cast<std::chrono::milliseconds>(
-                             t2 - m_epoch)
-                             .count()
-                      << std::endl;
-        }
-
         notify_contexts(*flattened_masked);
-
-        psp_log_time(repr() + " _process.noinit_path.exit");
 }
 
 t_table*
@@ -690,6 +699,18 @@ t_gnode::get_table() const
     return m_state->get_table().get();
 }
 
+t_filter_cache_sptr
+t_gnode::get_filter_cache() const
+{
+    return m_filter_cache;
+}
+
+t_strand_cache_sptr
+t_gnode::get_strand_cache() const
+{
+    return m_strand_cache;
+}
+
 void
 t_gnode::pprint() const
 {
@@ -706,6 +727,8 @@ t_gnode::set_ctx_state(void* ptr)
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     CTX_T* ctx = static_cast<CTX_T*>(ptr);
     ctx->set_state(m_state);
+    ctx->set_filter_cache(m_filter_cache);
+    ctx->set_strand_cache(m_strand_cache);
 }
 
 void
@@ -713,6 +736,9 @@ t_gnode::_update_contexts_from_state(const t_table& tbl)
 {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    t_trace_scope scope(TRACE_GNODE_UPDATE_CONTEXTS);
+    m_filter_cache->begin_step();
+    m_strand_cache->begin_step();
 
     for (auto& kv : m_contexts)
     {
@@ -754,6 +780,9 @@ t_gnode::_update_contexts_from_state(const t_table& tbl)
             break;
         }
     }
+
+    m_filter_cache->end_step();
+    m_strand_cache->end_step();
 }
 
 std::vector<t_str>
@@ -929,7 +958,9 @@ t_gnode::notify_contexts(const t_table& flattened)
 {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
-    psp_log_time(repr() + "notify_contexts.enter");
+    t_trace_scope scope(TRACE_GNODE_NOTIFY_CONTEXTS);
+    m_filter_cache->begin_step();
+    m_strand_cache->begin_step();
     t_index num_ctx = m_contexts.size();
     std::vector<t_ctx_handle> ctxhvec(num_ctx);
 
@@ -994,7 +1025,8 @@ t_gnode::notify_contexts(const t_table& flattened)
 #endif
     }
 
-    psp_log_time(repr() + "notify_contexts.exit");
+    m_filter_cache->end_step();
+    m_strand_cache->end_step();
 }
 
 t_streeptr_vec
@@ -1212,9 +1244,9 @@ t_gnode::reset()
 void
 t_gnode::clear_input_ports()
 {
-    for (t_uindex idx = 0, loop_end = m_oports.size(); idx < loop_end; ++idx)
+    for (const auto& p : m_iports)
     {
-        m_iports[idx]->get_table()->clear();
+        p->clear();
     }
 }
 
@@ -14,6 +14,9 @@
 #include <perspective/gnode_state.h>
 #include <perspective/mask.h>
 #include <perspective/sym_table.h>
+#include <perspective/vocab.h>
+#include <algorithm>
+#include <cstring>
 #ifdef PSP_PARALLEL_FOR
 #include <tbb/tbb.h>
 #endif
@@ -21,6 +24,90 @@
 namespace perspective
 {
 
+namespace
+{
+
+// Writes the rows of src to their rows stableidx in dst, moving DATA_T
+// sized values whatever the dtype. Rows valid in src are copied, rows
+// cleared in src clear their row, other rows and deletes leave theirs
+// alone. When the rows were all appended in order and are all valid the
+// column is copied as a block.
+template <typename DATA_T>
+void
+scatter_column(const t_column* src, t_column* dst, const t_uint8* ops,
+    const t_uindex* stableidx, t_uindex nrows, t_bool appended)
+{
+    const DATA_T* sdata = src->get_nth<DATA_T>(0);
+    DATA_T* ddata = dst->_get_data_lstore()->get_nth<DATA_T>(0);
+    const t_status* sstatus
+        = src->is_status_enabled() ? src->get_nth_status(0) : nullptr;
+    t_status* dstatus = dst->is_status_enabled()
+        ? dst->_get_status_lstore()->get_nth<t_status>(0)
+        : nullptr;
+
+    if (appended
+        && (!sstatus
+               || std::all_of(sstatus, sstatus + nrows,
+                      [](t_status s) { return s == STATUS_VALID; })))
+    {
+        std::memcpy(ddata + stableidx[0], sdata, nrows * sizeof(DATA_T));
+        if (dstatus)
+            std::memset(dstatus + stableidx[0], STATUS_VALID, nrows);
+        return;
+    }
+
+    for (t_uindex idx = 0; idx < nrows; ++idx)
+    {
+        t_status status = sstatus ? sstatus[idx] : STATUS_VALID;
+        if (status == STATUS_INVALID || ops[idx] == OP_DELETE)
+            continue;
+
+        t_uindex sidx = stableidx[idx];
+        t_bool valid = status == STATUS_VALID;
+        ddata[sidx] = valid ? sdata[idx] : DATA_T(0);
+        if (dstatus)
+            dstatus[sidx] = valid ? STATUS_VALID : STATUS_INVALID;
+    }
+}
+
+// As scatter_column, translating the string ids of src to those of dst.
+void
+scatter_str_column(const t_column* src, t_column* dst, const t_uint8* ops,
+    const t_uindex* stableidx, t_uindex nrows)
+{
+    const t_uindex* sdata = src->get_nth<t_uindex>(0);
+    t_uindex* ddata = dst->_get_data_lstore()->get_nth<t_uindex>(0);
+    const t_status* sstatus
+        = src->is_status_enabled() ? src->get_nth_status(0) : nullptr;
+    t_status* dstatus = dst->is_status_enabled()
+        ? dst->_get_status_lstore()->get_nth<t_status>(0)
+        : nullptr;
+
+    t_vocab_translation translation(*src->_get_vocab(), *dst->_get_vocab());
+
+    for (t_uindex idx = 0; idx < nrows; ++idx)
+    {
+        t_status status = sstatus ? sstatus[idx] : STATUS_VALID;
+        if (status == STATUS_INVALID || ops[idx] == OP_DELETE)
+            continue;
+
+        t_uindex sidx = stableidx[idx];
+        if (status != STATUS_VALID)
+        {
+            ddata[sidx] = 0;
+            if (dstatus)
+                dstatus[sidx] = STATUS_INVALID;
+            continue;
+        }
+
+        ddata[sidx] = translation.translate(sdata[idx]);
+        if (dstatus)
+            dstatus[sidx] = STATUS_VALID;
+    }
+}
+
+} // namespace
+
 t_gstate::t_gstate(const t_schema& tblschema, const t_schema& pkeyed_schema)
 
     : m_tblschema(tblschema)
@@ -40,71 +127,71 @@ t_gstate::init()
     m_table->init();
     m_pkcol = m_table->get_column("psp_pkey");
     m_opcol = m_table->get_column("psp_op");
+    m_index.init(m_pkcol->get_dtype(), m_pkcol->_get_vocab());
     m_init = true;
 }
 
 t_rlookup
 t_gstate::lookup(t_tscalar pkey) const
 {
-    t_rlookup rval(0, false);
-
-    t_mapping::const_iterator iter = m_mapping.find(pkey);
+    return m_index.lookup(pkey);
+}
 
-    if (iter == m_mapping.end())
-        return rval;
+void
+t_gstate::lookup_batch(const t_column& pkeys, std::vector<t_rlookup>& out) const
+{
+    if (pkeys.get_dtype() != m_index.get_dtype())
+    {
+        t_uindex nrows = pkeys.size();
+        out.resize(nrows);
+        for (t_uindex idx = 0; idx < nrows; ++idx)
+        {
+            out[idx] = lookup(pkeys.get_scalar(idx));
+        }
+        return;
+    }
 
-    rval.m_idx = iter->second;
-    rval.m_exists = true;
-    return rval;
+    m_index.lookup_batch(pkeys, out);
 }
 
 void
 t_gstate::_mark_deleted(t_uindex idx)
 {
-    m_free.insert(idx);
+    m_free.push_back(idx);
 }
 
 void
 t_gstate::erase(const t_tscalar& pkey)
 {
-    t_mapping::const_iterator iter = m_mapping.find(pkey);
-
-    if (iter == m_mapping.end())
-    {
+    t_uindex idx;
+    if (!m_index.erase(pkey, idx))
         return;
-    }
 
     auto columns = m_table->get_columns();
 
-    t_uindex idx = iter->second;
-
     for (auto c : columns)
     {
         c->clear(idx);
     }
 
-    m_mapping.erase(iter);
     _mark_deleted(idx);
 }
 
 t_uindex
 t_gstate::lookup_or_create(const t_tscalar& pkey)
 {
-    auto pkey_ = m_symtable.get_interned_tscalar(pkey);
-
-    t_mapping::const_iterator iter = m_mapping.find(pkey_);
+    t_rlookup lk = m_index.lookup(pkey);
 
-    if (iter != m_mapping.end())
+    if (lk.m_exists)
     {
-        return iter->second;
+        return lk.m_idx;
     }
 
     if (!m_free.empty())
     {
-        t_free_items::const_iterator iter = m_free.begin();
-        t_uindex idx = *iter;
-        m_free.erase(iter);
-        m_mapping[pkey_] = idx;
+        t_uindex idx = m_free.back();
+        m_free.pop_back();
+        m_index.insert(pkey, idx);
         return idx;
     }
 
@@ -119,7 +206,7 @@ t_gstate::lookup_or_create(const t_tscalar& pkey)
     m_table->set_size(nrows + 1);
     m_opcol->set_nth<t_uint8>(nrows, OP_INSERT);
     m_pkcol->set_scalar(nrows, pkey);
-    m_mapping[pkey_] = nrows;
+    m_index.insert(pkey, nrows);
     return nrows;
 }
 
@@ -162,7 +249,6 @@ t_gstate::update_history(const t_table* tbl)
     if (size() == 0)
     {
         m_free.clear();
-        m_mapping.clear();
 #ifdef PSP_PARALLEL_FOR
         PSP_PFOR(0, int(ncols), 1,
             [&stable, &fcolumns, &col_translation](int idx)
@@ -179,6 +265,9 @@ t_gstate::update_history(const t_table* tbl)
         m_pkcol = stable->get_column("psp_pkey");
         m_opcol = stable->get_column("psp_op");
 
+        m_index.init(m_pkcol->get_dtype(), m_pkcol->_get_vocab());
+        m_index.reserve(tbl->num_rows());
+
         stable->set_capacity(tbl->get_capacity());
         stable->set_size(tbl->size());
 
@@ -193,7 +282,7 @@ t_gstate::update_history(const t_table* tbl)
             {
                 case OP_INSERT:
                 {
-                    m_mapping[m_symtable.get_interned_tscalar(pkey)] = idx;
+                    m_index.insert(pkey, idx);
                     m_opcol->set_nth<t_uint8>(idx, OP_INSERT);
                     m_pkcol->set_scalar(idx, pkey);
                 }
@@ -219,40 +308,47 @@ t_gstate::update_history(const t_table* tbl)
     }
 
     /* size is not zero */
-    std::vector<t_uindex> stableidx_vec(tbl->num_rows());
+    t_uindex nrows = tbl->num_rows();
+    if (nrows == 0)
+        return;
 
-    for (t_uindex idx = 0, loop_end = tbl->num_rows(); idx < loop_end; ++idx)
-    {
-        t_tscalar pkey = pkey_col->get_scalar(idx);
-        const t_uint8* op_ptr = op_col->get_nth<t_uint8>(idx);
-        t_op op = static_cast<t_op>(*op_ptr);
+    const t_uint8* ops = op_col->get_nth<t_uint8>(0);
+    std::vector<t_uindex> stableidx_vec(nrows);
+    t_bool appended = append_rows(*pkey_col, ops, stableidx_vec);
 
-        switch (op)
+    if (!appended)
+    {
+        for (t_uindex idx = 0; idx < nrows; ++idx)
         {
-            case OP_INSERT:
-            {
-                stableidx_vec[idx] = lookup_or_create(pkey);
-                m_opcol->set_nth<t_uint8>(stableidx_vec[idx], OP_INSERT);
-                m_pkcol->set_scalar(stableidx_vec[idx], pkey);
-            }
-            break;
-            case OP_DELETE:
-            {
-                erase(pkey);
-            }
-            break;
-            default:
+            t_tscalar pkey = pkey_col->get_scalar(idx);
+            t_op op = static_cast<t_op>(ops[idx]);
+
+            switch (op)
             {
-                PSP_COMPLAIN_AND_ABORT("Unexpected OP");
+                case OP_INSERT:
+                {
+                    stableidx_vec[idx] = lookup_or_create(pkey);
+                    m_opcol->set_nth<t_uint8>(stableidx_vec[idx], OP_INSERT);
+                    m_pkcol->set_scalar(stableidx_vec[idx], pkey);
+                }
+                break;
+                case OP_DELETE:
+                {
+                    erase(pkey);
+                }
+                break;
+                default:
+                {
+                    PSP_COMPLAIN_AND_ABORT("Unexpected OP");
+                }
+                break;
             }
-            break;
         }
     }
 
 #ifdef PSP_PARALLEL_FOR
-    const t_mapping* m = &m_mapping;
     PSP_PFOR(0, int(ncols), 1,
-        [m, tbl, pkey_col, op_col, &col_translation, &fcolumns, &scolumns,
+        [ops, nrows, appended, &col_translation, &fcolumns, &scolumns,
             &stableidx_vec](int colidx)
 #else
     for (t_uindex colidx = 0; colidx < ncols; ++colidx)
@@ -260,125 +356,56 @@ t_gstate::update_history(const t_table* tbl)
 
         {
             const t_column* fcolumn = fcolumns[col_translation[colidx]];
-
             t_column* scolumn = scolumns[colidx];
+            const t_uindex* stableidx = stableidx_vec.data();
 
-            for (t_uindex idx = 0, loop_end = tbl->num_rows(); idx < loop_end;
-                 ++idx)
+            switch (fcolumn->get_dtype())
             {
-                t_bool is_valid = fcolumn->is_valid(idx);
-                t_uindex stableidx = stableidx_vec[idx];
-
-                if (!is_valid)
+                case DTYPE_NONE:
                 {
-                    t_bool is_cleared = fcolumn->is_cleared(idx);
-                    if (is_cleared)
-                    {
-                        scolumn->clear(stableidx);
-                    }
-                    continue;
                 }
-
-                const t_uint8* op_ptr = op_col->get_nth<t_uint8>(idx);
-                t_op op = static_cast<t_op>(*op_ptr);
-
-                if (op == OP_DELETE)
-                    continue;
-
-                switch (fcolumn->get_dtype())
+                break;
+                case DTYPE_INT64:
+                case DTYPE_UINT64:
+                case DTYPE_FLOAT64:
+                case DTYPE_TIME:
                 {
-                    case DTYPE_NONE:
-                    {
-                    }
-                    break;
-                    case DTYPE_INT64:
-                    {
-                        scolumn->set_nth<t_int64>(
-                            stableidx, *(fcolumn->get_nth<t_int64>(idx)));
-                    }
-                    break;
-                    case DTYPE_INT32:
-                    {
-                        scolumn->set_nth<t_int32>(
-                            stableidx, *(fcolumn->get_nth<t_int32>(idx)));
-                    }
-                    break;
-                    case DTYPE_INT16:
-                    {
-                        scolumn->set_nth<t_int16>(
-                            stableidx, *(fcolumn->get_nth<t_int16>(idx)));
-                    }
-                    break;
-                    case DTYPE_INT8:
-                    {
-                        scolumn->set_nth<t_int8>(
-                            stableidx, *(fcolumn->get_nth<t_int8>(idx)));
-                    }
-                    break;
-                    case DTYPE_UINT64:
-                    {
-                        scolumn->set_nth<t_uint64>(
-                            stableidx, *(fcolumn->get_nth<t_uint64>(idx)));
-                    }
-                    break;
-                    case DTYPE_UINT32:
-                    {
-                        scolumn->set_nth<t_uint32>(
-                            stableidx, *(fcolumn->get_nth<t_uint32>(idx)));
-                    }
-                    break;
-                    case DTYPE_UINT16:
-                    {
-                        scolumn->set_nth<t_uint16>(
-                            stableidx, *(fcolumn->get_nth<t_uint16>(idx)));
-                    }
-                    break;
-                    case DTYPE_UINT8:
-                    {
-                        scolumn->set_nth<t_uint8>(
-                            stableidx, *(fcolumn->get_nth<t_uint8>(idx)));
-                    }
-                    break;
-                    case DTYPE_FLOAT64:
-                    {
-                        scolumn->set_nth<t_float64>(
-                            stableidx, *(fcolumn->get_nth<t_float64>(idx)));
-                    }
-                    break;
-                    case DTYPE_FLOAT32:
-                    {
-                        scolumn->set_nth<t_float32>(
-                            stableidx, *(fcolumn->get_nth<t_float32>(idx)));
-                    }
-                    break;
-                    case DTYPE_BOOL:
-                    {
-                        scolumn->set_nth<t_uint8>(
-                            stableidx, *(fcolumn->get_nth<t_uint8>(idx)));
-                    }
-                    break;
-                    case DTYPE_TIME:
-                    {
-                        scolumn->set_nth<t_int64>(
-                            stableidx, *(fcolumn->get_nth<t_int64>(idx)));
-                    }
-                    break;
-                    case DTYPE_DATE:
-                    {
-                        scolumn->set_nth<t_uint32>(
-                            stableidx, *(fcolumn->get_nth<t_uint32>(idx)));
-                    }
-                    break;
-                    case DTYPE_STR:
-                    {
-                        const char* s = fcolumn->get_nth<const char>(idx);
-                        scolumn->set_nth<const char*>(stableidx, s);
-                    }
-                    break;
-                    default:
-                    {
-                        PSP_COMPLAIN_AND_ABORT("Unexpected type");
-                    }
+                    scatter_column<t_uint64>(
+                        fcolumn, scolumn, ops, stableidx, nrows, appended);
+                }
+                break;
+                case DTYPE_INT32:
+                case DTYPE_UINT32:
+                case DTYPE_FLOAT32:
+                case DTYPE_DATE:
+                {
+                    scatter_column<t_uint32>(
+                        fcolumn, scolumn, ops, stableidx, nrows, appended);
+                }
+                break;
+                case DTYPE_INT16:
+                case DTYPE_UINT16:
+                {
+                    scatter_column<t_uint16>(
+                        fcolumn, scolumn, ops, stableidx, nrows, appended);
+                }
+                break;
+                case DTYPE_INT8:
+                case DTYPE_UINT8:
+                case DTYPE_BOOL:
+                {
+                    scatter_column<t_uint8>(
+                        fcolumn, scolumn, ops, stableidx, nrows, appended);
+                }
+                break;
+                case DTYPE_STR:
+                {
+                    scatter_str_column(fcolumn, scolumn, ops, stableidx, nrows);
+                }
+                break;
+                default:
+                {
+                    PSP_COMPLAIN_AND_ABORT("Unexpected type");
                 }
             }
         }
@@ -387,17 +414,55 @@ t_gstate::update_history(const t_table* tbl)
 #endif
 }
 
-void
-t_gstate::pprint() const
+t_bool
+t_gstate::append_rows(const t_column& pkeys, const t_uint8* ops,
+    std::vector<t_uindex>& stableidx)
 {
-    std::vector<t_uindex> indices(m_mapping.size());
-    t_uindex idx = 0;
-    for (t_mapping::const_iterator iter = m_mapping.begin();
-         iter != m_mapping.end(); ++iter)
+    t_uindex nrows = stableidx.size();
+    if (!m_free.empty())
+        return false;
+
+    for (t_uindex idx = 0; idx < nrows; ++idx)
     {
-        indices[idx] = iter->second;
-        ++idx;
+        if (ops[idx] != OP_INSERT)
+            return false;
+    }
+
+    std::vector<t_rlookup> lkup;
+    lookup_batch(pkeys, lkup);
+    for (const auto& lk : lkup)
+    {
+        if (lk.m_exists)
+            return false;
+    }
+
+    // Flattened tables hold one insert per pkey, so every row gets its own
+    // row at the end of the table
+    t_uindex base = m_table->num_rows();
+    if (base + nrows >= m_table->get_capacity())
+    {
+        m_table->reserve(std::max(base + nrows + 1,
+            static_cast<t_uindex>(
+                m_table->get_capacity() * PSP_TABLE_GROW_RATIO)));
     }
+    m_table->set_size(base + nrows);
+    m_index.reserve(m_index.size() + nrows);
+
+    for (t_uindex idx = 0; idx < nrows; ++idx)
+    {
+        stableidx[idx] = base + idx;
+        m_index.insert(pkeys.get_scalar(idx), base + idx);
+    }
+
+    return true;
+}
+
+void
+t_gstate::pprint() const
+{
+    std::vector<t_uindex> indices;
+    indices.reserve(m_index.size());
+    m_index.for_each([&indices](t_uindex idx) { indices.push_back(idx); });
     m_table->pprint(indices);
 }
 
@@ -406,11 +471,7 @@ t_gstate::get_cpp_mask() const
 {
     t_uindex sz = m_table->size();
     t_mask msk(sz);
-    for (t_mapping::const_iterator iter = m_mapping.begin();
-         iter != m_mapping.end(); ++iter)
-    {
-        msk.set(iter->second, true);
-    }
+    m_index.for_each([&msk](t_uindex idx) { msk.set(idx, true); });
     return msk;
 }
 
@@ -437,10 +498,10 @@ t_gstate::read_column(
 
     for (t_index idx = 0; idx < num; ++idx)
     {
-        t_mapping::const_iterator iter = m_mapping.find(pkeys[idx]);
-        if (iter != m_mapping.end())
+        t_rlookup lk = m_index.lookup(pkeys[idx]);
+        if (lk.m_exists)
         {
-            rval[idx].set(col_->get_scalar(iter->second));
+            rval[idx].set(col_->get_scalar(lk.m_idx));
         }
     }
 
@@ -465,10 +526,10 @@ t_gstate::read_column(const t_str& colname, const t_tscalvec& pkeys,
     std::vector<t_float64> rval;
     for (t_index idx = 0; idx < num; ++idx)
     {
-        t_mapping::const_iterator iter = m_mapping.find(pkeys[idx]);
-        if (iter != m_mapping.end())
+        t_rlookup lk = m_index.lookup(pkeys[idx]);
+        if (lk.m_exists)
         {
-            auto tscalar = col_->get_scalar(iter->second);
+            auto tscalar = col_->get_scalar(lk.m_idx);
             if (include_nones || tscalar.is_valid())
             {
                 rval.push_back(tscalar.to_double());
@@ -481,11 +542,11 @@ t_gstate::read_column(const t_str& colname, const t_tscalvec& pkeys,
 t_tscalar
 t_gstate::get(t_tscalar pkey, const t_str& colname) const
 {
-    t_mapping::const_iterator iter = m_mapping.find(pkey);
-    if (iter != m_mapping.end())
+    t_rlookup lk = m_index.lookup(pkey);
+    if (lk.m_exists)
     {
         t_col_csptr col = m_table->get_const_column(colname);
-        return col->get_scalar(iter->second);
+        return col->get_scalar(lk.m_idx);
     }
 
     return t_tscalar();
@@ -497,10 +558,10 @@ t_gstate::get_row(t_tscalar pkey) const
     auto columns = m_table->get_const_columns();
     t_tscalvec rval(columns.size());
 
-    t_mapping::const_iterator iter = m_mapping.find(pkey);
-    PSP_VERBOSE_ASSERT(iter != m_mapping.end(), "Reached end");
+    t_rlookup lk = m_index.lookup(pkey);
+    PSP_VERBOSE_ASSERT(lk.m_exists, "Reached end");
 
-    t_uindex ridx = iter->second;
+    t_uindex ridx = lk.m_idx;
     t_uindex idx = 0;
 
     for (auto c : columns)
@@ -521,10 +582,10 @@ t_gstate::is_unique(
 
     for (const auto& pkey : pkeys)
     {
-        t_mapping::const_iterator iter = m_mapping.find(pkey);
-        if (iter != m_mapping.end())
+        t_rlookup lk = m_index.lookup(pkey);
+        if (lk.m_exists)
         {
-            auto tmp = col_->get_scalar(iter->second);
+            auto tmp = col_->get_scalar(lk.m_idx);
             if (!value.is_none() && value != tmp)
                 return false;
             value = tmp;
@@ -545,10 +606,10 @@ t_gstate::apply(const t_tscalvec& pkeys, const t_str& colname, t_tscalar& value,
 
     for (const auto& pkey : pkeys)
     {
-        t_mapping::const_iterator iter = m_mapping.find(pkey);
-        if (iter != m_mapping.end())
+        t_rlookup lk = m_index.lookup(pkey);
+        if (lk.m_exists)
         {
-            auto tmp = col_->get_scalar(iter->second);
+            auto tmp = col_->get_scalar(lk.m_idx);
             t_bool done = fn(tmp, value);
             if (done)
             {
@@ -570,16 +631,18 @@ t_gstate::get_schema() const
 t_dtype
 t_gstate::get_pkey_dtype() const
 {
-    if (m_mapping.empty())
+    if (m_index.size() == 0)
         return DTYPE_STR;
-    auto iter = m_mapping.begin();
-    return iter->first.get_dtype();
+    return m_index.get_dtype();
 }
 
 t_table_sptr
 t_gstate::get_sorted_pkeyed_table() const
 {
-    std::map<t_tscalar, t_uindex> ordered(m_mapping.begin(), m_mapping.end());
+    std::map<t_tscalar, t_uindex> ordered;
+    m_index.for_each([this, &ordered](t_uindex idx) {
+        ordered[m_pkcol->get_scalar(idx)] = idx;
+    });
     auto sch = m_pkeyed_schema.drop({"psp_op"});
     auto rv = std::make_shared<t_table>(sch, 0);
     rv->init();
@@ -613,7 +676,7 @@ t_gstate::get_sorted_pkeyed_table() const
 t_table_sptr
 t_gstate::get_pkeyed_table() const
 {
-    if (m_mapping.size() == m_table->size())
+    if (m_index.size() == m_table->size())
         return m_table;
     return t_table_sptr(_get_pkeyed_table(m_pkeyed_schema));
 }
@@ -683,14 +746,14 @@ t_gstate::_get_pkeyed_table(const t_schema& schema, const t_mask& mask) const
     }
 
     t_uindex oidx = 0;
-    for (const auto& kv : m_mapping)
-    {
-        if (mask.get(kv.second))
+    m_index.for_each([this, &mask, &mapping, &order, &oidx](t_uindex idx) {
+        if (mask.get(idx))
         {
-            order[oidx] = std::make_pair(kv.first, mapping[kv.second]);
+            order[oidx]
+                = std::make_pair(m_pkcol->get_scalar(idx), mapping[idx]);
             ++oidx;
         }
-    }
+    });
 
     std::sort(order.begin(), order.end(),
         [](const std::pair<t_tscalar, t_uindex>& a,
@@ -718,7 +781,7 @@ t_gstate::_get_pkeyed_table(const t_schema& schema, const t_mask& mask) const
             }
         }
 
-        // if the m_mapping is empty, get_pkey_dtype() may lie about our pkeys
+        // if the index is empty, get_pkey_dtype() may lie about our pkeys
         // being strings don't try to reserve in this case
         if (!order.size())
             total_string_size = 0;
@@ -768,13 +831,13 @@ t_gstate::get_row_data_pkeys(const t_tscalvec& pkeys) const
 
     for (const auto& pkey : pkeys)
     {
-        t_mapping::const_iterator iter = m_mapping.find(pkey);
-        if (iter == m_mapping.end())
+        t_rlookup lk = m_index.lookup(pkey);
+        if (!lk.m_exists)
             continue;
 
         for (t_uindex cidx = 0; cidx < ncols; ++cidx)
         {
-            auto v = columns[cidx]->get_scalar(iter->second);
+            auto v = columns[cidx]->get_scalar(lk.m_idx);
             if (v.is_valid())
             {
                 rval.push_back(v);
@@ -791,7 +854,7 @@ t_gstate::get_row_data_pkeys(const t_tscalvec& pkeys) const
 t_bool
 t_gstate::has_pkey(t_tscalar pkey) const
 {
-    return m_mapping.find(pkey) != m_mapping.end();
+    return m_index.lookup(pkey).m_exists;
 }
 
 t_tscalvec
@@ -806,7 +869,7 @@ t_gstate::has_pkeys(const t_tscalvec& pkeys) const
     for (const auto& p : pkeys)
     {
         t_tscalar tval;
-        tval.set(m_mapping.find(p) != m_mapping.end());
+        tval.set(m_index.lookup(p).m_exists);
         rval[idx].set(tval);
         ++idx;
     }
@@ -817,13 +880,11 @@ t_gstate::has_pkeys(const t_tscalvec& pkeys) const
 t_tscalvec
 t_gstate::get_pkeys() const
 {
-    t_tscalvec rval(m_mapping.size());
-    t_uindex idx = 0;
-    for (const auto& kv : m_mapping)
-    {
-        rval[idx].set(kv.first);
-        ++idx;
-    }
+    t_tscalvec rval;
+    rval.reserve(m_index.size());
+    m_index.for_each([this, &rval](t_uindex idx) {
+        rval.push_back(m_pkcol->get_scalar(idx));
+    });
     return rval;
 }
 
@@ -860,15 +921,15 @@ get_vec_min_max(const t_tscalvec& vec)
 t_uindex
 t_gstate::mapping_size() const
 {
-    return m_mapping.size();
+    return m_index.size();
 }
 
 void
 t_gstate::reset()
 {
     m_table->clear();
-    m_mapping.clear();
     m_free.clear();
+    m_index.clear();
 }
 
 t_tscalar
@@ -878,10 +939,10 @@ t_gstate::get_value(const t_tscalar& pkey, const t_str& colname) const
     const t_column* col_ = col.get();
     t_tscalar rval = mknone();
 
-    auto iter = m_mapping.find(pkey);
-    if (iter != m_mapping.end())
+    t_rlookup lk = m_index.lookup(pkey);
+    if (lk.m_exists)
     {
-        rval.set(col_->get_scalar(iter->second));
+        rval.set(col_->get_scalar(lk.m_idx));
     }
 
     return rval;
@@ -0,0 +1,239 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/loader.h>
+#include <perspective/column.h>
+#include <perspective/storage.h>
+#include <perspective/schema.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace perspective
+{
+
+t_column_buffer::t_column_buffer()
+    : m_dtype(DTYPE_NONE)
+    , m_data(nullptr)
+    , m_offsets(nullptr)
+    , m_offset(0)
+    , m_length(0)
+    , m_valid(nullptr)
+{
+}
+
+t_column_buffer::t_column_buffer(const t_str& name, t_dtype dtype,
+    const void* data, t_uindex length, const t_uint8* valid)
+    : m_name(name)
+    , m_dtype(dtype)
+    , m_data(data)
+    , m_offsets(nullptr)
+    , m_offset(0)
+    , m_length(length)
+    , m_valid(valid)
+{
+}
+
+t_column_buffer::t_column_buffer(const t_str& name, const char* data,
+    const t_int32* offsets, t_uindex length, const t_uint8* valid)
+    : m_name(name)
+    , m_dtype(DTYPE_STR)
+    , m_data(data)
+    , m_offsets(offsets)
+    , m_offset(0)
+    , m_length(length)
+    , m_valid(valid)
+{
+}
+
+namespace
+{
+
+// 256 entries of 8 unpacked bytes, entry b holding bit j of b in byte j.
+struct t_unpack_lut
+{
+    t_unpack_lut()
+    {
+        for (t_uindex b = 0; b < 256; ++b)
+        {
+            for (t_uindex j = 0; j < 8; ++j)
+            {
+                m_bytes[b][j] = (b >> j) & 1;
+            }
+        }
+    }
+
+    t_uint8 m_bytes[256][8];
+};
+
+const t_unpack_lut UNPACK_LUT;
+
+} // namespace
+
+void
+unpack_bits(
+    const t_uint8* bitmap, t_uindex offset, t_uindex nrows, t_uint8* out)
+{
+    t_uindex ridx = 0;
+
+    // Walk single bits up to the first byte boundary
+    for (; ridx < nrows && (offset + ridx) % 8 != 0; ++ridx)
+    {
+        t_uindex bit = offset + ridx;
+        out[ridx] = (bitmap[bit / 8] >> (bit % 8)) & 1;
+    }
+
+    const t_uint8* base = bitmap + (offset + ridx) / 8;
+    t_uindex nwords = (nrows - ridx) / 64;
+
+    for (t_uindex widx = 0; widx < nwords; ++widx, ridx += 64)
+    {
+        t_uint64 word;
+        std::memcpy(&word, base + widx * 8, sizeof(word));
+        t_uint8* dst = out + ridx;
+
+        if (word == ~t_uint64(0))
+        {
+            std::memset(dst, 1, 64);
+        }
+        else if (word == 0)
+        {
+            std::memset(dst, 0, 64);
+        }
+        else
+        {
+            for (t_uindex bidx = 0; bidx < 8; ++bidx)
+            {
+                std::memcpy(dst + bidx * 8,
+                    UNPACK_LUT.m_bytes[base[widx * 8 + bidx]], 8);
+            }
+        }
+    }
+
+    for (; ridx < nrows; ++ridx)
+    {
+        t_uindex bit = offset + ridx;
+        out[ridx] = (bitmap[bit / 8] >> (bit % 8)) & 1;
+    }
+}
+
+void
+expand_validity(
+    const t_uint8* bitmap, t_uindex offset, t_uindex nrows, t_status* out)
+{
+    static_assert(STATUS_INVALID == 0 && STATUS_VALID == 1,
+        "unpack_bits produces raw t_status values");
+    unpack_bits(bitmap, offset, nrows, reinterpret_cast<t_uint8*>(out));
+}
+
+void
+fill_column(t_column* col, const t_column_buffer& buf)
+{
+    if (col->get_dtype() != buf.m_dtype)
+    {
+        throw std::invalid_argument(
+            t_str("Column buffer ") + buf.m_name + " has mismatched dtype");
+    }
+
+    if (col->size() < buf.m_length)
+    {
+        throw std::invalid_argument(
+            t_str("Column buffer ") + buf.m_name + " is longer than column");
+    }
+
+    if (buf.m_dtype == DTYPE_STR && !buf.m_offsets)
+    {
+        throw std::invalid_argument(
+            t_str("String column buffer ") + buf.m_name + " has no offsets");
+    }
+
+    t_uindex nrows = buf.m_length;
+    if (nrows == 0)
+        return;
+
+    if (buf.m_dtype == DTYPE_STR)
+    {
+        const char* base = static_cast<const char*>(buf.m_data);
+        const t_int32* offsets = buf.m_offsets + buf.m_offset;
+        t_str elem;
+        for (t_uindex ridx = 0; ridx < nrows; ++ridx)
+        {
+            t_int32 bidx = offsets[ridx];
+            elem.assign(base + bidx, offsets[ridx + 1] - bidx);
+            col->set_nth(ridx, elem);
+        }
+    }
+    else
+    {
+        t_uindex elemsize = get_dtype_size(buf.m_dtype);
+        std::memcpy(col->_get_data_lstore()->get_ptr(0),
+            static_cast<const t_uint8*>(buf.m_data) + buf.m_offset * elemsize,
+            nrows * elemsize);
+    }
+
+    if (!col->is_status_enabled())
+        return;
+
+    t_status* status = col->_get_status_lstore()->get_nth<t_status>(0);
+    if (buf.m_valid)
+    {
+        expand_validity(buf.m_valid, buf.m_offset, nrows, status);
+    }
+    else
+    {
+        std::fill(status, status + nrows, STATUS_VALID);
+    }
+}
+
+void
+add_index_columns(t_table* tbl, const t_str& index, t_bool is_delete)
+{
+    if (index == "")
+        return;
+
+    tbl->clone_column(index, "psp_pkey");
+    auto op_col = tbl->add_column("psp_op", DTYPE_UINT8, false);
+    op_col->raw_fill<t_uint8>(is_delete ? OP_DELETE : OP_INSERT);
+}
+
+t_table_sptr
+load_table(const t_column_buffer_vec& columns, t_uindex nrows,
+    const t_str& index, t_bool is_delete)
+{
+    std::vector<t_str> colnames;
+    std::vector<t_dtype> dtypes;
+    colnames.reserve(columns.size());
+    dtypes.reserve(columns.size());
+
+    for (const auto& buf : columns)
+    {
+        if (buf.m_length != nrows)
+        {
+            throw std::invalid_argument(t_str("Column buffer ") + buf.m_name
+                + " does not have " + std::to_string(nrows) + " rows");
+        }
+        colnames.push_back(buf.m_name);
+        dtypes.push_back(buf.m_dtype);
+    }
+
+    auto tbl = std::make_shared<t_table>(t_schema(colnames, dtypes), nrows);
+    tbl->init();
+    tbl->extend(nrows);
+
+    for (const auto& buf : columns)
+    {
+        fill_column(tbl->_get_column(buf.m_name), buf);
+    }
+
+    add_index_columns(tbl.get(), index, is_delete);
+    return tbl;
+}
+
+} // end namespace perspective
@@ -22,6 +22,8 @@
 #include <emscripten/val.h>
 #include <perspective/sym_table.h>
 #include <perspective/vocab.h>
+#include <perspective/loader.h>
+#include <perspective/trace.h>
 #include <codecvt>
 
 using namespace perspective;
@@ -197,6 +199,13 @@ _get_aggspecs(val j_aggs)
                     t_aggspec(name, aggtype, dependencies, kernel));
             }
             break;
+            case AGGTYPE_UDF_CPP_REDUCE_FLOAT64:
+            {
+                // the kernel slot names the registered reducer
+                aggspecs.push_back(t_aggspec(name, aggtype, dependencies,
+                    kernel.as<std::string>()));
+            }
+            break;
             default:
             {
                 aggspecs.push_back(t_aggspec(name, aggtype, dependencies));
@@ -230,13 +239,13 @@ vecFromTypedArray(const val& typedArray, void* data, t_int32 length,
     {
         val memoryView = typedArray["constructor"].new_(
             memory, reinterpret_cast<std::uintptr_t>(data), length);
-        memoryView.call<void>("set", typedArray.call<val>("slice", 0, length));
+        memoryView.call<void>("set", typedArray.call<val>("subarray", 0, length));
     }
     else
     {
         val memoryView = val::global(destType).new_(
             memory, reinterpret_cast<std::uintptr_t>(data), length);
-        memoryView.call<void>("set", typedArray.call<val>("slice", 0, length));
+        memoryView.call<void>("set", typedArray.call<val>("subarray", 0, length));
     }
 }
 
@@ -246,13 +255,13 @@ fill_col_valid(val dcol, t_col_sptr col)
     // dcol should be the Uint8Array containing the null bitmap
     t_uindex nrows = col->size();
 
-    // arrow packs bools into a bitmap
-    for (auto i = 0; i < nrows; ++i)
-    {
-        t_uint8 elem = dcol[i / 8].as<t_uint8>();
-        t_bool v = elem & (1 << (i % 8));
-        col->set_valid(i, v);
-    }
+    // Pull the packed bitmap across the js boundary once, then expand it
+    // a word at a time instead of a val lookup per row
+    t_int32 nbytes = (nrows + 7) / 8;
+    std::vector<t_uint8> bitmap(nbytes);
+    vecFromTypedArray(dcol, bitmap.data(), nbytes);
+    expand_validity(bitmap.data(), 0, nrows,
+        col->_get_status_lstore()->get_nth<t_status>(0));
 }
 
 void
@@ -486,12 +495,10 @@ _fill_col<t_bool>(val dcol, t_col_sptr col, t_bool is_arrow)
     {
         // arrow packs bools into a bitmap
         val data = dcol["values"];
-        for (auto i = 0; i < nrows; ++i)
-        {
-            t_uint8 elem = data[i / 8].as<t_uint8>();
-            t_bool v = elem & (1 << (i % 8));
-            col->set_nth(i, v);
-        }
+        t_int32 nbytes = (nrows + 7) / 8;
+        std::vector<t_uint8> bitmap(nbytes);
+        arrow::vecFromTypedArray(data, bitmap.data(), nbytes);
+        unpack_bits(bitmap.data(), 0, nrows, col->get_nth<t_uint8>(0));
     }
     else
     {
@@ -1255,6 +1262,7 @@ EMSCRIPTEN_BINDINGS(perspective)
         .function("get_data", &t_ctx0::get_data)
         .function("get_step_delta", &t_ctx0::get_step_delta)
         .function("get_cell_delta", &t_ctx0::get_cell_delta)
+        .function("set_sort_window", &t_ctx0::set_sort_window)
         .function(
             "get_column_names", &t_ctx0::get_column_names)
         .function("get_column_dtype", &t_ctx0::get_column_dtype)
@@ -1387,7 +1395,9 @@ EMSCRIPTEN_BINDINGS(perspective)
         .function(
             "register_gnode", &t_pool::register_gnode, allow_raw_pointers())
         .function("process", &t_pool::_process)
-        .function("send", &t_pool::send)
+        .function("send",
+            select_overload<void(t_uindex, t_uindex, const t_table&)>(
+                &t_pool::send))
         .function("epoch", &t_pool::epoch)
         .function("unregister_gnode", &t_pool::unregister_gnode)
         .function("set_update_delegate", &t_pool::set_update_delegate)
@@ -1516,7 +1526,9 @@ EMSCRIPTEN_BINDINGS(perspective)
         .value("AGGTYPE_DISTINCT_LEAF", AGGTYPE_DISTINCT_LEAF)
         .value("AGGTYPE_PCT_SUM_PARENT", AGGTYPE_PCT_SUM_PARENT)
         .value("AGGTYPE_PCT_SUM_GRAND_TOTAL", AGGTYPE_PCT_SUM_GRAND_TOTAL)
-        .value("AGGTYPE_UDF_JS_REDUCE_FLOAT64", AGGTYPE_UDF_JS_REDUCE_FLOAT64);
+        .value("AGGTYPE_UDF_JS_REDUCE_FLOAT64", AGGTYPE_UDF_JS_REDUCE_FLOAT64)
+        .value(
+            "AGGTYPE_UDF_CPP_REDUCE_FLOAT64", AGGTYPE_UDF_CPP_REDUCE_FLOAT64);
 
     enum_<t_totals>("t_totals")
         .value("TOTALS_BEFORE", TOTALS_BEFORE)
@@ -1537,4 +1549,7 @@ EMSCRIPTEN_BINDINGS(perspective)
     function("get_data_zero", &get_data<t_ctx0_sptr>);
     function("get_data_one", &get_data<t_ctx1_sptr>);
     function("get_data_two", &get_data<t_ctx2_sptr>);
+    function("set_trace_enabled", &set_trace_enabled);
+    function("clear_trace", &clear_trace);
+    function("get_trace_json", &get_trace_json);
 }
@@ -11,6 +11,7 @@
 #include <perspective/mask.h>
 #include <perspective/raii.h>
 #include <iostream>
+#include <iterator>
 
 namespace perspective
 {
@@ -33,6 +34,42 @@ t_mask::t_mask(const t_simple_bitmask& m)
     }
 }
 
+t_mask::t_mask(const std::vector<t_uint64>& words, t_uindex size)
+{
+    typedef boost::dynamic_bitset<>::block_type t_block;
+    const t_uindex block_bits = boost::dynamic_bitset<>::bits_per_block;
+
+    m_bitmap.reserve(t_msize(words.size() * 64));
+    for (auto word : words)
+    {
+        for (t_uindex shift = 0; shift < 64; shift += block_bits)
+        {
+            m_bitmap.append(t_block(word >> shift));
+        }
+    }
+    m_bitmap.resize(t_msize(size));
+    LOG_CONSTRUCTOR("t_mask");
+}
+
+std::vector<t_uint64>
+t_mask::get_words() const
+{
+    typedef boost::dynamic_bitset<>::block_type t_block;
+    const t_uindex block_bits = boost::dynamic_bitset<>::bits_per_block;
+
+    std::vector<t_block> blocks;
+    blocks.reserve(m_bitmap.num_blocks());
+    boost::to_block_range(m_bitmap, std::back_inserter(blocks));
+
+    std::vector<t_uint64> words((m_bitmap.size() + 63) / 64);
+    for (t_uindex idx = 0, loop_end = blocks.size(); idx < loop_end; ++idx)
+    {
+        t_uindex bit = idx * block_bits;
+        words[bit / 64] |= t_uint64(blocks[idx]) << (bit % 64);
+    }
+    return words;
+}
+
 t_mask::~t_mask() { LOG_DESTRUCTOR("t_mask"); }
 
 void
@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/order_stats.h>
+
+namespace perspective
+{
+
+bool
+t_order_key_less::operator()(const t_tscalar& a, const t_tscalar& b) const
+{
+    t_bool a_nan = a.is_nan();
+    t_bool b_nan = b.is_nan();
+
+    if ((a_nan || b_nan) && a.m_type == b.m_type && a.m_status == b.m_status)
+    {
+        return !a_nan && b_nan;
+    }
+
+    return a < b;
+}
+
+void
+t_order_stats::insert(
+    const t_tscalar& pkey, const t_tscalar& key, const t_tscalar& value)
+{
+    t_row row;
+    row.m_pkey = pkey;
+    row.m_key = key;
+    row.m_value = value;
+
+    auto& pkeys = m_rows.get<by_pkey>();
+    auto iter = pkeys.find(pkey);
+
+    if (iter == pkeys.end())
+    {
+        pkeys.insert(row);
+    }
+    else
+    {
+        t_bool replaced = pkeys.replace(iter, row);
+        PSP_UNUSED(replaced);
+        PSP_VERBOSE_ASSERT(replaced, "Failed to replace row");
+    }
+}
+
+void
+t_order_stats::erase(const t_tscalar& pkey)
+{
+    m_rows.get<by_pkey>().erase(pkey);
+}
+
+void
+t_order_stats::clear()
+{
+    m_rows.clear();
+}
+
+t_uindex
+t_order_stats::size() const
+{
+    return m_rows.size();
+}
+
+t_bool
+t_order_stats::empty() const
+{
+    return m_rows.empty();
+}
+
+t_tscalar
+t_order_stats::nth(t_uindex n) const
+{
+    if (n >= m_rows.size())
+        return mknone();
+
+    return m_rows.get<by_key>().nth(n)->m_value;
+}
+
+t_tscalar
+t_order_stats::min_value() const
+{
+    if (m_rows.empty())
+        return mknone();
+
+    const auto& keys = m_rows.get<by_key>();
+    auto iter = keys.upper_bound(boost::make_tuple(keys.begin()->m_key));
+    --iter;
+    return iter->m_value;
+}
+
+t_tscalar
+t_order_stats::max_value() const
+{
+    if (m_rows.empty())
+        return mknone();
+
+    return m_rows.get<by_key>().rbegin()->m_value;
+}
+
+} // end namespace perspective
@@ -0,0 +1,120 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/parallel.h>
+#include <perspective/env_vars.h>
+#include <atomic>
+#ifdef PSP_PARALLEL_FOR
+#include <tbb/global_control.h>
+#include <memory>
+#include <mutex>
+#endif
+
+namespace perspective
+{
+
+namespace
+{
+
+const t_uindex DEFAULT_PARALLEL_SORT_THRESHOLD = 1 << 15;
+
+std::atomic<t_uindex>&
+sort_threshold()
+{
+    static std::atomic<t_uindex> rv(t_env::parallel_sort_threshold() > 0
+            ? t_env::parallel_sort_threshold()
+            : DEFAULT_PARALLEL_SORT_THRESHOLD);
+    return rv;
+}
+
+} // namespace
+
+void
+set_parallel_sort_threshold(t_uindex nelems)
+{
+    sort_threshold().store(
+        nelems > 0 ? nelems : DEFAULT_PARALLEL_SORT_THRESHOLD);
+}
+
+t_uindex
+get_parallel_sort_threshold()
+{
+    return sort_threshold().load();
+}
+
+#ifdef PSP_PARALLEL_FOR
+
+namespace
+{
+
+std::mutex&
+limit_mutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+std::unique_ptr<tbb::global_control>&
+limit()
+{
+    static std::unique_ptr<tbb::global_control> rv;
+    return rv;
+}
+
+struct t_num_threads_init
+{
+    t_num_threads_init()
+    {
+        if (t_env::num_threads() > 0)
+            set_num_threads(t_env::num_threads());
+    }
+};
+
+const t_num_threads_init NUM_THREADS_INIT;
+
+} // namespace
+
+void
+set_num_threads(t_uindex nthreads)
+{
+    std::lock_guard<std::mutex> lk(limit_mutex());
+    limit().reset();
+    if (nthreads > 0)
+    {
+        limit().reset(new tbb::global_control(
+            tbb::global_control::max_allowed_parallelism, nthreads));
+    }
+}
+
+t_uindex
+get_num_threads()
+{
+    return tbb::global_control::active_value(
+        tbb::global_control::max_allowed_parallelism);
+}
+
+#else
+
+void
+set_num_threads(t_uindex nthreads)
+{
+    PSP_UNUSED(nthreads);
+}
+
+t_uindex
+get_num_threads()
+{
+    return 1;
+}
+
+#endif
+
+} // end namespace perspective
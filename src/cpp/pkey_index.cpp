@@ -0,0 +1,546 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/pkey_index.h>
+#include <perspective/column.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace perspective
+{
+
+namespace
+{
+
+const t_uindex EMPTY_SLOT = std::numeric_limits<t_uindex>::max();
+const t_uindex DELETED_SLOT = EMPTY_SLOT - 1;
+const t_uindex MIN_CAPACITY = 16;
+const t_uindex BATCH_SIZE = 16;
+
+const t_index XLAT_UNKNOWN = -1;
+const t_index XLAT_MISSING = -2;
+
+// splitmix64 finalizer, sequential keys would otherwise fill one run of
+// slots.
+inline t_uint64
+hash_key(t_uint64 key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+template <typename DATA_T>
+inline t_uint64
+to_raw_key(DATA_T v)
+{
+    return static_cast<t_uint64>(static_cast<t_int64>(v));
+}
+
+template <>
+inline t_uint64
+to_raw_key<t_uint64>(t_uint64 v)
+{
+    return v;
+}
+
+// Floats are keyed by bit pattern, like t_tscalar::operator==
+template <>
+inline t_uint64
+to_raw_key<t_float64>(t_float64 v)
+{
+    t_uint64 rv;
+    std::memcpy(&rv, &v, sizeof(rv));
+    return rv;
+}
+
+template <>
+inline t_uint64
+to_raw_key<t_float32>(t_float32 v)
+{
+    t_uint32 rv;
+    std::memcpy(&rv, &v, sizeof(rv));
+    return rv;
+}
+
+} // namespace
+
+t_pkey_index::t_pkey_index()
+    : m_dtype(DTYPE_NONE)
+    , m_vocab(nullptr)
+    , m_size(0)
+    , m_tombstones(0)
+    , m_mask(0)
+{
+}
+
+void
+t_pkey_index::init(t_dtype dtype, t_vocab* vocab)
+{
+    m_dtype = dtype;
+    m_vocab = vocab;
+    clear();
+}
+
+void
+t_pkey_index::set_vocab(t_vocab* vocab)
+{
+    PSP_VERBOSE_ASSERT(
+        m_size == 0, "Cannot change the vocabulary of a populated index");
+    m_vocab = vocab;
+}
+
+t_dtype
+t_pkey_index::get_dtype() const
+{
+    return m_dtype;
+}
+
+t_uindex
+t_pkey_index::size() const
+{
+    return m_size + m_foreign.size();
+}
+
+void
+t_pkey_index::clear()
+{
+    m_size = 0;
+    m_tombstones = 0;
+    m_mask = 0;
+    m_slots.clear();
+    m_slots.shrink_to_fit();
+    m_foreign.clear();
+}
+
+void
+t_pkey_index::reserve(t_uindex size)
+{
+    t_uindex capacity = MIN_CAPACITY;
+    while (capacity * 7 < size * 10)
+        capacity *= 2;
+
+    if (capacity > m_slots.size())
+        rehash(capacity);
+}
+
+t_bool
+t_pkey_index::is_foreign(const t_tscalar& pkey) const
+{
+    if (!pkey.is_valid() || pkey.get_dtype() != m_dtype)
+        return true;
+
+    switch (m_dtype)
+    {
+        case DTYPE_INT64:
+        case DTYPE_TIME:
+        case DTYPE_INT32:
+        case DTYPE_INT16:
+        case DTYPE_INT8:
+        case DTYPE_UINT64:
+        case DTYPE_UINT32:
+        case DTYPE_DATE:
+        case DTYPE_UINT16:
+        case DTYPE_UINT8:
+        case DTYPE_BOOL:
+        case DTYPE_FLOAT64:
+        case DTYPE_FLOAT32:
+            return false;
+        case DTYPE_STR:
+            return m_vocab == nullptr;
+        default:
+            return true;
+    }
+}
+
+t_bool
+t_pkey_index::to_key(const t_tscalar& pkey, t_uint64& key) const
+{
+    switch (m_dtype)
+    {
+        case DTYPE_INT64:
+        case DTYPE_TIME:
+            key = to_raw_key(pkey.m_data.m_int64);
+            break;
+        case DTYPE_INT32:
+            key = to_raw_key(pkey.m_data.m_int32);
+            break;
+        case DTYPE_INT16:
+            key = to_raw_key(pkey.m_data.m_int16);
+            break;
+        case DTYPE_INT8:
+            key = to_raw_key(pkey.m_data.m_int8);
+            break;
+        case DTYPE_UINT64:
+            key = to_raw_key(pkey.m_data.m_uint64);
+            break;
+        case DTYPE_UINT32:
+        case DTYPE_DATE:
+            key = to_raw_key(pkey.m_data.m_uint32);
+            break;
+        case DTYPE_UINT16:
+            key = to_raw_key(pkey.m_data.m_uint16);
+            break;
+        case DTYPE_UINT8:
+            key = to_raw_key(pkey.m_data.m_uint8);
+            break;
+        case DTYPE_BOOL:
+            key = to_raw_key(pkey.m_data.m_bool);
+            break;
+        case DTYPE_FLOAT64:
+            key = to_raw_key(pkey.m_data.m_float64);
+            break;
+        case DTYPE_FLOAT32:
+            key = to_raw_key(pkey.m_data.m_float32);
+            break;
+        case DTYPE_STR:
+        {
+            t_stridx interned;
+            if (!m_vocab->string_exists(pkey.get_char_ptr(), interned))
+                return false;
+            key = interned;
+        }
+        break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+t_uindex
+t_pkey_index::find_slot(t_uint64 key) const
+{
+    if (m_size == 0)
+        return m_slots.size();
+
+    for (t_uindex pos = hash_key(key) & m_mask;; pos = (pos + 1) & m_mask)
+    {
+        const t_slot& slot = m_slots[pos];
+        if (slot.m_idx == EMPTY_SLOT)
+            return m_slots.size();
+        if (slot.m_idx != DELETED_SLOT && slot.m_key == key)
+            return pos;
+    }
+}
+
+void
+t_pkey_index::rehash(t_uindex capacity)
+{
+    std::vector<t_slot> old(capacity, t_slot{0, EMPTY_SLOT});
+    std::swap(old, m_slots);
+    m_mask = capacity - 1;
+    m_tombstones = 0;
+
+    for (const auto& slot : old)
+    {
+        if (slot.m_idx == EMPTY_SLOT || slot.m_idx == DELETED_SLOT)
+            continue;
+
+        t_uindex pos = hash_key(slot.m_key) & m_mask;
+        while (m_slots[pos].m_idx != EMPTY_SLOT)
+            pos = (pos + 1) & m_mask;
+        m_slots[pos] = slot;
+    }
+}
+
+t_rlookup
+t_pkey_index::lookup(const t_tscalar& pkey) const
+{
+    if (is_foreign(pkey))
+    {
+        auto iter = m_foreign.find(pkey);
+        if (iter == m_foreign.end())
+            return t_rlookup(0, false);
+        return t_rlookup(iter->second, true);
+    }
+
+    t_uint64 key;
+    if (!to_key(pkey, key))
+        return t_rlookup(0, false);
+
+    t_uindex pos = find_slot(key);
+    if (pos == m_slots.size())
+        return t_rlookup(0, false);
+
+    return t_rlookup(m_slots[pos].m_idx, true);
+}
+
+void
+t_pkey_index::insert(const t_tscalar& pkey, t_uindex idx)
+{
+    if (is_foreign(pkey))
+    {
+        // The map keeps the scalar, string keys need storage of their own
+        auto interned = pkey.get_dtype() == DTYPE_STR
+            ? m_foreign_strings.get_interned_tscalar(pkey)
+            : pkey;
+        m_foreign[interned] = idx;
+        return;
+    }
+
+    t_uint64 key;
+    if (m_dtype == DTYPE_STR)
+    {
+        key = m_vocab->get_interned(pkey.get_char_ptr());
+    }
+    else
+    {
+        to_key(pkey, key);
+    }
+
+    // Keep the load, tombstones included, under 70%
+    if ((m_size + m_tombstones + 1) * 10 > m_slots.size() * 7)
+    {
+        t_uindex capacity = std::max(MIN_CAPACITY, t_uindex(m_slots.size()));
+        while ((m_size + 1) * 10 > capacity * 5)
+            capacity *= 2;
+        rehash(capacity);
+    }
+
+    t_uindex insert_pos = m_slots.size();
+    t_uindex pos = hash_key(key) & m_mask;
+    for (;; pos = (pos + 1) & m_mask)
+    {
+        t_slot& slot = m_slots[pos];
+        if (slot.m_idx == EMPTY_SLOT)
+            break;
+
+        if (slot.m_idx == DELETED_SLOT)
+        {
+            if (insert_pos == m_slots.size())
+                insert_pos = pos;
+            continue;
+        }
+
+        if (slot.m_key == key)
+        {
+            slot.m_idx = idx;
+            return;
+        }
+    }
+
+    if (insert_pos == m_slots.size())
+    {
+        insert_pos = pos;
+    }
+    else
+    {
+        --m_tombstones;
+    }
+
+    m_slots[insert_pos].m_key = key;
+    m_slots[insert_pos].m_idx = idx;
+    ++m_size;
+}
+
+t_bool
+t_pkey_index::erase(const t_tscalar& pkey, t_uindex& idx)
+{
+    if (is_foreign(pkey))
+    {
+        auto iter = m_foreign.find(pkey);
+        if (iter == m_foreign.end())
+            return false;
+        idx = iter->second;
+        m_foreign.erase(iter);
+        return true;
+    }
+
+    t_uint64 key;
+    if (!to_key(pkey, key))
+        return false;
+
+    t_uindex pos = find_slot(key);
+    if (pos == m_slots.size())
+        return false;
+
+    idx = m_slots[pos].m_idx;
+    m_slots[pos].m_idx = DELETED_SLOT;
+    --m_size;
+    ++m_tombstones;
+    return true;
+}
+
+template <typename DATA_T>
+void
+t_pkey_index::fill_keys(const t_column& pkeys, t_uindex bidx, t_uindex count,
+    t_uint64* keys, t_bool* found) const
+{
+    const DATA_T* base = pkeys.get_nth<DATA_T>(bidx);
+    for (t_uindex idx = 0; idx < count; ++idx)
+    {
+        keys[idx] = to_raw_key(base[idx]);
+    }
+
+    if (pkeys.is_status_enabled())
+    {
+        for (t_uindex idx = 0; idx < count; ++idx)
+        {
+            found[idx] = pkeys.is_valid(bidx + idx);
+        }
+    }
+    else
+    {
+        std::fill(found, found + count, true);
+    }
+}
+
+void
+t_pkey_index::fill_str_keys(const t_column& pkeys, t_uindex bidx,
+    t_uindex count, t_uint64* keys, t_bool* found,
+    std::vector<t_index>& xlat) const
+{
+    const t_uindex* base = pkeys.get_nth<t_uindex>(bidx);
+    for (t_uindex idx = 0; idx < count; ++idx)
+    {
+        keys[idx] = 0;
+        found[idx] = !pkeys.is_status_enabled() || pkeys.is_valid(bidx + idx);
+        if (!found[idx])
+            continue;
+
+        // Translate each distinct string of the incoming vocabulary once
+        t_uindex sidx = base[idx];
+        if (sidx >= xlat.size())
+            xlat.resize(sidx + 1, XLAT_UNKNOWN);
+
+        if (xlat[sidx] == XLAT_UNKNOWN)
+        {
+            t_stridx interned;
+            xlat[sidx]
+                = m_vocab->string_exists(pkeys.unintern_c(sidx), interned)
+                ? static_cast<t_index>(interned)
+                : XLAT_MISSING;
+        }
+
+        found[idx] = xlat[sidx] != XLAT_MISSING;
+        keys[idx] = static_cast<t_uint64>(xlat[sidx]);
+    }
+}
+
+void
+t_pkey_index::lookup_batch(
+    const t_column& pkeys, std::vector<t_rlookup>& out) const
+{
+    PSP_VERBOSE_ASSERT(
+        pkeys.get_dtype() == m_dtype, "Mismatched pkey index dtype");
+
+    t_uindex nrows = pkeys.size();
+    out.resize(nrows);
+
+    t_bool has_status = pkeys.is_status_enabled();
+
+    // Also the case for every key of a dtype the table can't hold
+    if (m_size == 0)
+    {
+        for (t_uindex idx = 0; idx < nrows; ++idx)
+        {
+            out[idx] = m_foreign.empty() ? t_rlookup(0, false)
+                                         : lookup(pkeys.get_scalar(idx));
+        }
+        return;
+    }
+
+    t_uint64 keys[BATCH_SIZE];
+    t_bool found[BATCH_SIZE];
+    t_uindex pos[BATCH_SIZE];
+    std::vector<t_index> xlat;
+
+    for (t_uindex bidx = 0; bidx < nrows; bidx += BATCH_SIZE)
+    {
+        t_uindex count = std::min(BATCH_SIZE, nrows - bidx);
+
+        switch (m_dtype)
+        {
+            case DTYPE_INT64:
+            case DTYPE_TIME:
+                fill_keys<t_int64>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_INT32:
+                fill_keys<t_int32>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_INT16:
+                fill_keys<t_int16>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_INT8:
+                fill_keys<t_int8>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_UINT64:
+                fill_keys<t_uint64>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_UINT32:
+            case DTYPE_DATE:
+                fill_keys<t_uint32>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_UINT16:
+                fill_keys<t_uint16>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_UINT8:
+            case DTYPE_BOOL:
+                fill_keys<t_uint8>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_FLOAT64:
+                fill_keys<t_float64>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_FLOAT32:
+                fill_keys<t_float32>(pkeys, bidx, count, keys, found);
+                break;
+            case DTYPE_STR:
+                fill_str_keys(pkeys, bidx, count, keys, found, xlat);
+                break;
+            default:
+            {
+                PSP_COMPLAIN_AND_ABORT("Unexpected pkey dtype");
+            }
+        }
+
+        for (t_uindex idx = 0; idx < count; ++idx)
+        {
+            pos[idx] = hash_key(keys[idx]) & m_mask;
+            PSP_PREFETCH(&m_slots[pos[idx]]);
+        }
+
+        for (t_uindex idx = 0; idx < count; ++idx)
+        {
+            t_rlookup& rv = out[bidx + idx];
+            rv.m_idx = 0;
+            rv.m_exists = false;
+
+            if (!found[idx])
+            {
+                // invalid rows are foreign keys, strings missing from the
+                // vocabulary were never inserted
+                if (has_status && !pkeys.is_valid(bidx + idx))
+                    rv = lookup(pkeys.get_scalar(bidx + idx));
+                continue;
+            }
+
+            for (t_uindex p = pos[idx];; p = (p + 1) & m_mask)
+            {
+                const t_slot& slot = m_slots[p];
+                if (slot.m_idx == EMPTY_SLOT)
+                    break;
+
+                if (slot.m_idx != DELETED_SLOT && slot.m_key == keys[idx])
+                {
+                    rv.m_idx = slot.m_idx;
+                    rv.m_exists = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+} // end namespace perspective
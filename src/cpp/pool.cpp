@@ -120,6 +120,31 @@ t_pool::send(t_uindex gnode_id, t_uindex port_id, const t_table& table)
     }
 }
 
+void
+t_pool::send(t_uindex gnode_id, t_uindex port_id, t_table_sptr table)
+{
+    std::lock_guard<std::mutex> lg(m_mtx);
+    m_data_remaining.store(true);
+
+    if (t_env::log_progress())
+    {
+        std::cout << "t_pool.send gnode_id => " << gnode_id
+                  << " port_id => " << port_id << " tbl_size => "
+                  << table->size() << std::endl;
+    }
+
+    if (t_env::log_data_pool_send())
+    {
+        std::cout << "t_pool.send" << std::endl;
+        table->pprint();
+    }
+
+    if (m_gnodes[gnode_id])
+    {
+        m_gnodes[gnode_id]->_send(port_id, std::move(table));
+    }
+}
+
 void
 t_pool::_process_helper()
 {
@@ -408,6 +433,25 @@ t_pool::get_gnodes_last_updated()
     return rv;
 }
 
+void
+t_pool::set_gnode_processed_callback(t_gnode_processed_cb cb)
+{
+    m_gnode_processed_cb = cb;
+}
+
+void
+t_pool::notify_gnode_processed(t_uindex gnode_id)
+{
+    if (t_env::log_progress())
+    {
+        std::cout << "t_pool.notify_gnode_processed gnode_id => " << gnode_id
+                  << std::endl;
+    }
+
+    if (m_gnode_processed_cb)
+        m_gnode_processed_cb(gnode_id);
+}
+
 t_gnode*
 t_pool::get_gnode(t_uindex idx)
 {
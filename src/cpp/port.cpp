@@ -9,14 +9,26 @@
 
 #include <perspective/first.h>
 #include <perspective/port.h>
+#include <perspective/vocab.h>
+#include <algorithm>
 
 namespace perspective
 {
 
+namespace
+{
+
+// A released table is reallocated once it is this many times larger than
+// the batches it has recently held.
+const t_uindex PORT_SHRINK_FACTOR = 4;
+
+} // namespace
+
 t_port::t_port(const t_schema& schema)
     : m_schema(schema)
     , m_init(false)
     , m_table(nullptr)
+    , m_pending(nullptr)
     , m_prevsize(0)
 {
     LOG_CONSTRUCTOR("t_port");
@@ -27,13 +39,20 @@ t_port::~t_port() { LOG_DESTRUCTOR("t_port"); }
 void
 t_port::init()
 {
-    m_table = nullptr;
-    m_table = std::make_shared<t_table>(
-        "", "", m_schema, DEFAULT_EMPTY_CAPACITY, BACKING_STORE_MEMORY);
-    m_table->init();
+    m_table = make_table(DEFAULT_EMPTY_CAPACITY);
+    m_pending = nullptr;
     m_init = true;
 }
 
+t_table_sptr
+t_port::make_table(t_uindex capacity) const
+{
+    auto rv = std::make_shared<t_table>(
+        "", "", m_schema, capacity, BACKING_STORE_MEMORY);
+    rv->init();
+    return rv;
+}
+
 t_table_sptr
 t_port::get_table()
 {
@@ -50,13 +69,52 @@ t_port::set_table(t_table_sptr table)
 void
 t_port::send(t_table_csptr table)
 {
-    m_table->append(*table.get());
+    send(*table.get());
 }
 
 void
 t_port::send(const t_table& table)
 {
-    m_table->append(table);
+    // Only input ports have a pending batch, it is created on first use
+    if (!m_pending)
+        m_pending = make_table(
+            std::max<t_uindex>(table.size(), DEFAULT_EMPTY_CAPACITY));
+    m_pending->append(table);
+}
+
+void
+t_port::send(t_table_sptr table)
+{
+    if (get_pending_size() == 0 && table->get_schema() == m_schema)
+    {
+        m_pending = table;
+        return;
+    }
+    send(*table.get());
+}
+
+t_bool
+t_port::swap()
+{
+    if (get_pending_size() > 0)
+    {
+        if (m_table->size() == 0)
+        {
+            std::swap(m_table, m_pending);
+        }
+        else
+        {
+            m_table->append(*m_pending);
+            m_pending->clear();
+        }
+    }
+    return m_table->size() > 0;
+}
+
+t_uindex
+t_port::get_pending_size() const
+{
+    return m_pending ? m_pending->size() : 0;
 }
 
 t_schema
@@ -65,42 +123,66 @@ t_port::get_schema() const
     return m_schema;
 }
 
+t_bool
+t_port::is_oversized(t_uindex nrows) const
+{
+    t_uindex bound =
+        PORT_SHRINK_FACTOR * std::max<t_uindex>(nrows, DEFAULT_EMPTY_CAPACITY);
+
+    if (m_table->get_capacity() > bound)
+        return true;
+
+    // Clearing a string column keeps its vocabulary, which would otherwise
+    // grow with every distinct string ever sent.
+    for (const auto& cname : m_schema.m_columns)
+    {
+        auto col = m_table->get_const_column(cname);
+        if (col->get_dtype() == DTYPE_STR
+            && col->_get_vocab()->get_vlenidx() > bound)
+            return true;
+    }
+
+    return false;
+}
+
 void
 t_port::release()
-
 {
     if (!m_table.get())
         return;
 
     t_uindex size = m_table->size();
-
-    m_table = nullptr;
-    m_table = std::make_shared<t_table>(
-        "", "", m_schema, DEFAULT_EMPTY_CAPACITY, BACKING_STORE_MEMORY);
-    m_table->init();
-
+    m_table->clear();
     m_prevsize = size;
 }
 
 void
 t_port::release_or_clear()
-
 {
     if (!m_table.get())
         return;
 
     t_uindex size = m_table->size();
 
-    if (static_cast<t_float64>(size) < 0.4 * t_float64(m_prevsize))
+    if (is_oversized(std::max(size, m_prevsize)))
     {
-        m_table->clear();
+        m_table = make_table(std::max(size, m_prevsize));
     }
     else
     {
-        release();
+        m_table->clear();
     }
 
     m_prevsize = size;
 }
 
+void
+t_port::clear()
+{
+    if (m_table)
+        m_table->clear();
+    if (m_pending)
+        m_pending->clear();
+}
+
 } // end namespace perspective
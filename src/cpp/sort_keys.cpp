@@ -0,0 +1,474 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/multi_sort.h>
+#include <perspective/sort_keys.h>
+#include <cmath>
+#include <cstring>
+
+namespace perspective
+{
+
+namespace
+{
+
+// Tag byte, then 8 value bytes
+const t_uindex KEY_WIDTH = 9;
+const t_uindex MAX_ENCODED_COLUMNS = 8;
+
+const t_uint8 TAG_NAN_FIRST = 0;
+const t_uint8 TAG_VALUE = 1;
+const t_uint8 TAG_NAN_LAST = 2;
+
+const t_uint64 SIGN_BIT = t_uint64(1) << 63;
+
+inline t_uint64
+float_bits(t_float64 v)
+{
+    t_uint64 bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return (bits & SIGN_BIT) ? ~bits : bits ^ SIGN_BIT;
+}
+
+inline t_uint64
+signed_bits(t_int64 v)
+{
+    return t_uint64(v) ^ SIGN_BIT;
+}
+
+// Whether column keys of dtype can be encoded, and if so whether the byte
+// keys only tie for equal keys.
+inline t_bool
+is_encodable(t_dtype dtype, t_sorttype order, t_bool& exact)
+{
+    switch (order)
+    {
+        case SORTTYPE_ASCENDING:
+        case SORTTYPE_DESCENDING:
+        {
+            exact = dtype != DTYPE_STR;
+        }
+        break;
+        case SORTTYPE_ASCENDING_ABS:
+        case SORTTYPE_DESCENDING_ABS:
+        {
+            exact = false;
+            if (dtype == DTYPE_STR || dtype == DTYPE_BOOL)
+                return false;
+        }
+        break;
+        default:
+            return false;
+    }
+
+    switch (dtype)
+    {
+        case DTYPE_INT64:
+        case DTYPE_INT32:
+        case DTYPE_INT16:
+        case DTYPE_INT8:
+        case DTYPE_UINT64:
+        case DTYPE_UINT32:
+        case DTYPE_UINT16:
+        case DTYPE_UINT8:
+        case DTYPE_FLOAT64:
+        case DTYPE_FLOAT32:
+        case DTYPE_DATE:
+        case DTYPE_TIME:
+        case DTYPE_BOOL:
+        case DTYPE_STR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <typename DATA_T>
+inline t_cmp_op
+cmp_raw(DATA_T a, DATA_T b, t_sorttype order)
+{
+    t_bool less = order == SORTTYPE_ASCENDING ? a < b : a > b;
+    return less ? CMP_OP_LT : CMP_OP_GT;
+}
+
+} // namespace
+
+t_sort_keys::t_sort_keys()
+    : m_handle_nans(false)
+    , m_nencoded(0)
+    , m_nexact(0)
+{
+}
+
+void
+t_sort_keys::init(const std::vector<t_sorttype>& order, t_bool handle_nans,
+    const std::vector<t_dtype>& dtypes)
+{
+    m_order = order;
+    m_handle_nans = handle_nans;
+    m_keys.clear();
+    m_keys.resize(order.size());
+    m_pkeys.clear();
+    m_free.clear();
+    m_dtypes = dtypes;
+    m_bytes.clear();
+    m_encoded.clear();
+    m_nencoded = 0;
+    m_nexact = 0;
+
+    t_uindex ncols = std::min(dtypes.size(), order.size());
+
+    while (m_nencoded < ncols && m_nencoded < MAX_ENCODED_COLUMNS)
+    {
+        t_bool exact = false;
+        if (!is_encodable(dtypes[m_nencoded], order[m_nencoded], exact))
+            break;
+        ++m_nencoded;
+        if (!exact)
+            break;
+        ++m_nexact;
+    }
+}
+
+void
+t_sort_keys::clear()
+{
+    for (auto& keys : m_keys)
+    {
+        keys.clear();
+    }
+    m_pkeys.clear();
+    m_free.clear();
+    m_bytes.clear();
+    m_encoded.clear();
+}
+
+t_uindex
+t_sort_keys::alloc(const t_tscalar& pkey)
+{
+    t_uindex slot;
+
+    if (m_free.empty())
+    {
+        slot = m_pkeys.size();
+        m_pkeys.push_back(pkey);
+        for (auto& keys : m_keys)
+        {
+            keys.push_back(mknone());
+        }
+        m_bytes.resize(m_bytes.size() + m_nencoded * KEY_WIDTH);
+        m_encoded.push_back(0);
+    }
+    else
+    {
+        slot = m_free.back();
+        m_free.pop_back();
+        m_pkeys[slot] = pkey;
+        m_encoded[slot] = 0;
+    }
+
+    return slot;
+}
+
+void
+t_sort_keys::release(t_uindex slot)
+{
+    m_free.push_back(slot);
+}
+
+t_uindex
+t_sort_keys::get_num_columns() const
+{
+    return m_keys.size();
+}
+
+const std::vector<t_sorttype>&
+t_sort_keys::get_sort_order() const
+{
+    return m_order;
+}
+
+const t_tscalar&
+t_sort_keys::get_pkey(t_uindex slot) const
+{
+    return m_pkeys[slot];
+}
+
+const t_tscalar&
+t_sort_keys::get_key(t_uindex col, t_uindex slot) const
+{
+    return m_keys[col][slot];
+}
+
+void
+t_sort_keys::set_key(t_uindex col, t_uindex slot, const t_tscalar& key)
+{
+    m_keys[col][slot] = key;
+
+    if (col >= m_nencoded)
+        return;
+
+    t_uint8* out = &m_bytes[(slot * m_nencoded + col) * KEY_WIDTH];
+    t_uint8 bit = t_uint8(1) << col;
+
+    if (encode(col, key, out))
+        m_encoded[slot] |= bit;
+    else
+        m_encoded[slot] &= ~bit;
+}
+
+t_uindex
+t_sort_keys::get_num_encoded_columns() const
+{
+    return m_nencoded;
+}
+
+t_bool
+t_sort_keys::encode(t_uindex col, const t_tscalar& key, t_uint8* out) const
+{
+    t_dtype dtype = m_dtypes[col];
+    t_sorttype order = m_order[col];
+
+    if (key.m_type != dtype || key.m_status != STATUS_VALID)
+        return false;
+
+    t_bool abs = order == SORTTYPE_ASCENDING_ABS
+        || order == SORTTYPE_DESCENDING_ABS;
+    t_bool descending
+        = order == SORTTYPE_DESCENDING || order == SORTTYPE_DESCENDING_ABS;
+
+    t_uint8 tag = TAG_VALUE;
+    t_uint64 bits = 0;
+
+    if (abs || dtype == DTYPE_FLOAT64 || dtype == DTYPE_FLOAT32)
+    {
+        t_float64 v = key.to_double();
+        if (std::isnan(v))
+        {
+            // Tracked NaNs come first in ascending orders and last in
+            // descending ones, otherwise they don't order at all.
+            if (!m_handle_nans)
+                return false;
+            tag = descending ? TAG_NAN_LAST : TAG_NAN_FIRST;
+        }
+        else
+        {
+            bits = float_bits(abs ? std::abs(v) : v);
+        }
+    }
+    else
+    {
+        switch (dtype)
+        {
+            case DTYPE_INT64:
+            case DTYPE_TIME:
+                bits = signed_bits(key.m_data.m_int64);
+                break;
+            case DTYPE_INT32:
+                bits = signed_bits(key.m_data.m_int32);
+                break;
+            case DTYPE_INT16:
+                bits = signed_bits(key.m_data.m_int16);
+                break;
+            case DTYPE_INT8:
+                bits = signed_bits(key.m_data.m_int8);
+                break;
+            case DTYPE_UINT64:
+                bits = key.m_data.m_uint64;
+                break;
+            case DTYPE_UINT32:
+            case DTYPE_DATE:
+                bits = key.m_data.m_uint32;
+                break;
+            case DTYPE_UINT16:
+                bits = key.m_data.m_uint16;
+                break;
+            case DTYPE_UINT8:
+                bits = key.m_data.m_uint8;
+                break;
+            case DTYPE_BOOL:
+                bits = key.m_data.m_bool ? 1 : 0;
+                break;
+            case DTYPE_STR:
+            {
+                // strcmp orders on unsigned chars, so does memcmp
+                const char* str = key.get_char_ptr();
+                for (t_uindex idx = 0; idx < 8 && str[idx]; ++idx)
+                {
+                    bits |= t_uint64(t_uint8(str[idx])) << (56 - 8 * idx);
+                }
+            }
+            break;
+            default:
+                return false;
+        }
+    }
+
+    if (tag == TAG_VALUE && descending)
+        bits = ~bits;
+
+    out[0] = tag;
+    for (t_uindex idx = 0; idx < 8; ++idx)
+    {
+        out[idx + 1] = t_uint8(bits >> (56 - 8 * idx));
+    }
+
+    return true;
+}
+
+t_uindex
+t_sort_keys::get_num_encoded(t_uindex slot) const
+{
+    t_uint8 mask = m_encoded[slot];
+    t_uindex n = 0;
+    while (n < m_nencoded && (mask >> n) & 1)
+    {
+        ++n;
+    }
+    return n;
+}
+
+t_cmp_op
+t_sort_keys::compare(const t_tscalar& a, const t_tscalar& b,
+    const t_tscalar& a_pkey, const t_tscalar& b_pkey, t_sorttype order) const
+{
+    // Keys of the same numeric dtype and status compare like their raw
+    // values once NaNs are out of the way, anything else goes through the
+    // generic comparison.
+    if (a.m_type != b.m_type || a.m_status != b.m_status
+        || (order != SORTTYPE_ASCENDING && order != SORTTYPE_DESCENDING))
+    {
+        return cmp_sort_key(a, b, a_pkey, b_pkey, order, m_handle_nans);
+    }
+
+    switch (a.m_type)
+    {
+        case DTYPE_INT64:
+        case DTYPE_TIME:
+        case DTYPE_INT32:
+        case DTYPE_INT16:
+        case DTYPE_INT8:
+        case DTYPE_UINT64:
+        case DTYPE_UINT32:
+        case DTYPE_UINT16:
+        case DTYPE_UINT8:
+        case DTYPE_DATE:
+        {
+            if (a.m_data.m_uint64 == b.m_data.m_uint64)
+                return CMP_OP_EQ;
+        }
+        break;
+        case DTYPE_FLOAT64:
+        {
+            if (std::isnan(a.m_data.m_float64)
+                || std::isnan(b.m_data.m_float64))
+                break;
+            if (a.m_data.m_uint64 == b.m_data.m_uint64)
+                return CMP_OP_EQ;
+            return cmp_raw(a.m_data.m_float64, b.m_data.m_float64, order);
+        }
+        break;
+        case DTYPE_FLOAT32:
+        {
+            if (std::isnan(a.m_data.m_float32)
+                || std::isnan(b.m_data.m_float32))
+                break;
+            if (a.m_data.m_uint64 == b.m_data.m_uint64)
+                return CMP_OP_EQ;
+            return cmp_raw(a.m_data.m_float32, b.m_data.m_float32, order);
+        }
+        break;
+        default:
+            break;
+    }
+
+    switch (a.m_type)
+    {
+        case DTYPE_INT64:
+        case DTYPE_TIME:
+            return cmp_raw(a.m_data.m_int64, b.m_data.m_int64, order);
+        case DTYPE_INT32:
+            return cmp_raw(a.m_data.m_int32, b.m_data.m_int32, order);
+        case DTYPE_INT16:
+            return cmp_raw(a.m_data.m_int16, b.m_data.m_int16, order);
+        case DTYPE_INT8:
+            return cmp_raw(a.m_data.m_int8, b.m_data.m_int8, order);
+        case DTYPE_UINT64:
+            return cmp_raw(a.m_data.m_uint64, b.m_data.m_uint64, order);
+        case DTYPE_UINT32:
+        case DTYPE_DATE:
+            return cmp_raw(a.m_data.m_uint32, b.m_data.m_uint32, order);
+        case DTYPE_UINT16:
+            return cmp_raw(a.m_data.m_uint16, b.m_data.m_uint16, order);
+        case DTYPE_UINT8:
+            return cmp_raw(a.m_data.m_uint8, b.m_data.m_uint8, order);
+        default:
+            return cmp_sort_key(a, b, a_pkey, b_pkey, order, m_handle_nans);
+    }
+}
+
+t_bool
+t_sort_keys::less(t_uindex a, t_uindex b) const
+{
+    const t_tscalar& a_pkey = m_pkeys[a];
+    const t_tscalar& b_pkey = m_pkeys[b];
+
+    t_uindex first_col = 0;
+
+    if (m_nencoded > 0)
+    {
+        t_uindex nencoded
+            = std::min(get_num_encoded(a), get_num_encoded(b));
+
+        if (nencoded > 0)
+        {
+            int cmp = std::memcmp(&m_bytes[a * m_nencoded * KEY_WIDTH],
+                &m_bytes[b * m_nencoded * KEY_WIDTH], nencoded * KEY_WIDTH);
+            if (cmp != 0)
+                return cmp < 0;
+
+            // Equal exact byte keys mean equal keys, the scalars only need
+            // comparing from the first inexact column on.
+            first_col = std::min(nencoded, m_nexact);
+        }
+    }
+
+    for (t_uindex cidx = first_col, loop_end = m_keys.size(); cidx < loop_end;
+         ++cidx)
+    {
+        const t_tscalvec& keys = m_keys[cidx];
+        t_cmp_op cmp
+            = compare(keys[a], keys[b], a_pkey, b_pkey, m_order[cidx]);
+        if (cmp != CMP_OP_EQ)
+            return cmp == CMP_OP_LT;
+    }
+
+    return a_pkey < b_pkey;
+}
+
+t_bool
+t_sort_keys::less(
+    t_uindex a, const t_tscalvec& keys, const t_tscalar& pkey) const
+{
+    const t_tscalar& a_pkey = m_pkeys[a];
+
+    for (t_uindex cidx = 0, loop_end = m_keys.size(); cidx < loop_end; ++cidx)
+    {
+        t_cmp_op cmp
+            = compare(m_keys[cidx][a], keys[cidx], a_pkey, pkey, m_order[cidx]);
+        if (cmp != CMP_OP_EQ)
+            return cmp == CMP_OP_LT;
+    }
+
+    return a_pkey < pkey;
+}
+
+} // end namespace perspective
@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <sstream>
 #include <perspective/base.h>
 #include <perspective/compat.h>
 #include <perspective/extract_aggregate.h>
@@ -25,6 +26,7 @@
 #include <perspective/table.h>
 #include <perspective/filter_utils.h>
 #include <perspective/context_two.h>
+#include <perspective/order_stats.h>
 #include <unordered_set>
 #include <cstdlib>
 #include <boost/multi_index_container.hpp>
@@ -122,6 +124,7 @@ struct t_stree::t_stree_p
     t_symtable m_symtable;
     t_bool m_has_delta;
     t_str m_grand_agg_str;
+    std::unordered_map<t_uindex, std::vector<t_order_stats>> m_order_stats;
 };
 
 t_stree::t_stree_p::t_stree_p(const t_pivotvec& pivots,
@@ -248,6 +251,19 @@ t_stree::t_stree_p::init()
         }
     }
 
+    m_aggcols = t_colcptrvec(columns.size());
+
+    // Hidden running (finite sum, NaN count) pairs go after the aggregates
+    // so aggregate column indices are unchanged.
+    for (const auto& spec : m_aggspecs)
+    {
+        if (spec.is_nan_tracked_sum(m_schema))
+        {
+            columns.push_back(spec.get_nan_sum_colname());
+            dtypes.push_back(DTYPE_F64PAIR);
+        }
+    }
+
     t_schema schema(columns, dtypes);
 
     t_uindex capacity = DEFAULT_EMPTY_CAPACITY;
@@ -255,9 +271,7 @@ t_stree::t_stree_p::init()
     m_aggregates->init();
     m_aggregates->set_size(capacity);
 
-    m_aggcols = t_colcptrvec(columns.size());
-
-    for (t_uindex idx = 0, loop_end = columns.size(); idx < loop_end; ++idx)
+    for (t_uindex idx = 0, loop_end = m_aggcols.size(); idx < loop_end; ++idx)
     {
         m_aggcols[idx] = m_aggregates->get_const_column(columns[idx]).get();
     }
@@ -409,6 +423,174 @@ t_stree::build_strand_table_phase_2(t_tscalar pkey, t_uindex idx,
     ++insert_count;
 }
 
+namespace
+{
+
+// Columns feeding the strand delta pair of one mean or NaN tracked sum
+// aggregate. Incremental C++ reducers carry no pair, m_out receives the
+// value a strand retracts and m_out_combine the value it combines instead.
+struct t_pair_delta_cols
+{
+    t_aggtype m_agg;
+    const t_column* m_pvalue;
+    const t_column* m_pweight;
+    const t_column* m_cvalue;
+    const t_column* m_cweight;
+    t_column* m_out;
+    t_column* m_out_combine;
+};
+
+// Contribution of row idx to an aggregate's pair. Plain means count valid
+// values, weighted means treat null values and weights as zero and sums
+// split the value into its finite part and a NaN count.
+t_f64pair
+pair_term(t_aggtype agg, const t_column* value, const t_column* weight,
+    t_uindex idx)
+{
+    t_tscalar v = value->get_scalar(idx);
+    switch (agg)
+    {
+        case AGGTYPE_MEAN:
+        {
+            return v.is_valid() ? t_f64pair(v.to_double(), 1)
+                                : t_f64pair(0, 0);
+        }
+        case AGGTYPE_WEIGHTED_MEAN:
+        {
+            t_tscalar w = weight->get_scalar(idx);
+            t_float64 vv = v.is_valid() ? v.to_double() : 0;
+            t_float64 wv = w.is_valid() ? w.to_double() : 0;
+            return t_f64pair(wv * vv, wv);
+        }
+        default:
+        {
+            if (!v.is_valid())
+                return t_f64pair(0, 0);
+            t_float64 vv = v.to_double();
+            return std::isnan(vv) ? t_f64pair(0, 1) : t_f64pair(vv, 0);
+        }
+    }
+}
+
+std::vector<t_pair_delta_cols>
+mk_pair_delta_cols(const t_aggspecvec& specs, const t_table& prev,
+    const t_table& current, t_table& aggs)
+{
+    std::vector<t_pair_delta_cols> rval;
+    for (const auto& spec : specs)
+    {
+        const t_depvec& deps = spec.get_dependencies();
+        t_bool weighted = spec.agg() == AGGTYPE_WEIGHTED_MEAN;
+        const t_str& wname = deps[weighted ? 1 : 0].name();
+        t_str colname = spec.is_mean_agg() ? spec.get_mean_delta_colname()
+                                           : spec.get_nan_sum_colname();
+
+        t_pair_delta_cols cols;
+        cols.m_agg = spec.agg();
+        cols.m_pvalue = prev.get_const_column(deps[0].name()).get();
+        cols.m_pweight = prev.get_const_column(wname).get();
+        cols.m_cvalue = current.get_const_column(deps[0].name()).get();
+        cols.m_cweight = current.get_const_column(wname).get();
+        cols.m_out_combine = 0;
+
+        if (spec.agg() == AGGTYPE_UDF_CPP_REDUCE_FLOAT64)
+        {
+            cols.m_out = aggs.add_column(
+                spec.get_udf_retract_colname(), DTYPE_FLOAT64, true);
+            cols.m_out_combine = aggs.add_column(
+                spec.get_udf_combine_colname(), DTYPE_FLOAT64, true);
+        }
+        else
+        {
+            cols.m_out = aggs.add_column(colname, DTYPE_F64PAIR, true);
+        }
+        rval.push_back(cols);
+    }
+    return rval;
+}
+
+void
+push_udf_value(t_column* out, const t_column* value, t_uindex idx)
+{
+    if (value)
+    {
+        t_tscalar v = value->get_scalar(idx);
+        if (v.is_valid())
+        {
+            out->push_back<t_float64>(v.to_double(), STATUS_VALID);
+            return;
+        }
+    }
+
+    out->push_back<t_float64>(0, STATUS_INVALID);
+}
+
+// Appends csign * current + psign * prev for row idx to every strand delta
+// pair column. Reducers retract the negated side and combine current.
+void
+push_pair_deltas(std::vector<t_pair_delta_cols>& pairs, t_uindex idx,
+    t_float64 csign, t_float64 psign)
+{
+    for (auto& p : pairs)
+    {
+        if (p.m_out_combine)
+        {
+            const t_column* retract = 0;
+            if (csign < 0)
+            {
+                retract = p.m_cvalue;
+            }
+            else if (psign < 0)
+            {
+                retract = p.m_pvalue;
+            }
+
+            push_udf_value(p.m_out, retract, idx);
+            push_udf_value(p.m_out_combine, csign > 0 ? p.m_cvalue : 0, idx);
+            continue;
+        }
+
+        t_f64pair delta(0, 0);
+        if (csign != 0)
+        {
+            t_f64pair t = pair_term(p.m_agg, p.m_cvalue, p.m_cweight, idx);
+            delta.first += csign * t.first;
+            delta.second += csign * t.second;
+        }
+
+        if (psign != 0)
+        {
+            t_f64pair t = pair_term(p.m_agg, p.m_pvalue, p.m_pweight, idx);
+            delta.first += psign * t.first;
+            delta.second += psign * t.second;
+        }
+
+        p.m_out->push_back<t_f64pair>(delta, STATUS_VALID);
+    }
+}
+
+// Delta of a phase 1 strand: deletes retract the row, rows moving into a
+// node bring their whole value and updates in place bring the difference.
+void
+push_pair_deltas_phase_1(std::vector<t_pair_delta_cols>& pairs, t_uindex idx,
+    t_op op, t_bool pivots_neq, t_bool force_current_row)
+{
+    if (op == OP_DELETE)
+    {
+        push_pair_deltas(pairs, idx, -1, 0);
+    }
+    else if (pivots_neq || force_current_row)
+    {
+        push_pair_deltas(pairs, idx, 1, 0);
+    }
+    else
+    {
+        push_pair_deltas(pairs, idx, 1, -1);
+    }
+}
+
+} // namespace
+
 t_build_strand_table_common_rval
 t_stree::build_strand_table_common(const t_table& flattened,
     const t_aggspecvec& aggspecs, const t_config& config) const
@@ -444,6 +626,26 @@ t_stree::build_strand_table_common(const t_table& flattened,
     std::set<t_str> aggcolset;
     for (const auto& aggspec : aggspecs)
     {
+        if (aggspec.is_mean_agg())
+        {
+            rv.m_pair_aggspecs.push_back(aggspec);
+            continue;
+        }
+
+        // C++ reducers read the gnode state, or their own strand columns
+        // when incremental
+        if (aggspec.agg() == AGGTYPE_UDF_CPP_REDUCE_FLOAT64)
+        {
+            if (aggspec.is_incremental_udf())
+                rv.m_pair_aggspecs.push_back(aggspec);
+            continue;
+        }
+
+        if (aggspec.is_nan_tracked_sum(rv.m_flattened_schema))
+        {
+            rv.m_pair_aggspecs.push_back(aggspec);
+        }
+
         for (const auto& dep : aggspec.get_dependencies())
         {
             if (dep.type() == DEPTYPE_COLUMN)
@@ -477,12 +679,50 @@ t_stree::build_strand_table_common(const t_table& flattened,
     return rv;
 }
 
+t_str
+t_stree::get_strand_key(const t_table& flattened,
+    const t_aggspecvec& aggspecs, const t_config& config) const
+{
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_p->m_init, "touching uninited object");
+
+    auto rv = build_strand_table_common(flattened, aggspecs, config);
+
+    // Names are length prefixed, they may contain any character
+    std::stringstream ss;
+    ss << rv.m_pivsize;
+    for (const auto& cname : rv.m_pivot_like_columns)
+    {
+        ss << ' ' << cname.size() << ':' << cname;
+    }
+
+    ss << '\n';
+    for (const auto& cname : rv.m_aggschema.m_columns)
+    {
+        ss << ' ' << cname.size() << ':' << cname;
+    }
+
+    // Their strand delta columns are named after the aggregate
+    for (const auto& spec : rv.m_pair_aggspecs)
+    {
+        t_str name = spec.name();
+        ss << '\n' << spec.agg() << ' ' << name.size() << ':' << name;
+        for (const auto& dep : spec.get_dependencies())
+        {
+            ss << ' ' << dep.name().size() << ':' << dep.name();
+        }
+    }
+
+    return ss.str();
+}
+
 // can contain additional rows
 // notably pivot changed rows will be added
 std::pair<t_table_sptr, t_table_sptr>
 t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
     const t_table& prev, const t_table& current, const t_table& transitions,
-    const t_aggspecvec& aggspecs, const t_config& config) const
+    const t_aggspecvec& aggspecs, const t_config& config,
+    t_filter_cache* filter_cache) const
 {
 
     PSP_TRACE_SENTINEL();
@@ -498,6 +738,9 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
     t_table_sptr aggs = std::make_shared<t_table>(rv.m_aggschema);
     aggs->init();
 
+    auto pairs
+        = mk_pair_delta_cols(rv.m_pair_aggspecs, prev, current, *aggs);
+
     t_col_csptr pkey_col = flattened.get_const_column("psp_pkey");
     t_col_csptr op_col = flattened.get_const_column("psp_op");
 
@@ -554,8 +797,10 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
 
     if (config.has_filters())
     {
-        msk_prev = filter_table_for_config(prev, config);
-        msk_curr = filter_table_for_config(current, config);
+        msk_prev
+            = filter_table_for_config(prev, config, nullptr, filter_cache);
+        msk_curr
+            = filter_table_for_config(current, config, nullptr, filter_cache);
     }
 
     t_bool has_filters = config.has_filters();
@@ -585,6 +830,7 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
                     strand_count_idx, aggcolsize, true, piv_ccols, piv_tcols,
                     agg_ccols, agg_dcols, piv_scols, agg_acols, agg_scount,
                     spkey, insert_count, pivots_neq, rv.m_pivot_like_columns);
+                push_pair_deltas_phase_1(pairs, idx, op, pivots_neq, true);
             }
             else if (filter_prev && !filter_curr)
             {
@@ -593,6 +839,7 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
                     strand_count_idx, aggcolsize, piv_pcols, agg_pcols,
                     piv_scols, agg_acols, agg_scount, spkey, insert_count,
                     rv.m_pivot_like_columns);
+                push_pair_deltas(pairs, idx, 0, -1);
             }
             else if (filter_prev && filter_curr)
             {
@@ -601,6 +848,7 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
                     strand_count_idx, aggcolsize, false, piv_ccols, piv_tcols,
                     agg_ccols, agg_dcols, piv_scols, agg_acols, agg_scount,
                     spkey, insert_count, pivots_neq, rv.m_pivot_like_columns);
+                push_pair_deltas_phase_1(pairs, idx, op, pivots_neq, false);
 
                 if (op == OP_DELETE || !pivots_neq)
                 {
@@ -611,6 +859,7 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
                     strand_count_idx, aggcolsize, piv_pcols, agg_pcols,
                     piv_scols, agg_acols, agg_scount, spkey, insert_count,
                     rv.m_pivot_like_columns);
+                push_pair_deltas(pairs, idx, 0, -1);
             }
         }
     }
@@ -629,6 +878,7 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
                 strand_count_idx, aggcolsize, false, piv_ccols, piv_tcols,
                 agg_ccols, agg_dcols, piv_scols, agg_acols, agg_scount, spkey,
                 insert_count, pivots_neq, rv.m_pivot_like_columns);
+            push_pair_deltas_phase_1(pairs, idx, op, pivots_neq, false);
 
             if (op == OP_DELETE || !pivots_neq)
             {
@@ -639,6 +889,7 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
                 strand_count_idx, aggcolsize, piv_pcols, agg_pcols, piv_scols,
                 agg_acols, agg_scount, spkey, insert_count,
                 rv.m_pivot_like_columns);
+            push_pair_deltas(pairs, idx, 0, -1);
         }
     }
 
@@ -654,7 +905,8 @@ t_stree::build_strand_table(const t_table& flattened, const t_table& delta,
 // notably pivot changed rows will be added
 std::pair<t_table_sptr, t_table_sptr>
 t_stree::build_strand_table(const t_table& flattened,
-    const t_aggspecvec& aggspecs, const t_config& config) const
+    const t_aggspecvec& aggspecs, const t_config& config,
+    t_filter_cache* filter_cache) const
 {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_p->m_init, "touching uninited object");
@@ -669,6 +921,9 @@ t_stree::build_strand_table(const t_table& flattened,
     t_table_sptr aggs = std::make_shared<t_table>(rv.m_aggschema);
     aggs->init();
 
+    auto pairs
+        = mk_pair_delta_cols(rv.m_pair_aggspecs, flattened, flattened, *aggs);
+
     t_col_csptr pkey_col = flattened.get_const_column("psp_pkey");
 
     t_col_csptr op_col = flattened.get_const_column("psp_op");
@@ -716,7 +971,8 @@ t_stree::build_strand_table(const t_table& flattened,
 
     if (config.has_filters())
     {
-        msk = filter_table_for_config(flattened, config);
+        msk = filter_table_for_config(
+            flattened, config, nullptr, filter_cache);
     }
 
     t_bool has_filters = config.has_filters();
@@ -749,6 +1005,7 @@ t_stree::build_strand_table(const t_table& flattened,
             }
         }
 
+        push_pair_deltas(pairs, idx, 1, 0);
         agg_scount->push_back<t_int8>(1);
         spkey->push_back(pkey);
         ++insert_count;
@@ -957,6 +1214,27 @@ t_stree::mark_zero_desc()
     }
 }
 
+namespace
+{
+
+// MEDIAN ranks a node's rows by value, FIRST and LAST by their sort column.
+t_bool
+uses_order_stats(const t_aggspec& spec)
+{
+    switch (spec.agg())
+    {
+        case AGGTYPE_MEDIAN:
+            return true;
+        case AGGTYPE_FIRST:
+        case AGGTYPE_LAST:
+            return spec.get_sort_type() != SORTTYPE_NONE;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
 void
 t_stree::update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate)
 {
@@ -965,13 +1243,67 @@ t_stree::update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate)
     t_agg_update_info agg_update_info;
     t_schema aggschema = m_p->m_aggregates->get_schema();
 
-    for (auto colname : aggschema.m_columns)
+    for (t_uindex cidx = 0, loop_end = m_p->m_aggcols.size(); cidx < loop_end;
+         ++cidx)
     {
+        const t_str& colname = aggschema.m_columns[cidx];
+        const t_aggspec& spec = ctx.get_aggspec(colname);
         agg_update_info.m_src.push_back(
             src_aggtable.get_const_column(colname).get());
         agg_update_info.m_dst.push_back(
             m_p->m_aggregates->get_column(colname).get());
-        agg_update_info.m_aggspecs.push_back(ctx.get_aggspec(colname));
+        agg_update_info.m_aggspecs.push_back(spec);
+
+        const t_column* src_nan = 0;
+        t_column* dst_nan = 0;
+        if (spec.is_nan_tracked_sum(m_p->m_schema))
+        {
+            const t_str& nan_colname = spec.get_nan_sum_colname();
+            src_nan = src_aggtable.get_const_column(nan_colname).get();
+            dst_nan = m_p->m_aggregates->get_column(nan_colname).get();
+        }
+        agg_update_info.m_src_nan_sums.push_back(src_nan);
+        agg_update_info.m_dst_nan_sums.push_back(dst_nan);
+
+        t_index slot = -1;
+        if (m_p->m_features[CTX_FEAT_ORDER_STATS] && uses_order_stats(spec))
+        {
+            const auto& deps = spec.get_dependencies();
+            auto gtable = gstate.get_table();
+            slot = agg_update_info.m_ordered.size();
+            agg_update_info.m_ordered.push_back(cidx);
+            agg_update_info.m_ordered_values.push_back(
+                gtable->get_const_column(deps[0].name()).get());
+            agg_update_info.m_ordered_keys.push_back(
+                spec.agg() == AGGTYPE_MEDIAN
+                    ? 0
+                    : gtable->get_const_column(deps[1].name()).get());
+        }
+        agg_update_info.m_order_slot.push_back(slot);
+
+        t_udf_reducer_csptr reducer;
+        const t_column* udf_retract = 0;
+        const t_column* udf_combine = 0;
+        if (spec.agg() == AGGTYPE_UDF_CPP_REDUCE_FLOAT64)
+        {
+            reducer = spec.get_udf_reducer();
+            PSP_VERBOSE_ASSERT(reducer, "Unknown reducer");
+
+            auto strand_deltas = ctx.get_strand_deltas();
+            const t_str& retract_colname = spec.get_udf_retract_colname();
+            if (strand_deltas->get_schema().has_column(retract_colname))
+            {
+                udf_retract
+                    = strand_deltas->get_const_column(retract_colname).get();
+                udf_combine = strand_deltas
+                                  ->get_const_column(
+                                      spec.get_udf_combine_colname())
+                                  .get();
+            }
+        }
+        agg_update_info.m_reducers.push_back(reducer);
+        agg_update_info.m_udf_retract.push_back(udf_retract);
+        agg_update_info.m_udf_combine.push_back(udf_combine);
     }
 
     auto is_col_scaled_aggregate = [&](int col_idx) -> bool {
@@ -981,7 +1313,7 @@ t_stree::update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate)
             || agg_type == AGGTYPE_SCALED_MUL;
     };
 
-    size_t col_cnt = aggschema.m_columns.size();
+    size_t col_cnt = agg_update_info.m_src.size();
     auto& cols_topo_sorted = agg_update_info.m_dst_topo_sorted;
     cols_topo_sorted.clear();
     cols_topo_sorted.reserve(col_cnt);
@@ -1039,8 +1371,111 @@ t_stree::update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate)
             continue;
         }
 
+        if (!agg_update_info.m_ordered.empty())
+        {
+            update_order_stats(ctx, gstate, agg_update_info, r.m_sptidx,
+                r.m_daggidx, r.m_saggidx);
+        }
+
         update_agg_table(r.m_sptidx, agg_update_info, r.m_daggidx, r.m_saggidx,
-            r.m_nstrands, gstate);
+            r.m_nstrands, gstate, ctx);
+    }
+}
+
+void
+t_stree::update_order_stats(const t_dtree_ctx& ctx, const t_gstate& gstate,
+    const t_agg_update_info& info, t_uindex nidx, t_uindex src_ridx,
+    t_uindex dst_ridx)
+{
+    auto siter = m_p->m_order_stats.find(dst_ridx);
+
+    // Stats are built on a node's first update after they were enabled, from
+    // every row under it. The gstate already holds the rows of this step.
+    if (siter == m_p->m_order_stats.end())
+    {
+        auto& stats = m_p->m_order_stats[dst_ridx];
+        stats.resize(info.m_ordered.size());
+
+        for (const auto& pkey : get_pkeys(nidx))
+        {
+            insert_order_stats(gstate, info, stats,
+                m_p->m_symtable.get_interned_tscalar(pkey));
+        }
+        return;
+    }
+
+    auto& stats = siter->second;
+    auto pkey_col = ctx.get_pkey_col();
+    auto strand_count_col = ctx.get_strand_count_col();
+    auto liters = ctx.get_leaf_iterators(src_ridx);
+
+    // Retract first, a row moving between children of this node shows up as
+    // both a removal and an addition.
+    for (auto lfiter = liters.first; lfiter != liters.second; ++lfiter)
+    {
+        auto lfidx = *lfiter;
+        if (*(strand_count_col->get_nth<t_int8>(lfidx)) >= 0)
+            continue;
+
+        auto pkey
+            = m_p->m_symtable.get_interned_tscalar(pkey_col->get_scalar(lfidx));
+        for (auto& s : stats)
+        {
+            s.erase(pkey);
+        }
+    }
+
+    for (auto lfiter = liters.first; lfiter != liters.second; ++lfiter)
+    {
+        auto lfidx = *lfiter;
+        if (*(strand_count_col->get_nth<t_int8>(lfidx)) < 0)
+            continue;
+
+        insert_order_stats(gstate, info, stats,
+            m_p->m_symtable.get_interned_tscalar(pkey_col->get_scalar(lfidx)));
+    }
+}
+
+void
+t_stree::insert_order_stats(const t_gstate& gstate,
+    const t_agg_update_info& info, std::vector<t_order_stats>& stats,
+    const t_tscalar& pkey)
+{
+    t_rlookup lk = gstate.lookup(pkey);
+
+    for (t_uindex oidx = 0, loop_end = stats.size(); oidx < loop_end; ++oidx)
+    {
+        if (!lk.m_exists)
+        {
+            stats[oidx].erase(pkey);
+            continue;
+        }
+
+        const t_aggspec& spec = info.m_aggspecs[info.m_ordered[oidx]];
+        t_tscalar value = m_p->m_symtable.get_interned_tscalar(
+            info.m_ordered_values[oidx]->get_scalar(lk.m_idx));
+        t_tscalar key = value;
+
+        if (spec.agg() != AGGTYPE_MEDIAN)
+        {
+            key = info.m_ordered_keys[oidx]->get_scalar(lk.m_idx);
+
+            switch (spec.get_sort_type())
+            {
+                case SORTTYPE_ASCENDING_ABS:
+                case SORTTYPE_DESCENDING_ABS:
+                {
+                    key = mktscalar(std::abs(key.to_double()));
+                }
+                break;
+                default:
+                {
+                    key = m_p->m_symtable.get_interned_tscalar(key);
+                }
+            }
+        }
+
+        stats[oidx].insert(pkey, key, value);
     }
 }
 
@@ -1116,7 +1551,7 @@ t_stree::gen_aggidx()
 void
 t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info,
     t_uindex src_ridx, t_uindex dst_ridx, t_index nstrands,
-    const t_gstate& gstate)
+    const t_gstate& gstate, const t_dtree_ctx& ctx)
 {
     static bool const enable_sticky_nan_fix = true;
     for (t_uindex idx : info.m_dst_topo_sorted)
@@ -1137,19 +1572,38 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info,
                 t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
                 old_value.set(dst_scalar);
                 new_value.set(dst_scalar.add(src_scalar));
-                if (enable_sticky_nan_fix
-                    && old_value.is_nan()) // is_nan returns false for non-float
-                                           // types
+
+                const t_column* src_nan = info.m_src_nan_sums[idx];
+                t_column* dst_nan = info.m_dst_nan_sums[idx];
+
+                if (src_nan)
                 {
-                    // if we previously had a NaN, add can't make it finite
-                    // again; recalculate entire sum in case it is now finite
-                    auto pkeys = get_pkeys(nidx);
-                    std::vector<t_float64> values;
-                    gstate.read_column(
-                        spec.get_dependencies()[0].name(), pkeys, values);
-                    new_value.set(std::accumulate(
-                        values.begin(), values.end(), t_float64(0)));
+                    // a NaN can't be subtracted back out of a sum, so float
+                    // sums keep their finite part and NaN count apart
+                    const t_f64pair* src_pair
+                        = src_nan->get_nth<t_f64pair>(src_ridx);
+                    t_f64pair* dst_pair = dst_nan->get_nth<t_f64pair>(dst_ridx);
+
+                    t_f64pair pair(0, 0);
+                    if (dst_nan->is_valid(dst_ridx))
+                    {
+                        pair = *dst_pair;
+                    }
+
+                    pair.first += src_pair->first;
+                    pair.second += src_pair->second;
+
+                    *dst_pair = pair;
+                    dst_nan->set_valid(dst_ridx, true);
+
+                    if (new_value.is_valid())
+                    {
+                        new_value.set(pair.second > 0
+                                ? std::numeric_limits<t_float64>::quiet_NaN()
+                                : pair.first);
+                    }
                 }
+
                 dst->set_scalar(dst_ridx, new_value);
             }
             break;
@@ -1167,6 +1621,60 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info,
                 new_value.set(mktscalar<t_float64>(result));
             }
             break;
+            case AGGTYPE_UDF_CPP_REDUCE_FLOAT64:
+            {
+                old_value.set(dst->get_scalar(dst_ridx));
+                const t_udf_reducer* reducer = info.m_reducers[idx].get();
+                const t_column* retract = info.m_udf_retract[idx];
+                const t_column* combine = info.m_udf_combine[idx];
+
+                if (!reducer)
+                {
+                    new_value.set(t_tscalar());
+                }
+                else if (retract)
+                {
+                    // fold the rows that changed under the node into its
+                    // running value, retractions first
+                    t_float64 acc = dst->is_valid(dst_ridx)
+                        ? *(dst->get_nth<t_float64>(dst_ridx))
+                        : reducer->initial();
+
+                    auto liters = ctx.get_leaf_iterators(src_ridx);
+                    for (auto lfiter = liters.first; lfiter != liters.second;
+                         ++lfiter)
+                    {
+                        if (retract->is_valid(*lfiter))
+                        {
+                            acc = reducer->retract(
+                                acc, *(retract->get_nth<t_float64>(*lfiter)));
+                        }
+                    }
+
+                    for (auto lfiter = liters.first; lfiter != liters.second;
+                         ++lfiter)
+                    {
+                        if (combine->is_valid(*lfiter))
+                        {
+                            acc = reducer->combine(
+                                acc, *(combine->get_nth<t_float64>(*lfiter)));
+                        }
+                    }
+
+                    new_value.set(acc);
+                }
+                else
+                {
+                    auto pkeys = get_pkeys(nidx);
+                    std::vector<t_float64> values;
+                    gstate.read_column(spec.get_dependencies()[0].name(),
+                        pkeys, values, false);
+                    new_value.set(reducer->reduce(values, get_depth(nidx)));
+                }
+
+                dst->set_scalar(dst_ridx, new_value);
+            }
+            break;
             case AGGTYPE_COUNT:
             {
                 if (nidx == 0)
@@ -1182,60 +1690,63 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info,
             }
             break;
             case AGGTYPE_MEAN:
-            {
-                auto pkeys = get_pkeys(nidx);
-                std::vector<t_float64> values;
-
-                gstate.read_column(
-                    spec.get_dependencies()[0].name(), pkeys, values, false);
-
-                auto nr = std::accumulate(
-                    values.begin(), values.end(), t_float64(0));
-                t_float64 dr = values.size();
-
-                t_f64pair* dst_pair = dst->get_nth<t_f64pair>(dst_ridx);
-
-                old_value.set(dst_pair->first / dst_pair->second);
-
-                dst_pair->first = nr;
-                dst_pair->second = dr;
-
-                dst->set_valid(dst_ridx, true);
-
-                new_value.set(nr / dr);
-            }
-            break;
             case AGGTYPE_WEIGHTED_MEAN:
             {
-                auto pkeys = get_pkeys(nidx);
-
-                std::vector<t_float64> values;
-                std::vector<t_float64> weights;
-
-                gstate.read_column(
-                    spec.get_dependencies()[0].name(), pkeys, values);
-
-                gstate.read_column(
-                    spec.get_dependencies()[1].name(), pkeys, weights);
-
-                t_float64 init_value = 0.0;
+                const t_f64pair* src_pair = src->get_nth<t_f64pair>(src_ridx);
+                t_f64pair* dst_pair = dst->get_nth<t_f64pair>(dst_ridx);
 
-                auto nr = std::inner_product(
-                    weights.begin(), weights.end(), values.begin(), init_value);
+                t_f64pair pair(0, 0);
+                if (dst->is_valid(dst_ridx))
+                {
+                    pair = *dst_pair;
+                }
 
-                auto dr = std::accumulate(
-                    weights.begin(), weights.end(), t_float64(0));
+                old_value.set(pair.first / pair.second);
 
-                t_f64pair* dst_pair = dst->get_nth<t_f64pair>(dst_ridx);
+                if (enable_sticky_nan_fix && std::isnan(pair.first))
+                {
+                    // a NaN can't be subtracted back out, rebuild the
+                    // running totals from the node's leaves
+                    auto pkeys = get_pkeys(nidx);
+                    const t_depvec& deps = spec.get_dependencies();
+                    std::vector<t_float64> values;
 
-                old_value.set(dst_pair->first / dst_pair->second);
+                    if (spec.agg() == AGGTYPE_MEAN)
+                    {
+                        gstate.read_column(
+                            deps[0].name(), pkeys, values, false);
+                        pair.first = std::accumulate(
+                            values.begin(), values.end(), t_float64(0));
+                        pair.second = values.size();
+                    }
+                    else
+                    {
+                        std::vector<t_float64> weights;
+                        gstate.read_column(deps[0].name(), pkeys, values);
+                        gstate.read_column(deps[1].name(), pkeys, weights);
+                        pair.first = std::inner_product(weights.begin(),
+                            weights.end(), values.begin(), t_float64(0));
+                        pair.second = std::accumulate(
+                            weights.begin(), weights.end(), t_float64(0));
+                    }
+                }
+                else
+                {
+                    pair.first += src_pair->first;
+                    pair.second += src_pair->second;
 
-                dst_pair->first = nr;
-                dst_pair->second = dr;
+                    // counts are exact, don't let rounding in the running
+                    // sum outlive the last value
+                    if (spec.agg() == AGGTYPE_MEAN && pair.second == 0)
+                    {
+                        pair.first = 0;
+                    }
+                }
 
+                *dst_pair = pair;
                 dst->set_valid(dst_ridx, true);
 
-                new_value.set(nr / dr);
+                new_value.set(pair.first / pair.second);
             }
             break;
             case AGGTYPE_UNIQUE:
@@ -1295,10 +1806,14 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info,
             case AGGTYPE_MEDIAN:
             {
                 old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
+                t_index slot = info.m_order_slot[idx];
 
-                new_value.set(
-                    gstate.reduce<std::function<t_tscalar(t_tscalvec&)>>(pkeys,
+                if (slot < 0)
+                {
+                    auto pkeys = get_pkeys(nidx);
+
+                    new_value.set(gstate.reduce<
+                        std::function<t_tscalar(t_tscalvec&)>>(pkeys,
                         spec.get_dependencies()[0].name(),
                         [](t_tscalvec& values) {
                             if (values.empty())
@@ -1320,6 +1835,21 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info,
                                 return *middle;
                             }
                         }));
+                }
+                else
+                {
+                    const t_order_stats& stats
+                        = m_p->m_order_stats[dst_ridx][slot];
+
+                    if (stats.empty())
+                    {
+                        new_value.set(t_tscalar());
+                    }
+                    else
+                    {
+                        new_value.set(stats.nth(stats.size() / 2));
+                    }
+                }
 
                 dst->set_scalar(dst_ridx, new_value);
             }
@@ -1425,7 +1955,30 @@ t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info,
             case AGGTYPE_LAST:
             {
                 old_value.set(dst->get_scalar(dst_ridx));
-                new_value.set(first_last_helper(nidx, spec, gstate));
+                t_index slot = info.m_order_slot[idx];
+
+                if (slot < 0)
+                {
+                    new_value.set(first_last_helper(nidx, spec, gstate));
+                }
+                else
+                {
+                    const t_order_stats& stats
+                        = m_p->m_order_stats[dst_ridx][slot];
+                    t_bool ascending
+                        = spec.get_sort_type() == SORTTYPE_ASCENDING
+                        || spec.get_sort_type() == SORTTYPE_ASCENDING_ABS;
+
+                    if (ascending == (spec.agg() == AGGTYPE_FIRST))
+                    {
+                        new_value.set(stats.min_value());
+                    }
+                    else
+                    {
+                        new_value.set(stats.max_value());
+                    }
+                }
+
                 dst->set_scalar(dst_ridx, new_value);
             }
             break;
@@ -1824,6 +2377,11 @@ t_stree::clear_aggregates(const std::vector<t_uindex>& indices)
         }
     }
 
+    for (auto aggidx : indices)
+    {
+        m_p->m_order_stats.erase(aggidx);
+    }
+
     m_p->m_agg_freelist.insert(
         std::end(m_p->m_agg_freelist), std::begin(indices), std::end(indices));
 }
@@ -2246,6 +2804,7 @@ void
 t_stree::clear()
 {
     m_p->m_nodes->clear();
+    m_p->m_order_stats.clear();
     clear_deltas();
 }
 
@@ -2267,6 +2826,13 @@ t_stree::set_minmax_enabled(bool enabled_state)
     m_p->m_features[CTX_FEAT_MINMAX] = enabled_state;
 }
 
+void
+t_stree::set_order_stats_enabled(bool enabled_state)
+{
+    m_p->m_features[CTX_FEAT_ORDER_STATS] = enabled_state;
+    m_p->m_order_stats.clear();
+}
+
 void
 t_stree::set_feature_state(t_ctx_feature feature, t_bool state)
 {
@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/config.h>
+#include <perspective/filter_cache.h>
+#include <perspective/sparse_tree.h>
+#include <perspective/strand_cache.h>
+
+namespace perspective
+{
+
+t_strand_cache::t_strand_cache()
+    : m_active(false)
+{
+}
+
+void
+t_strand_cache::begin_step()
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_entries.clear();
+    m_active = true;
+}
+
+void
+t_strand_cache::end_step()
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_active = false;
+}
+
+template <typename BUILD_T>
+t_strand_cache::t_strands
+t_strand_cache::get_helper(const t_stree& tree, const t_table& flattened,
+    const t_table* delta, const t_table* prev, const t_table* current,
+    const t_table* transitions, const t_aggspecvec& aggspecs,
+    const t_config& config, const BUILD_T& build)
+{
+    // Other filter modes have no key, their trees aren't shared
+    if (config.has_filters() && config.get_fmode() != FMODE_SIMPLE_CLAUSES)
+        return build();
+
+    t_key key(&flattened, delta, prev, current, transitions,
+        tree.get_strand_key(flattened, aggspecs, config),
+        config.has_filters() ? t_filter_cache::get_filter_key(config)
+                             : t_str());
+    std::shared_ptr<t_entry> entry;
+
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (m_active)
+        {
+            auto& slot = m_entries[key];
+            if (!slot)
+                slot = std::make_shared<t_entry>();
+            entry = slot;
+        }
+    }
+
+    if (!entry)
+        return build();
+
+    std::call_once(
+        entry->m_once, [&entry, &build]() { entry->m_strands = build(); });
+
+    return entry->m_strands;
+}
+
+t_strand_cache::t_strands
+t_strand_cache::get(const t_stree& tree, const t_table& flattened,
+    const t_table& delta, const t_table& prev, const t_table& current,
+    const t_table& transitions, const t_aggspecvec& aggspecs,
+    const t_config& config, t_filter_cache* filter_cache)
+{
+    return get_helper(tree, flattened, &delta, &prev, &current, &transitions,
+        aggspecs, config, [&]() {
+            return tree.build_strand_table(flattened, delta, prev, current,
+                transitions, aggspecs, config, filter_cache);
+        });
+}
+
+t_strand_cache::t_strands
+t_strand_cache::get(const t_stree& tree, const t_table& flattened,
+    const t_aggspecvec& aggspecs, const t_config& config,
+    t_filter_cache* filter_cache)
+{
+    return get_helper(tree, flattened, nullptr, nullptr, nullptr, nullptr,
+        aggspecs, config, [&]() {
+            return tree.build_strand_table(
+                flattened, aggspecs, config, filter_cache);
+        });
+}
+
+t_uindex
+t_strand_cache::get_num_entries() const
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_entries.size();
+}
+
+} // end namespace perspective
@@ -12,10 +12,10 @@
 #include <perspective/raw_types.h>
 #include <perspective/table.h>
 #include <perspective/column.h>
+#include <perspective/filter_eval.h>
 #include <perspective/storage.h>
 #include <perspective/scalar.h>
 #include <perspective/utils.h>
-#include <perspective/logtime.h>
 #include <sstream>
 #include <fstream>
 
@@ -506,98 +506,21 @@ t_table::get_recipe() const
 }
 
 t_masksptr
-t_table::filter_cpp(t_filter_op combiner, const t_ftermvec& fterms_) const
+t_table::filter_cpp(t_filter_op combiner, const t_ftermvec& fterms_,
+    const t_mask* select) const
 {
-    auto self = const_cast<t_table*>(this);
     auto fterms = fterms_;
 
-    auto mask = std::make_shared<t_mask>(size());
     t_uindex fterm_size = fterms.size();
-    std::vector<t_uindex> indices(fterm_size);
     t_colcptrvec columns(fterm_size);
 
     for (t_uindex idx = 0; idx < fterm_size; ++idx)
     {
-        indices[idx] = m_schema.get_colidx(fterms[idx].m_colname);
         columns[idx] = get_const_column(fterms[idx].m_colname).get();
         fterms[idx].coerce_numeric(columns[idx]->get_dtype());
-        if (fterms[idx].m_use_interned)
-        {
-            t_tscalar& thr = fterms[idx].m_threshold;
-            auto col = self->get_column(fterms[idx].m_colname);
-            auto interned = col->get_interned(thr.get_char_ptr());
-            thr.set(interned);
-        }
-    }
-
-    switch (combiner)
-    {
-        case FILTER_OP_AND:
-        {
-            t_tscalar cell_val;
-
-            for (t_uindex ridx = 0, rloop_end = size(); ridx < rloop_end;
-                 ++ridx)
-            {
-                t_bool pass = true;
-
-                for (t_uindex cidx = 0; cidx < fterm_size; ++cidx)
-                {
-                    if (!pass)
-                        break;
-
-                    const auto& ft = fterms[cidx];
-                    t_bool tval;
-
-                    if (ft.m_use_interned)
-                    {
-                        cell_val.set(*(columns[cidx]->get_nth<t_stridx>(ridx)));
-                        tval = ft(cell_val);
-                    }
-                    else
-                    {
-                        cell_val = columns[cidx]->get_scalar(ridx);
-                        tval = ft(cell_val);
-                    }
-
-                    if (!cell_val.is_valid() || !tval)
-                    {
-                        pass = false;
-                        break;
-                    }
-                }
-
-                mask->set(ridx, pass);
-            }
-        }
-        break;
-        case FILTER_OP_OR:
-        {
-            for (t_uindex ridx = 0, rloop_end = size(); ridx < rloop_end;
-                 ++ridx)
-            {
-                t_bool pass = false;
-                for (t_uindex cidx = 0; cidx < fterm_size; ++cidx)
-                {
-                    t_tscalar cell_val = columns[cidx]->get_scalar(ridx);
-                    if (fterms[cidx](cell_val))
-                    {
-                        pass = true;
-                        break;
-                    }
-                }
-                mask->set(ridx, pass);
-            }
-        }
-        break;
-        default:
-        {
-            PSP_COMPLAIN_AND_ABORT("Unknown filter op");
-        }
-        break;
     }
 
-    return mask;
+    return filter_columns(combiner, fterms, columns, size(), select);
 }
 
 t_uindex
@@ -0,0 +1,180 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/trace.h>
+#include <perspective/env_vars.h>
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace perspective
+{
+
+std::atomic<t_bool> g_trace_enabled(false);
+
+namespace
+{
+
+const t_uindex DEFAULT_TRACE_CAPACITY = 1 << 16;
+
+const char* SPAN_NAMES[] = {"gnode.process", "gnode.flatten", "gnode.lookup",
+    "gnode.process_columns", "gnode.update_history", "gnode.update_contexts",
+    "gnode.notify_contexts", "ctx0.notify", "ctx1.notify", "ctx2.notify",
+    "ctx2.notify_tree", "ctx_grouped_pkey.notify", "ctx_grouped_pkey.rebuild",
+    "ctx_grouped_pkey.sort_by"};
+
+static_assert(sizeof(SPAN_NAMES) / sizeof(SPAN_NAMES[0]) == TRACE_NUM_SPANS,
+    "Every trace span needs a name");
+
+struct t_trace_buffer
+{
+    t_trace_buffer()
+        : m_events(DEFAULT_TRACE_CAPACITY)
+        , m_next(0)
+        , m_size(0)
+    {
+    }
+
+    std::mutex m_mutex;
+    std::vector<t_trace_event> m_events;
+    t_uindex m_next;
+    t_uindex m_size;
+};
+
+t_trace_buffer&
+trace_buffer()
+{
+    static t_trace_buffer rv;
+    return rv;
+}
+
+t_uindex
+thread_trace_id()
+{
+    static std::atomic<t_uindex> next_id(0);
+    static thread_local t_uindex id = next_id++;
+    return id;
+}
+
+struct t_trace_init
+{
+    t_trace_init()
+    {
+        // The per phase timers these replaced also turn it on
+        if (t_env::log_time() || t_env::log_time_gnode_process()
+            || t_env::log_time_ctx_notify())
+            set_trace_enabled(true);
+    }
+};
+
+t_trace_init trace_init;
+
+} // namespace
+
+void
+set_trace_enabled(t_bool enabled)
+{
+    g_trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void
+set_trace_capacity(t_uindex nevents)
+{
+    auto& buf = trace_buffer();
+    std::lock_guard<std::mutex> lk(buf.m_mutex);
+    buf.m_events.assign(nevents > 0 ? nevents : DEFAULT_TRACE_CAPACITY,
+        t_trace_event());
+    buf.m_next = 0;
+    buf.m_size = 0;
+}
+
+t_uindex
+get_trace_capacity()
+{
+    auto& buf = trace_buffer();
+    std::lock_guard<std::mutex> lk(buf.m_mutex);
+    return buf.m_events.size();
+}
+
+void
+clear_trace()
+{
+    auto& buf = trace_buffer();
+    std::lock_guard<std::mutex> lk(buf.m_mutex);
+    buf.m_next = 0;
+    buf.m_size = 0;
+}
+
+std::vector<t_trace_event>
+get_trace_events()
+{
+    auto& buf = trace_buffer();
+    std::lock_guard<std::mutex> lk(buf.m_mutex);
+    t_uindex capacity = buf.m_events.size();
+    t_uindex first = (buf.m_next + capacity - buf.m_size) % capacity;
+
+    std::vector<t_trace_event> rv;
+    rv.reserve(buf.m_size);
+    for (t_uindex idx = 0; idx < buf.m_size; ++idx)
+    {
+        rv.push_back(buf.m_events[(first + idx) % capacity]);
+    }
+    return rv;
+}
+
+t_str
+get_trace_json()
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+
+    t_bool first = true;
+    for (const auto& event : get_trace_events())
+    {
+        if (!first)
+            ss << ',';
+        first = false;
+        // Timestamps and durations are in microseconds
+        ss << "{\"name\":\"" << get_trace_span_name(event.m_span)
+           << "\",\"cat\":\"perspective\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+           << event.m_tid << ",\"ts\":" << event.m_begin / 1000.0
+           << ",\"dur\":" << event.m_duration / 1000.0 << '}';
+    }
+
+    ss << "]}";
+    return ss.str();
+}
+
+const char*
+get_trace_span_name(t_trace_span span)
+{
+    return span < TRACE_NUM_SPANS ? SPAN_NAMES[span] : "unknown";
+}
+
+void
+record_trace_event(t_trace_span span, t_int64 begin, t_int64 end)
+{
+    t_trace_event event;
+    event.m_span = span;
+    event.m_tid = thread_trace_id();
+    event.m_begin = begin;
+    event.m_duration = end - begin;
+
+    auto& buf = trace_buffer();
+    std::lock_guard<std::mutex> lk(buf.m_mutex);
+    t_uindex capacity = buf.m_events.size();
+    buf.m_events[buf.m_next] = event;
+    buf.m_next = (buf.m_next + 1) % capacity;
+    buf.m_size = std::min(buf.m_size + 1, capacity);
+}
+
+} // end namespace perspective
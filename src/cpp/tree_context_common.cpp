@@ -12,6 +12,7 @@
 #include <perspective/filter.h>
 #include <perspective/path.h>
 #include <perspective/sparse_tree.h>
+#include <perspective/strand_cache.h>
 #include <perspective/table.h>
 #include <perspective/traversal.h>
 #include <perspective/env_vars.h>
@@ -152,11 +153,14 @@ notify_sparse_tree(t_stree_sptr tree, t_trav_sptr traversal,
     const std::vector<t_sspair>& tree_sortby, const t_sortsvec& ctx_sortby,
     const t_table& flattened, const t_table& delta, const t_table& prev,
     const t_table& current, const t_table& transitions, const t_table& existed,
-    const t_config& config, const t_gstate& gstate)
+    const t_config& config, const t_gstate& gstate,
+    t_filter_cache* filter_cache, t_strand_cache* strand_cache)
 {
-
-    auto strand_values = tree->build_strand_table(
-        flattened, delta, prev, current, transitions, aggregates, config);
+    auto strand_values = strand_cache
+        ? strand_cache->get(*tree, flattened, delta, prev, current,
+              transitions, aggregates, config, filter_cache)
+        : tree->build_strand_table(flattened, delta, prev, current,
+              transitions, aggregates, config, filter_cache);
 
     auto strands = strand_values.first;
     auto strand_deltas = strand_values.second;
@@ -168,10 +172,14 @@ void
 notify_sparse_tree(t_stree_sptr tree, t_trav_sptr traversal,
     t_bool process_traversal, const t_aggspecvec& aggregates,
     const std::vector<t_sspair>& tree_sortby, const t_sortsvec& ctx_sortby,
-    const t_table& flattened, const t_config& config, const t_gstate& gstate)
+    const t_table& flattened, const t_config& config, const t_gstate& gstate,
+    t_filter_cache* filter_cache, t_strand_cache* strand_cache)
 {
-    auto strand_values
-        = tree->build_strand_table(flattened, aggregates, config);
+    auto strand_values = strand_cache
+        ? strand_cache->get(
+              *tree, flattened, aggregates, config, filter_cache)
+        : tree->build_strand_table(
+              flattened, aggregates, config, filter_cache);
 
     auto strands = strand_values.first;
     auto strand_deltas = strand_values.second;
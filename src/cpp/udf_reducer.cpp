@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/udf_reducer.h>
+#include <map>
+#include <mutex>
+
+namespace perspective
+{
+
+namespace
+{
+
+typedef std::map<t_str, t_udf_reducer_csptr> t_udf_reducer_map;
+
+std::mutex&
+registry_mutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+t_udf_reducer_map&
+registry()
+{
+    static t_udf_reducer_map rv;
+    return rv;
+}
+
+} // namespace
+
+t_udf_reducer::~t_udf_reducer() {}
+
+t_bool
+t_udf_reducer::is_incremental() const
+{
+    return false;
+}
+
+t_float64
+t_udf_reducer::initial() const
+{
+    return 0;
+}
+
+t_float64
+t_udf_reducer::combine(t_float64 acc, t_float64 value) const
+{
+    PSP_COMPLAIN_AND_ABORT("Reducer is not incremental");
+    return acc;
+}
+
+t_float64
+t_udf_reducer::retract(t_float64 acc, t_float64 value) const
+{
+    PSP_COMPLAIN_AND_ABORT("Reducer is not incremental");
+    return acc;
+}
+
+void
+register_udf_reducer(const t_str& name, t_udf_reducer_csptr reducer)
+{
+    std::lock_guard<std::mutex> lk(registry_mutex());
+    registry()[name] = reducer;
+}
+
+t_udf_reducer_csptr
+get_udf_reducer(const t_str& name)
+{
+    std::lock_guard<std::mutex> lk(registry_mutex());
+    auto iter = registry().find(name);
+    if (iter == registry().end())
+        return t_udf_reducer_csptr();
+    return iter->second;
+}
+
+} // end namespace perspective
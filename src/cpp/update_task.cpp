@@ -18,25 +18,76 @@ t_update_task::t_update_task(t_pool& pool)
 {
 }
 
+t_bool
+t_update_task::swap_input_ports()
+{
+    if (!m_pool.m_data_remaining.load())
+        return false;
+
+    // Anything sent from here on is left for the next task
+    m_pool.m_data_remaining.store(false);
+    for (t_gnode* g : m_pool.m_gnodes)
+    {
+        if (g)
+            g->_swap_input_ports();
+    }
+    return true;
+}
+
 void
-t_update_task::run()
+t_update_task::process_gnodes()
 {
-    auto work_to_do = m_pool.m_data_remaining.load();
-    if (work_to_do)
+    // Gnodes share no state, each one is processed, has its ports
+    // drained and is reported as done independently of the others.
+    const auto& gnodes = m_pool.m_gnodes;
+    t_index ngnodes = gnodes.size();
+
+    auto process_gnode = [this, &gnodes](t_index idx) {
+        t_gnode* g = gnodes[idx];
+        if (!g)
+            return;
+        g->_process();
+        g->clear_output_ports();
+        m_pool.notify_gnode_processed(idx);
+    };
+
+    if (m_pool.has_python_dep())
     {
-        m_pool.m_data_remaining.store(true);
-        for (auto g : m_pool.m_gnodes)
+        for (t_index idx = 0; idx < ngnodes; ++idx)
         {
-            if (g)
-                g->_process();
+            process_gnode(idx);
         }
-        for (auto g : m_pool.m_gnodes)
-        {
-            if (g)
-                g->clear_output_ports();
-        }
-        m_pool.m_data_remaining.store(false);
     }
+    else
+    {
+#ifdef PSP_PARALLEL_FOR
+        PSP_PFOR(0, int(ngnodes), 1,
+            [&process_gnode](int idx)
+#else
+        for (t_index idx = 0; idx < ngnodes; ++idx)
+#endif
+            { process_gnode(idx); }
+
+#ifdef PSP_PARALLEL_FOR
+        );
+#endif
+    }
+}
+
+void
+t_update_task::run()
+{
+    // Only the swap needs the pool mutex, producers can keep sending into
+    // the other side of the ports while the gnodes are processed.
+    t_bool work_to_do;
+    {
+        std::lock_guard<std::mutex> lg(m_pool.m_mtx);
+        work_to_do = swap_input_ports();
+    }
+
+    if (work_to_do)
+        process_gnodes();
+
     m_pool.py_notify_userspace();
     m_pool.inc_epoch();
 }
@@ -45,6 +96,10 @@ void
 t_update_task::run(t_uindex gnode_id)
 {
     ++gnode_id;
-    run();
+    if (swap_input_ports())
+        process_gnodes();
+
+    m_pool.py_notify_userspace();
+    m_pool.inc_epoch();
 }
 } // end namespace perspective
@@ -242,4 +242,14 @@ t_vocab::get_vlenidx() const
     return m_vlenidx;
 }
 
+const t_uindex t_vocab_translation::UNMAPPED;
+
+t_vocab_translation::t_vocab_translation(const t_vocab& src, t_vocab& dst)
+    : m_src(src)
+    , m_dst(dst)
+    , m_identity(&src == &dst)
+    , m_ids(m_identity ? 0 : src.get_vlenidx(), UNMAPPED)
+{
+}
+
 } // end namespace perspective
@@ -108,24 +108,20 @@ public:
     }
 };
 
+// Element wise sum of pairs. Strands carry pair deltas, so leaves reduce
+// the same way nodes roll up.
 template <typename RAW_DATA_T, typename ROLLING_T, typename RESULT_T>
-class PERSPECTIVE_EXPORT t_aggimpl_mean
+class PERSPECTIVE_EXPORT t_aggimpl_pair_sum
     : public t_aggimpl<RAW_DATA_T, ROLLING_T, RESULT_T>
 {
 public:
     RESULT_T
-    value(ROLLING_T rs) { return rs.first / rs.second; }
+    value(ROLLING_T rs) { return RESULT_T(rs); }
 
     ROLLING_T
     reduce(const RAW_DATA_T* biter, const RAW_DATA_T* eiter)
     {
-
-        t_float64 sum
-            = std::accumulate(biter, eiter, static_cast<t_float64>(0));
-
-        t_float64 count = eiter - biter;
-
-        return ROLLING_T(sum, count);
+        return roll_up(biter, eiter);
     }
 
     ROLLING_T
@@ -146,6 +142,15 @@ public:
     }
 };
 
+template <typename RAW_DATA_T, typename ROLLING_T, typename RESULT_T>
+class PERSPECTIVE_EXPORT t_aggimpl_mean
+    : public t_aggimpl_pair_sum<RAW_DATA_T, ROLLING_T, RESULT_T>
+{
+public:
+    RESULT_T
+    value(ROLLING_T rs) { return rs.first / rs.second; }
+};
+
 template <typename RAW_DATA_T, typename ROLLING_T, typename RESULT_T>
 class PERSPECTIVE_EXPORT t_aggimpl_last_value
     : public t_aggimpl<RAW_DATA_T, ROLLING_T, RESULT_T>
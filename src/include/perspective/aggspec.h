@@ -14,6 +14,7 @@
 #include <perspective/schema.h>
 #include <perspective/schema_column.h>
 #include <perspective/kernel_engine.h>
+#include <perspective/udf_reducer.h>
 #include <vector>
 
 namespace perspective
@@ -43,6 +44,7 @@ struct PERSPECTIVE_EXPORT t_aggspec_recipe
     t_float64 m_agg_one_weight;
     t_float64 m_agg_two_weight;
     t_invmode m_invmode;
+    t_str m_reducer;
 };
 
 typedef std::vector<t_aggspec_recipe> t_aggspec_recipevec;
@@ -91,12 +93,37 @@ public:
 
     t_bool is_non_delta() const;
 
+    // Mean aggregates are kept as running (numerator, denominator) pairs,
+    // fed by a per strand delta pair carried in this strand table column.
+    t_bool is_mean_agg() const;
+    t_str get_mean_delta_colname() const;
+
+    // Float sums also keep a running (finite sum, NaN count) pair in this
+    // hidden column, so a NaN leaving the group doesn't force a rescan.
+    t_bool is_nan_tracked_sum(const t_schema& schema) const;
+    t_str get_nan_sum_colname() const;
+
+    // C++ reducer aggregates name a reducer registered with
+    // register_udf_reducer. Incremental ones are fed the values each strand
+    // retracts from and combines into its nodes through these strand table
+    // columns.
+    const t_str& get_reducer_name() const;
+    t_udf_reducer_csptr get_udf_reducer() const;
+    t_bool is_incremental_udf() const;
+    t_str get_udf_retract_colname() const;
+    t_str get_udf_combine_colname() const;
+
     t_str get_first_depname() const;
 
     t_aggspec_recipe get_recipe() const;
 
+#ifdef PSP_ENABLE_WASM
     t_aggspec(const t_str& aggname, t_aggtype agg, const t_depvec& dependencies,
         t_kernel& kernel);
+#endif
+
+    t_aggspec(const t_str& aggname, t_aggtype agg, const t_depvec& dependencies,
+        const t_str& reducer);
     const t_kernel&
     get_kernel() const
     {
@@ -116,6 +143,7 @@ private:
     t_float64 m_agg_two_weight;
     t_invmode m_invmode;
     std::shared_ptr<t_kernel> m_kernel;
+    t_str m_reducer;
 };
 
 typedef std::vector<t_aggspec> t_aggspecvec;
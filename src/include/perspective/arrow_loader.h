@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/raw_types.h>
+#include <perspective/exports.h>
+#include <perspective/table.h>
+#include <cstdint>
+
+// Arrow C data interface, as published by the arrow project. Any arrow
+// implementation (C++, Rust, pyarrow, arrow-js through a bridge) can export
+// record batches through these structs without linking against us.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema
+{
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray
+{
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace perspective
+{
+
+// Maps an arrow format string to the dtype the column is stored as. Returns
+// DTYPE_NONE for formats we cannot ingest.
+PERSPECTIVE_EXPORT t_dtype arrow_format_to_dtype(const char* format);
+
+// Builds an inited table from an arrow record batch exported as a struct
+// ("+s") array. Fixed width buffers are copied with a single memcpy per
+// column, validity bitmaps are unpacked a word at a time and dictionary
+// encoded string columns intern each dictionary entry once and then remap
+// the indices. The batch is only read; releasing it stays with the caller.
+// index / is_delete behave as in load_table. Throws std::invalid_argument
+// if schema and array aren't matching struct arrays, or a column has a
+// format arrow_format_to_dtype or the dictionary remapping doesn't support.
+PERSPECTIVE_EXPORT t_table_sptr load_arrow_table(const ArrowSchema* schema,
+    const ArrowArray* array, const t_str& index = "",
+    t_bool is_delete = false);
+
+} // end namespace perspective
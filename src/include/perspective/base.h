@@ -35,6 +35,12 @@ const t_float64 PSP_TABLE_GROW_RATIO = 1.3;
 #endif
 
 #define PSP_UNUSED(x) ((void)(x))
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PSP_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PSP_PREFETCH(addr)
+#endif
 #define PSP_PFOR tbb::parallel_for
 
 const t_index INVALID_INDEX = -1;
@@ -229,7 +235,8 @@ enum t_aggtype
     AGGTYPE_DISTINCT_LEAF,
     AGGTYPE_PCT_SUM_PARENT,
     AGGTYPE_PCT_SUM_GRAND_TOTAL,
-    AGGTYPE_UDF_JS_REDUCE_FLOAT64
+    AGGTYPE_UDF_JS_REDUCE_FLOAT64,
+    AGGTYPE_UDF_CPP_REDUCE_FLOAT64
 };
 
 enum t_totals
@@ -306,6 +313,7 @@ enum t_ctx_feature
     CTX_FEAT_DELTA,
     CTX_FEAT_ALERT,
     CTX_FEAT_ENABLED,
+    CTX_FEAT_ORDER_STATS,
     CTX_FEAT_LAST_FEATURE
 };
 
@@ -157,7 +157,10 @@ public:
 
     t_lstore* _get_data_lstore();
 
+    t_lstore* _get_status_lstore();
+
     t_vocab* _get_vocab();
+    const t_vocab* _get_vocab() const;
 
     t_tscalar get_scalar(t_uindex idx) const;
     void set_scalar(t_uindex idx, t_tscalar value);
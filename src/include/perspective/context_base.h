@@ -11,6 +11,8 @@
 
 #include <perspective/base.h>
 #include <perspective/config.h>
+#include <perspective/filter_cache.h>
+#include <perspective/strand_cache.h>
 #include <perspective/schema.h>
 #include <perspective/exports.h>
 #include <perspective/min_max.h>
@@ -58,6 +60,8 @@ public:
     t_str get_name() const;
     t_int64 get_ptr() const;
     void set_state(t_gstate_sptr state);
+    void set_filter_cache(t_filter_cache_sptr cache);
+    void set_strand_cache(t_strand_cache_sptr cache);
     const t_config& get_config() const;
     t_config& get_config();
     t_pivotvec get_pivots() const;
@@ -92,6 +96,8 @@ protected:
     t_bool m_columns_changed;
     t_str m_name;
     t_gstate_sptr m_state;
+    t_filter_cache_sptr m_filter_cache;
+    t_strand_cache_sptr m_strand_cache;
     t_bool m_init;
     std::vector<t_bool> m_features;
     t_minmaxvec m_minmax;
@@ -157,6 +163,20 @@ t_ctxbase<DERIVED_T>::set_state(t_gstate_sptr state)
     m_state = state;
 }
 
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::set_filter_cache(t_filter_cache_sptr cache)
+{
+    m_filter_cache = cache;
+}
+
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::set_strand_cache(t_strand_cache_sptr cache)
+{
+    m_strand_cache = cache;
+}
+
 template <typename DERIVED_T>
 t_config&
 t_ctxbase<DERIVED_T>::get_config()
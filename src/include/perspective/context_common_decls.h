@@ -42,6 +42,8 @@ void set_deltas_enabled(bool enabled_state);
 
 void set_minmax_enabled(bool enabled_state);
 
+void set_order_stats_enabled(bool enabled_state);
+
 void set_feature_state(t_ctx_feature feature, t_bool state);
 
 t_tscalvec get_pkeys(const std::vector<t_uidxpair>& cells) const;
@@ -69,6 +69,10 @@ protected:
 
     t_uindex calc_translated_colidx(t_uindex n_aggs, t_uindex cidx) const;
 
+    // Calls notify_tree with the index of every tree
+    template <typename NOTIFY_T>
+    void notify_trees(const NOTIFY_T& notify_tree);
+
 private:
     t_trav_sptr m_rtraversal;
     t_trav_sptr m_ctraversal;
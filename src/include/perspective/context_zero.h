@@ -35,18 +35,33 @@ public:
     void sort_by();
     t_sortsvec get_sort_by() const;
 
+    // Only keep the first nrows rows of a sorted traversal fully ordered,
+    // see t_ftrav::set_sort_window.
+    void set_sort_window(t_uindex nrows);
+
 protected:
     t_tscalvec get_all_pkeys(const std::vector<t_uidxpair>& cells) const;
 
     void calc_step_delta(const t_table& flattened, const t_table& prev,
         const t_table& curr, const t_table& transitions);
 
+    // Inserted rows that are new or changed a filtered column in the step
+    t_mask get_filter_changes(const t_table& flattened,
+        const t_table& transitions, const t_table& existed) const;
+
+    t_bool get_filter_pass(t_uindex sidx) const;
+    void set_filter_pass(t_uindex sidx, t_bool pass);
+
 private:
     t_ftrav_sptr m_traversal;
     t_sptr_zcdeltas m_deltas;
     t_minmaxvec m_minmax;
     t_symtable_sptr m_symtable;
     t_bool m_has_delta;
+
+    // Whether the row of each gstate row index passed the filters when it
+    // was last added or updated.
+    std::vector<t_bool> m_filter_pass;
 };
 
 typedef std::shared_ptr<t_ctx0> t_ctx0_sptr;
@@ -202,6 +202,30 @@ struct PERSPECTIVE_EXPORT t_env
             = std::getenv("PSP_BACKOUT_EQ_INVALID_INVALID") != 0;
         return rv;
     }
+
+    static inline t_bool
+    backout_sort_byte_keys()
+    {
+        static const t_bool rv
+            = std::getenv("PSP_BACKOUT_SORT_BYTE_KEYS") != 0;
+        return rv;
+    }
+
+    static inline t_uindex
+    num_threads()
+    {
+        static const char* v = std::getenv("PSP_NUM_THREADS");
+        static const t_uindex rv = v ? std::strtoul(v, nullptr, 10) : 0;
+        return rv;
+    }
+
+    static inline t_uindex
+    parallel_sort_threshold()
+    {
+        static const char* v = std::getenv("PSP_PARALLEL_SORT_THRESHOLD");
+        static const t_uindex rv = v ? std::strtoul(v, nullptr, 10) : 0;
+        return rv;
+    }
 };
 
 } // end namespace perspective
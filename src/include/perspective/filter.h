@@ -205,7 +205,6 @@ struct PERSPECTIVE_EXPORT t_fterm
     t_tscalvec m_bag;
     t_bool m_negated;
     t_bool m_is_primary;
-    t_bool m_use_interned;
 };
 
 typedef std::vector<t_fterm> t_ftermvec;
@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/mask.h>
+#include <perspective/shared_ptrs.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace perspective
+{
+
+class t_config;
+
+// Filter masks of the tables of one gnode step, shared by the contexts
+// registered on the gnode. Configs whose filters only differ in the order
+// or repetition of their terms share a mask, which is computed once even
+// when contexts are notified concurrently.
+//
+// Masks are only shared between begin_step and end_step, when the tables
+// they were computed from can't change. Outside a step filter() computes
+// the mask every time. The masks of a step are dropped by the next one.
+class PERSPECTIVE_EXPORT t_filter_cache
+{
+public:
+    t_filter_cache();
+
+    void begin_step();
+    void end_step();
+
+    t_masksptr filter(const t_table& tbl, const t_config& config,
+        const t_mask* select = nullptr);
+
+    // Distinct masks of the last step
+    t_uindex get_num_masks() const;
+
+    // Equal for simple clause filters that select the same rows
+    static t_str get_filter_key(const t_config& config);
+
+private:
+    struct t_entry
+    {
+        std::once_flag m_once;
+        t_masksptr m_mask;
+    };
+
+    typedef std::tuple<const t_table*, t_str, std::vector<t_uint64>> t_key;
+
+    mutable std::mutex m_mutex;
+    t_bool m_active;
+    std::map<t_key, std::shared_ptr<t_entry>> m_entries;
+};
+
+typedef std::shared_ptr<t_filter_cache> t_filter_cache_sptr;
+
+} // end namespace perspective
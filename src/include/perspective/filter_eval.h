@@ -0,0 +1,45 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/filter.h>
+#include <perspective/mask.h>
+#include <perspective/shared_ptrs.h>
+
+namespace perspective
+{
+
+// Evaluates fterms over the first nrows rows of columns, the column of each
+// term at the same position, combining them with combiner. Terms are
+// evaluated a column at a time into 64 row words:
+//
+// - comparisons of numeric, date and time columns against a threshold of
+//   their own dtype run on the raw column values,
+// - string terms are resolved once against the column's vocabulary into a
+//   bitmap of passing string ids, then tested per row on its id. Equality
+//   and membership look their strings up, other ops evaluate each
+//   vocabulary string, so only when there are fewer of them than rows,
+// - every other term goes through t_fterm on the row's scalar.
+//
+// Rows are handled a block at a time, and once every row of a block is
+// decided the remaining terms are skipped for it. Within a block a term
+// only reads the rows the previous terms left undecided.
+//
+// With select, only its rows are evaluated and every other row is left
+// unset in the result.
+//
+// Thresholds must already be coerced to the column dtype.
+PERSPECTIVE_EXPORT t_masksptr filter_columns(t_filter_op combiner,
+    const t_ftermvec& fterms, const t_colcptrvec& columns, t_uindex nrows,
+    const t_mask* select = nullptr);
+
+} // end namespace perspective
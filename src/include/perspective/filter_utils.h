@@ -9,21 +9,28 @@
 
 #pragma once
 #include <perspective/config.h>
+#include <perspective/filter_cache.h>
 #include <perspective/table.h>
 #include <perspective/mask.h>
 
 namespace perspective
 {
 
+// With select, only its rows are filtered and the others are left unset.
+// With cache, the mask is shared with the other contexts of the gnode.
 inline t_masksptr
-filter_table_for_config(const t_table& tbl, const t_config& config)
+filter_table_for_config(const t_table& tbl, const t_config& config,
+    const t_mask* select = nullptr, t_filter_cache* cache = nullptr)
 {
+    if (cache)
+        return cache->filter(tbl, config, select);
 
     switch (config.get_fmode())
     {
         case FMODE_SIMPLE_CLAUSES:
         {
-            return tbl.filter_cpp(config.get_combiner(), config.get_fterms());
+            return tbl.filter_cpp(
+                config.get_combiner(), config.get_fterms(), select);
         }
         break;
         default:
@@ -21,6 +21,7 @@
 #include <perspective/config.h>
 #include <perspective/exports.h>
 #include <perspective/sym_table.h>
+#include <perspective/sort_keys.h>
 #include <set>
 #include <unordered_map>
 
@@ -30,7 +31,7 @@ namespace perspective
 class PERSPECTIVE_EXPORT t_ftrav
 {
     typedef std::unordered_map<t_tscalar, t_index> t_pkeyidx_map;
-    typedef std::unordered_map<t_tscalar, t_mselem> t_pkmselem_map;
+    typedef std::unordered_map<t_tscalar, t_uindex> t_pkslot_map;
 
 public:
     t_ftrav(t_bool handle_nan_sort);
@@ -44,13 +45,10 @@ public:
     t_tscalvec get_pkeys() const;
     t_tscalvec get_pkeys(t_tvidx begin_row, t_tvidx end_row) const;
 
-    t_tscalar get_pkey(t_tvidx idx) const;
-
-    void fill_sort_elem(t_gstate_csptr state, const t_config& config,
-        const t_tscalvec& row, t_mselem& out_elem) const;
+    // Every pkey, without sorting rows past the sorted window.
+    t_tscalvec get_pkeys_unordered() const;
 
-    void fill_sort_elem(t_gstate_csptr state, const t_config& config,
-        t_tscalar pkey, t_mselem& out_elem);
+    t_tscalar get_pkey(t_tvidx idx) const;
 
     void sort_by(
         t_gstate_csptr state, const t_config& config, const t_sortsvec& sortby);
@@ -89,13 +87,52 @@ public:
 
     t_index get_row_idx(t_tscalar pkey) const;
 
+    // With nrows > 0 only the first nrows rows are kept in order as rows
+    // change, the rest are left unordered and only sorted, a window at a
+    // time, when rows past the sorted ones are read. Steps then cost a
+    // linear selection at worst instead of sorting. Zero keeps every row
+    // sorted.
+    void set_sort_window(t_uindex nrows);
+    t_uindex get_sort_window() const;
+
 private:
+    // Sorts rows up to end, and with a sort window at least a window past
+    // the rows already sorted. Rows past the sorted ones are selected in
+    // linear time and reindexed.
+    void sort_window(t_index end) const;
+
+    void merge_sorted(
+        const std::vector<t_index>& dirty, std::vector<t_uindex>& changes);
+
+    void merge_window(
+        const std::vector<t_index>& dirty, std::vector<t_uindex>& changes);
+
+    void reindex(t_index idx) const;
+
+    std::vector<t_col_csptr> get_sort_columns(
+        t_gstate_csptr state, const t_config& config) const;
+
+    // Reads the sort keys of the row at ridx of the state table, or nones
+    // if the pkey is not there, into slot.
+    void fill_slot(const std::vector<t_col_csptr>& columns,
+        const t_rlookup& lookup, t_uindex slot);
+
+    // Queues the current sort keys of pkey to be merged in at step_end.
+    void queue_row(
+        t_gstate_csptr state, const t_config& config, t_tscalar pkey);
+
     t_index m_step_deletes;
     t_index m_step_inserts;
-    t_pkeyidx_map m_pkeyidx;
-    t_pkmselem_map m_new_elems;
+    mutable t_pkeyidx_map m_pkeyidx;
+    t_pkslot_map m_new_elems;
+    std::vector<t_index> m_step_dirty;
     t_sortsvec m_sortby;
-    t_mselemvec_sptr m_index;
+    // Slots of m_keys in traversal order. Reading rows past m_sorted_end
+    // sorts them, so these are updated by const accessors.
+    mutable std::vector<t_uindex> m_index;
+    mutable t_index m_sorted_end;
+    t_uindex m_window;
+    t_sort_keys m_keys;
     t_bool m_handle_nan_sort;
     t_symtable m_symtable;
 };
@@ -15,13 +15,14 @@
 #include <perspective/context_handle.h>
 #include <perspective/env_vars.h>
 #include <perspective/custom_column.h>
+#include <perspective/filter_cache.h>
+#include <perspective/strand_cache.h>
 #include <perspective/shared_ptrs.h>
 #include <perspective/rlookup.h>
 #ifdef PSP_PARALLEL_FOR
 #include <tbb/parallel_sort.h>
 #include <tbb/tbb.h>
 #endif
-#include <chrono>
 
 namespace perspective
 {
@@ -75,6 +76,12 @@ public:
     // schema should match port schema
     void _send_and_process(const t_table& fragments);
     void _send(t_uindex idx, const t_table& fragments);
+    // Takes ownership of fragments, see t_port::send
+    void _send(t_uindex idx, t_table_sptr fragments);
+
+    // Hands everything sent so far to the next _process(). Must not run
+    // concurrently with _send or _process.
+    void _swap_input_ports();
     void _process();
     void _register_context(const t_str& name, t_ctx_type type, t_int64 ptr);
     void _unregister_context(const t_str& name);
@@ -82,6 +89,9 @@ public:
     t_table* get_table();
     const t_table* get_table() const;
 
+    t_filter_cache_sptr get_filter_cache() const;
+    t_strand_cache_sptr get_strand_cache() const;
+
     t_value_transition calc_transition(t_bool prev_existed,
         t_bool row_pre_existed, t_bool exists, t_bool prev_valid,
         t_bool cur_valid, t_bool prev_cur_eq, t_bool prev_pkey_eq);
@@ -170,8 +180,9 @@ private:
     t_port_sptrvec m_oports;
     std::map<t_str, t_ctx_handle> m_contexts;
     t_gstate_sptr m_state;
+    t_filter_cache_sptr m_filter_cache;
+    t_strand_cache_sptr m_strand_cache;
     t_uindex m_id;
-    std::chrono::high_resolution_clock::time_point m_epoch;
     t_ccol_vec m_custom_columns;
     std::set<t_str> m_expr_icols;
     std::function<void()> m_pool_cleanup;
@@ -206,19 +217,9 @@ t_gnode::notify_context(CTX_T* ctx, const t_table& flattened,
     const t_table& delta, const t_table& prev, const t_table& current,
     const t_table& transitions, const t_table& existed)
 {
-    auto t1 = std::chrono::high_resolution_clock::now();
     ctx->step_begin();
     ctx->notify(flattened, delta, prev, current, transitions, existed);
     ctx->step_end();
-    if (t_env::log_time_ctx_notify())
-    {
-        auto t2 = std::chrono::high_resolution_clock::now();
-        std::cout << ctx->repr() << " ctx_notify "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(
-                         t2 - t1)
-                         .count()
-                  << std::endl;
-    }
 }
 
 template <typename CTX_T>
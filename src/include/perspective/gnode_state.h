@@ -12,11 +12,10 @@
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/table.h>
-#include <boost/unordered_map.hpp>
-#include <boost/unordered_set.hpp>
 #include <perspective/mask.h>
 #include <perspective/sym_table.h>
 #include <perspective/rlookup.h>
+#include <perspective/pkey_index.h>
 
 namespace perspective
 {
@@ -25,9 +24,7 @@ std::pair<t_tscalar, t_tscalar> get_vec_min_max(const t_tscalvec& vec);
 
 class PERSPECTIVE_EXPORT t_gstate
 {
-    typedef boost::unordered_map<t_tscalar, t_uindex> t_mapping;
-
-    typedef boost::unordered_set<t_uindex> t_free_items;
+    typedef std::vector<t_uindex> t_free_items;
 
 public:
     t_gstate(const t_schema& tblschema, const t_schema& pkeyed_schema);
@@ -35,6 +32,10 @@ public:
     void init();
 
     t_rlookup lookup(t_tscalar pkey) const;
+
+    // Looks up every row of pkeys, out is resized to match. Columns of
+    // another dtype than the stored pkeys fall back to scalar lookups.
+    void lookup_batch(const t_column& pkeys, std::vector<t_rlookup>& out) const;
     t_uindex lookup_or_create(const t_tscalar& pkey);
 
     void _mark_deleted(t_uindex idx);
@@ -100,14 +101,19 @@ public:
 protected:
     t_dtype get_pkey_dtype() const;
 
+    // When every row of a flattened batch inserts a new pkey and no rows
+    // are free, appends them in order at the end of the table and sets
+    // stableidx. Otherwise changes nothing and returns false.
+    t_bool append_rows(const t_column& pkeys, const t_uint8* ops,
+        std::vector<t_uindex>& stableidx);
+
 private:
     t_schema m_tblschema;
     t_schema m_pkeyed_schema;
     t_bool m_init;
     t_table_sptr m_table;
-    t_mapping m_mapping;
+    t_pkey_index m_index;
     t_free_items m_free;
-    t_symtable m_symtable;
     t_col_sptr m_pkcol;
     t_col_sptr m_opcol;
 };
@@ -21,7 +21,8 @@ class t_kernel_evaluator
 public:
     t_kernel_evaluator();
     template <typename T>
-    T reduce(const t_kernel& fn, t_uindex lvl_depth, std::vector<T> data);
+    T reduce(
+        const t_kernel& fn, t_uindex lvl_depth, const std::vector<T>& data);
 
 private:
     std::vector<t_uint8> m_kernels;
@@ -31,7 +32,7 @@ private:
 template <typename T>
 T
 t_kernel_evaluator::reduce(
-    const t_kernel& fn, t_uindex lvl_depth, std::vector<T> data)
+    const t_kernel& fn, t_uindex lvl_depth, const std::vector<T>& data)
 {
     auto arr = em::val(em::typed_memory_view(data.size(), data.data()));
     return fn(arr, em::val(lvl_depth)).as<T>();
@@ -41,7 +42,7 @@ t_kernel_evaluator::reduce(
 template <typename T>
 T
 t_kernel_evaluator::reduce(
-    const t_kernel& fn, t_uindex lvl_depth, std::vector<T> data)
+    const t_kernel& fn, t_uindex lvl_depth, const std::vector<T>& data)
 {
     PSP_COMPLAIN_AND_ABORT("Not implemented");
     return T();
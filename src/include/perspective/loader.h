@@ -0,0 +1,81 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/raw_types.h>
+#include <perspective/exports.h>
+#include <perspective/table.h>
+#include <vector>
+
+namespace perspective
+{
+
+class t_column;
+
+// A borrowed, caller owned view over the raw values of one column.
+//
+// Fixed width dtypes are expected in perspective's storage representation
+// (t_date::t_rawtype for dates, milliseconds since epoch for times, one
+// byte per t_bool). String columns use the arrow utf8 layout: m_data holds
+// the concatenated bytes and m_offsets holds m_length + 1 begin offsets.
+//
+// m_valid is an LSB ordered bit packed validity bitmap, one bit per row as
+// in arrow. A null m_valid marks every row valid. m_offset is a row offset
+// applied to m_data, m_offsets and m_valid alike, so sliced arrow arrays can
+// be passed through unchanged.
+struct PERSPECTIVE_EXPORT t_column_buffer
+{
+    t_column_buffer();
+    t_column_buffer(const t_str& name, t_dtype dtype, const void* data,
+        t_uindex length, const t_uint8* valid = nullptr);
+    t_column_buffer(const t_str& name, const char* data,
+        const t_int32* offsets, t_uindex length,
+        const t_uint8* valid = nullptr);
+
+    t_str m_name;
+    t_dtype m_dtype;
+    const void* m_data;
+    const t_int32* m_offsets;
+    t_uindex m_offset;
+    t_uindex m_length;
+    const t_uint8* m_valid;
+};
+
+typedef std::vector<t_column_buffer> t_column_buffer_vec;
+
+// Expands nrows bits, starting at bit offset, of an LSB ordered bitmap into
+// one 0/1 byte per bit. Works a 64 bit word at a time so all set / all clear
+// runs turn into memsets.
+PERSPECTIVE_EXPORT void unpack_bits(
+    const t_uint8* bitmap, t_uindex offset, t_uindex nrows, t_uint8* out);
+
+// Expands an LSB ordered validity bitmap into t_status bytes.
+PERSPECTIVE_EXPORT void expand_validity(
+    const t_uint8* bitmap, t_uindex offset, t_uindex nrows, t_status* out);
+
+// Copies buf into an already extended column of the same dtype. Throws
+// std::invalid_argument if the dtypes differ, buf is longer than the column
+// or a string buffer has no offsets.
+PERSPECTIVE_EXPORT void fill_column(t_column* col, const t_column_buffer& buf);
+
+// When index is non empty clones it into psp_pkey and adds a psp_op column
+// filled with OP_INSERT (or OP_DELETE if is_delete is set), matching the
+// layout the gnode input port expects.
+PERSPECTIVE_EXPORT void add_index_columns(
+    t_table* tbl, const t_str& index, t_bool is_delete);
+
+// Builds an inited table with nrows rows from raw column buffers, see
+// add_index_columns for index / is_delete. Throws std::invalid_argument if
+// a buffer doesn't hold exactly nrows rows, or as fill_column does.
+PERSPECTIVE_EXPORT t_table_sptr load_table(const t_column_buffer_vec& columns,
+    t_uindex nrows, const t_str& index = "", t_bool is_delete = false);
+
+} // end namespace perspective
@@ -1,21 +0,0 @@
-/******************************************************************************
- *
- * Copyright (c) 2017, the Perspective Authors.
- *
- * This file is part of the Perspective library, distributed under the terms of
- * the Apache License 2.0.  The full license can be found in the LICENSE file.
- *
- */
-
-#pragma once
-#include <perspective/first.h>
-#include <perspective/base.h>
-#include <perspective/compat.h>
-#include <perspective/exports.h>
-
-namespace perspective
-{
-
-PERSPECTIVE_EXPORT void psp_log_time(const t_str& s);
-
-} // end namespace perspective
@@ -14,6 +14,7 @@
 #include <boost/dynamic_bitset.hpp>
 #include <boost/shared_ptr.hpp>
 #include <perspective/simple_bitmask.h>
+#include <vector>
 
 namespace perspective
 {
@@ -30,6 +31,12 @@ public:
 
     t_mask(const t_simple_bitmask& m);
 
+    // Bit idx of the mask is bit idx % 64 of words[idx / 64]
+    t_mask(const std::vector<t_uint64>& words, t_uindex size);
+
+    // The mask packed the same way, 64 bits a word
+    std::vector<t_uint64> get_words() const;
+
     ~t_mask();
 
     void clear();
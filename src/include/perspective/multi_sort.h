@@ -92,12 +92,83 @@ struct PERSPECTIVE_EXPORT t_nancmp
 PERSPECTIVE_EXPORT t_nancmp nan_compare(
     t_sorttype order, const t_tscalar& a, const t_tscalar& b);
 
+// Compares the keys first and second of the rows first_pkey and second_pkey
+// in one column of a multi column sort. CMP_OP_EQ means the next column
+// decides.
+inline t_cmp_op
+cmp_sort_key(const t_tscalar& first, const t_tscalar& second,
+    const t_tscalar& first_pkey, const t_tscalar& second_pkey,
+    t_sorttype order, t_bool handle_nans)
+{
+    typedef std::pair<t_float64, t_tscalar> dpair;
+
+    t_nancmp nancmp = nan_compare(order, first, second);
+
+    if (handle_nans && first.is_floating_point() && nancmp.m_active)
+    {
+        switch (nancmp.m_cmpval)
+        {
+            case CMP_OP_LT:
+            case CMP_OP_GT:
+            {
+                return nancmp.m_cmpval;
+            }
+            break;
+            case CMP_OP_EQ:
+            default:
+            {
+                return CMP_OP_EQ;
+            }
+            break;
+        }
+    }
+
+    if (first == second)
+        return CMP_OP_EQ;
+
+    t_bool less = false;
+
+    switch (order)
+    {
+        case SORTTYPE_ASCENDING:
+        {
+            less = first < second;
+        }
+        break;
+        case SORTTYPE_DESCENDING:
+        {
+            less = first > second;
+        }
+        break;
+        case SORTTYPE_ASCENDING_ABS:
+        {
+            t_float64 val_a = first.to_double();
+            t_float64 val_b = second.to_double();
+            less = dpair(std::abs(val_a), first_pkey)
+                < dpair(std::abs(val_b), second_pkey);
+        }
+        break;
+        case SORTTYPE_DESCENDING_ABS:
+        {
+            t_float64 val_a = first.to_double();
+            t_float64 val_b = second.to_double();
+            less = dpair(std::abs(val_a), first_pkey)
+                > dpair(std::abs(val_b), second_pkey);
+        }
+        break;
+        case SORTTYPE_NONE:
+        {
+            less = first_pkey < second_pkey;
+        }
+    }
+
+    return less ? CMP_OP_LT : CMP_OP_GT;
+}
+
 inline PERSPECTIVE_EXPORT t_bool
 cmp_mselem(const t_mselem& a, const t_mselem& b,
     const std::vector<t_sorttype>& sort_order, t_bool handle_nans)
 {
-    typedef std::pair<t_float64, t_tscalar> dpair;
-
     if (a.m_row.size() != b.m_row.size() || a.m_row.size() != sort_order.size())
     {
         std::cout << "ERROR detected in MultiSort." << std::endl;
@@ -109,71 +180,11 @@ cmp_mselem(const t_mselem& a, const t_mselem& b,
 
     for (int idx = 0, loop_end = sort_order.size(); idx < loop_end; ++idx)
     {
-        const t_tscalar& first = a.m_row[idx];
-        const t_tscalar& second = b.m_row[idx];
-
-        t_sorttype order = sort_order[idx];
-        t_nancmp nancmp = nan_compare(order, first, second);
-
-        if (handle_nans && first.is_floating_point() && nancmp.m_active)
-        {
-            switch (nancmp.m_cmpval)
-            {
-                case CMP_OP_LT:
-                {
-                    return true;
-                }
-                break;
-                case CMP_OP_GT:
-                {
-                    return false;
-                }
-                break;
-                case CMP_OP_EQ:
-                default:
-                {
-                    continue;
-                }
-                break;
-            }
-        }
+        t_cmp_op cmp = cmp_sort_key(a.m_row[idx], b.m_row[idx], first_pkey,
+            second_pkey, sort_order[idx], handle_nans);
 
-        if (first == second)
-            continue;
-
-        switch (order)
-        {
-            case SORTTYPE_ASCENDING:
-            {
-                return (first < second);
-            }
-            break;
-            case SORTTYPE_DESCENDING:
-            {
-                return (first > second);
-            }
-            break;
-            case SORTTYPE_ASCENDING_ABS:
-            {
-                t_float64 val_a = first.to_double();
-                t_float64 val_b = second.to_double();
-                return dpair(std::abs(val_a), first_pkey)
-                    < dpair(std::abs(val_b), second_pkey);
-            }
-            break;
-            case SORTTYPE_DESCENDING_ABS:
-            {
-                t_float64 val_a = first.to_double();
-                t_float64 val_b = second.to_double();
-                return dpair(std::abs(val_a), first_pkey)
-                    > dpair(std::abs(val_b), second_pkey);
-            }
-            break;
-            case SORTTYPE_NONE:
-            {
-                return first_pkey < second_pkey;
-            }
-        }
+        if (cmp != CMP_OP_EQ)
+            return cmp == CMP_OP_LT;
     }
 
     if (a.m_order != b.m_order)
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/scalar.h>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/ranked_index.hpp>
+#include <boost/multi_index/composite_key.hpp>
+
+namespace perspective
+{
+
+// Orders scalars like t_tscalar::operator< but puts NaNs after every other
+// value of their dtype, so float keys stay strictly weakly ordered.
+struct PERSPECTIVE_EXPORT t_order_key_less
+{
+    bool operator()(const t_tscalar& a, const t_tscalar& b) const;
+};
+
+// Rows of one tree node ranked by a key, maintained as strands come and go
+// so MEDIAN, FIRST and LAST don't need to re-read every pkey under the node.
+// Each pkey holds one row, rows with equal keys are ordered by pkey.
+//
+// Every node keeps its own copy of the rows beneath it, so a tree holds
+// rows * (pivot depth + 1) entries per ranked aggregate, each a few scalars
+// plus two index links. Trees only keep them while CTX_FEAT_ORDER_STATS is
+// enabled, through set_order_stats_enabled, and build a node's stats from
+// the gstate on its first update after that.
+class PERSPECTIVE_EXPORT t_order_stats
+{
+public:
+    // Adds pkey, replacing its previous key and value if present.
+    void insert(
+        const t_tscalar& pkey, const t_tscalar& key, const t_tscalar& value);
+    void erase(const t_tscalar& pkey);
+    void clear();
+
+    t_uindex size() const;
+    t_bool empty() const;
+
+    // Value of the row of rank n in key order, none past the end.
+    t_tscalar nth(t_uindex n) const;
+
+    // Values of the rows with the smallest and largest keys, the greatest
+    // pkey wins among equal keys. None when empty.
+    t_tscalar min_value() const;
+    t_tscalar max_value() const;
+
+private:
+    struct t_row
+    {
+        t_tscalar m_pkey;
+        t_tscalar m_key;
+        t_tscalar m_value;
+    };
+
+    struct by_pkey
+    {
+    };
+
+    struct by_key
+    {
+    };
+
+    typedef boost::multi_index_container<t_row,
+        boost::multi_index::indexed_by<
+            boost::multi_index::hashed_unique<boost::multi_index::tag<by_pkey>,
+                BOOST_MULTI_INDEX_MEMBER(t_row, t_tscalar, m_pkey)>,
+            boost::multi_index::ranked_unique<
+                boost::multi_index::tag<by_key>,
+                boost::multi_index::composite_key<t_row,
+                    BOOST_MULTI_INDEX_MEMBER(t_row, t_tscalar, m_key),
+                    BOOST_MULTI_INDEX_MEMBER(t_row, t_tscalar, m_pkey)>,
+                boost::multi_index::composite_key_compare<t_order_key_less,
+                    std::less<t_tscalar>>>>>
+        t_rows;
+
+    t_rows m_rows;
+};
+
+} // end namespace perspective
@@ -0,0 +1,58 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <algorithm>
+#include <iterator>
+#ifdef PSP_PARALLEL_FOR
+#include <tbb/parallel_sort.h>
+#endif
+
+namespace perspective
+{
+
+// Caps the number of workers used by the PSP_PFOR / PSP_PSORT loops (column
+// processing in the gnode, context notification, table flattening). Zero
+// restores the default of one worker per core. The initial value is read
+// from PSP_NUM_THREADS. Without PSP_PARALLEL_FOR everything runs on the
+// calling thread and this is a no-op.
+PERSPECTIVE_EXPORT void set_num_threads(t_uindex nthreads);
+
+// The number of workers PSP_PFOR loops may currently use, always 1 when
+// built without PSP_PARALLEL_FOR.
+PERSPECTIVE_EXPORT t_uindex get_num_threads();
+
+// Ranges shorter than this are sorted by parallel_sort on the calling
+// thread, splitting them costs more than it saves. Zero restores the
+// default, the initial value is read from PSP_PARALLEL_SORT_THRESHOLD.
+PERSPECTIVE_EXPORT void set_parallel_sort_threshold(t_uindex nelems);
+PERSPECTIVE_EXPORT t_uindex get_parallel_sort_threshold();
+
+// std::sort, split across the workers for ranges of at least
+// get_parallel_sort_threshold() elements when built with PSP_PARALLEL_FOR.
+// cmp is called concurrently and has to be safe to share.
+template <typename ITER_T, typename CMP_T>
+void
+parallel_sort(ITER_T begin, ITER_T end, const CMP_T& cmp)
+{
+#ifdef PSP_PARALLEL_FOR
+    t_uindex nelems = std::distance(begin, end);
+    if (nelems >= get_parallel_sort_threshold() && get_num_threads() > 1)
+    {
+        tbb::parallel_sort(begin, end, cmp);
+        return;
+    }
+#endif
+    std::sort(begin, end, cmp);
+}
+
+} // end namespace perspective
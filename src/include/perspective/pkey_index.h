@@ -0,0 +1,118 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/scalar.h>
+#include <perspective/rlookup.h>
+#include <perspective/sym_table.h>
+#include <perspective/vocab.h>
+#include <boost/unordered_map.hpp>
+#include <vector>
+
+namespace perspective
+{
+
+class t_column;
+
+// Flat open addressing index from primary key to row in the gnode state
+// table. Every valid key of the index dtype is reduced to 64 bits: integral,
+// date, time and bool keys are used as is, floats by bit pattern and strings
+// by their id in the vocabulary of the state table's pkey column, so probing
+// never builds a t_tscalar or chases a node pointer and string keys are not
+// stored twice.
+//
+// Any other key, invalid, none or of another dtype, is kept in a side map
+// compared with t_tscalar::operator==, so keys match exactly as they would
+// in a boost::unordered_map<t_tscalar, t_uindex>.
+class PERSPECTIVE_EXPORT t_pkey_index
+{
+public:
+    t_pkey_index();
+
+    // vocab interns string keys, it should be the vocabulary of the column
+    // the pkeys are stored in and must outlive the index.
+    void init(t_dtype dtype, t_vocab* vocab = nullptr);
+    void set_vocab(t_vocab* vocab);
+
+    t_dtype get_dtype() const;
+
+    t_rlookup lookup(const t_tscalar& pkey) const;
+
+    // Looks up every row of pkeys, which must have the index dtype, into
+    // out. Keys are hashed a block at a time and their slots prefetched
+    // before probing.
+    void lookup_batch(
+        const t_column& pkeys, std::vector<t_rlookup>& out) const;
+
+    // Maps pkey to idx, replacing any existing row.
+    void insert(const t_tscalar& pkey, t_uindex idx);
+
+    // Removes pkey, returning whether it was present and its row in idx.
+    t_bool erase(const t_tscalar& pkey, t_uindex& idx);
+
+    void clear();
+    void reserve(t_uindex size);
+
+    t_uindex size() const;
+
+    // Calls fn(idx) for the row of every key, in no particular order.
+    template <typename FN_T>
+    void for_each(FN_T fn) const;
+
+private:
+    struct t_slot
+    {
+        t_uint64 m_key;
+        t_uindex m_idx;
+    };
+
+    typedef boost::unordered_map<t_tscalar, t_uindex> t_foreign_map;
+
+    t_bool is_foreign(const t_tscalar& pkey) const;
+    t_bool to_key(const t_tscalar& pkey, t_uint64& key) const;
+    t_uindex find_slot(t_uint64 key) const;
+    void rehash(t_uindex capacity);
+
+    template <typename DATA_T>
+    void fill_keys(const t_column& pkeys, t_uindex bidx, t_uindex count,
+        t_uint64* keys, t_bool* found) const;
+
+    void fill_str_keys(const t_column& pkeys, t_uindex bidx, t_uindex count,
+        t_uint64* keys, t_bool* found, std::vector<t_index>& xlat) const;
+
+    t_dtype m_dtype;
+    t_vocab* m_vocab;
+    t_uindex m_size;
+    t_uindex m_tombstones;
+    t_uindex m_mask;
+    std::vector<t_slot> m_slots;
+    t_foreign_map m_foreign;
+    t_symtable m_foreign_strings;
+};
+
+template <typename FN_T>
+void
+t_pkey_index::for_each(FN_T fn) const
+{
+    static const t_uindex LIVE_LIMIT = std::numeric_limits<t_uindex>::max() - 1;
+
+    for (const auto& kv : m_foreign)
+        fn(kv.second);
+
+    for (const auto& slot : m_slots)
+    {
+        if (slot.m_idx < LIVE_LIMIT)
+            fn(slot.m_idx);
+    }
+}
+
+} // end namespace perspective
@@ -14,6 +14,7 @@
 #include <perspective/exports.h>
 #include <mutex>
 #include <atomic>
+#include <functional>
 
 #ifdef PSP_ENABLE_WASM
 #include <emscripten/val.h>
@@ -35,9 +36,12 @@ typedef std::vector<t_updctx> t_updctx_vec;
 
 class t_update_task;
 
+typedef std::function<void(t_uindex)> t_gnode_processed_cb;
+
 class PERSPECTIVE_EXPORT t_pool
 {
     friend class t_update_task;
+
     typedef std::pair<t_uindex, t_str> t_ctx_id;
 
 public:
@@ -66,6 +70,8 @@ public:
     void unregister_context(t_uindex gnode_id, const t_str& name);
 
     void send(t_uindex gnode_id, t_uindex port_id, const t_table& table);
+    // Takes ownership of table, see t_port::send
+    void send(t_uindex gnode_id, t_uindex port_id, t_table_sptr table);
 
     void _process();
     void _process_helper();
@@ -90,12 +96,22 @@ public:
     std::vector<t_uindex> get_gnodes_last_updated();
     t_gnode* get_gnode(t_uindex gnode_id);
 
+    // cb is called with the id of each gnode as soon as its pending updates
+    // have been processed, before the whole update task completes. Gnodes
+    // are processed concurrently when PSP_PARALLEL_FOR is enabled, so cb
+    // may run on worker threads, for several gnodes at once. Workers read
+    // it without locking, so set it before any data is sent.
+    void set_gnode_processed_callback(t_gnode_processed_cb cb);
+
 protected:
     // Following three functions
     // use the python api
     t_bool validate_gnode_id(t_uindex gnode_id) const;
 
 private:
+    // Called by t_update_task once gnode_id has been processed
+    void notify_gnode_processed(t_uindex gnode_id);
+
     std::mutex m_mtx;
     std::vector<t_gnode*> m_gnodes;
 
@@ -107,6 +123,7 @@ private:
     std::atomic<t_uindex> m_sleep;
     std::atomic<t_uindex> m_epoch;
     t_bool m_has_python_dep;
+    t_gnode_processed_cb m_gnode_processed_cb;
 };
 
 } // end namespace perspective
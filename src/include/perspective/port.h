@@ -27,22 +27,51 @@ public:
     t_port(const t_schema& schema);
     ~t_port();
     void init();
+
+    // The batch being processed
     t_table_sptr get_table();
     void set_table(t_table_sptr tbl);
 
-    // append to existing table
+    // Input ports are double buffered. send() adds rows to a pending batch
+    // and swap() hands it to get_table(), so the batch being processed can
+    // be read while the next one is sent. Callers serialize send() and
+    // swap(), t_pool holds its mutex for both.
+
+    // append to the pending batch
     void send(t_table_csptr tbl);
     void send(const t_table& tbl);
 
+    // Takes ownership of tbl, the caller must not touch it afterwards. A
+    // table with the port schema becomes the pending batch without a copy
+    // when nothing is pending, otherwise it is appended.
+    void send(t_table_sptr tbl);
+
+    // Moves the pending batch to get_table(), appending it when rows of the
+    // previous batch are still there. Returns whether there are rows to
+    // process.
+    t_bool swap();
+
+    t_uindex get_pending_size() const;
+
     t_schema get_schema() const;
 
+    // Empty the processed batch, keeping its table and capacity for the
+    // batch after next. release_or_clear reallocates it when it has grown
+    // far beyond the last two batches, or its string vocabularies have.
     void release();
     void release_or_clear();
 
+    // Empties both batches
+    void clear();
+
 private:
+    t_table_sptr make_table(t_uindex capacity) const;
+    t_bool is_oversized(t_uindex nrows) const;
+
     t_schema m_schema;
     t_bool m_init;
     t_table_sptr m_table;
+    t_table_sptr m_pending;
     t_uindex m_prevsize;
 };
 
@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/scalar.h>
+#include <vector>
+
+namespace perspective
+{
+
+// Sort keys of the rows of a flat traversal, stored a column at a time.
+// Every row owns a slot holding its pkey and one key per sort column, slots
+// are recycled as rows come and go. Rows are ordered exactly like
+// t_multisorter orders the equivalent t_mselem, but keys are read from the
+// key columns in place and same dtype numeric keys are compared on their
+// raw values, without going through t_tscalar comparisons.
+//
+// When the dtypes of the key columns are known, the leading columns are
+// also encoded into a fixed width byte key per slot: a tag byte placing
+// NaNs, then the value as big endian bytes, inverted for descending
+// orders. Two slots are first compared with memcmp over the columns both
+// could encode, only ties fall back to comparing scalars. Ascending and
+// descending numeric, date, time and bool keys encode exactly. String
+// prefixes and absolute values only order the keys that differ, so the
+// encoding stops after the first such column, and before any unsorted or
+// other dtype column. Nulls and untracked NaNs are left unencoded.
+class PERSPECTIVE_EXPORT t_sort_keys
+{
+public:
+    t_sort_keys();
+
+    // Drops every slot, there is one key column per entry of order. dtypes
+    // are the dtypes of the key columns, without them no byte keys are
+    // kept.
+    void init(const std::vector<t_sorttype>& order, t_bool handle_nans,
+        const std::vector<t_dtype>& dtypes = std::vector<t_dtype>());
+    void clear();
+
+    t_uindex alloc(const t_tscalar& pkey);
+    void release(t_uindex slot);
+
+    t_uindex get_num_columns() const;
+    const std::vector<t_sorttype>& get_sort_order() const;
+
+    const t_tscalar& get_pkey(t_uindex slot) const;
+    const t_tscalar& get_key(t_uindex col, t_uindex slot) const;
+    void set_key(t_uindex col, t_uindex slot, const t_tscalar& key);
+
+    t_bool less(t_uindex a, t_uindex b) const;
+
+    // Whether slot a sorts before a row with the given keys and pkey.
+    t_bool less(
+        t_uindex a, const t_tscalvec& keys, const t_tscalar& pkey) const;
+
+    // Number of leading key columns kept as byte keys
+    t_uindex get_num_encoded_columns() const;
+
+private:
+    t_bool encode(t_uindex col, const t_tscalar& key, t_uint8* out) const;
+
+    // Number of leading columns of slot whose keys are encoded
+    t_uindex get_num_encoded(t_uindex slot) const;
+
+    t_cmp_op compare(const t_tscalar& a, const t_tscalar& b,
+        const t_tscalar& a_pkey, const t_tscalar& b_pkey,
+        t_sorttype order) const;
+
+    std::vector<t_sorttype> m_order;
+    t_bool m_handle_nans;
+    std::vector<t_tscalvec> m_keys;
+    t_tscalvec m_pkeys;
+    std::vector<t_uindex> m_free;
+
+    std::vector<t_dtype> m_dtypes;
+    t_uindex m_nencoded;
+    t_uindex m_nexact;
+    std::vector<t_uint8> m_bytes;
+    // Bit n set when column n of the slot is encoded
+    std::vector<t_uint8> m_encoded;
+};
+
+} // end namespace perspective
@@ -27,6 +27,8 @@ namespace perspective
 class t_gstate;
 class t_dtree_ctx;
 class t_config;
+class t_filter_cache;
+class t_order_stats;
 class t_ctx2;
 
 using boost::multi_index_container;
@@ -73,6 +75,7 @@ struct t_build_strand_table_common_rval
     t_uindex m_npivotlike;
     std::vector<t_str> m_pivot_like_columns;
     t_uindex m_pivsize;
+    t_aggspecvec m_pair_aggspecs;
 };
 
 struct PERSPECTIVE_EXPORT t_agg_update_info
@@ -81,6 +84,24 @@ struct PERSPECTIVE_EXPORT t_agg_update_info
     t_colptrvec m_dst;
     t_aggspecvec m_aggspecs;
 
+    // Running (finite sum, NaN count) pairs of float sums, null otherwise.
+    t_colcptrvec m_src_nan_sums;
+    t_colptrvec m_dst_nan_sums;
+
+    // Aggregates ranked through per node order statistics, with the gstate
+    // columns their values and sort keys are read from. m_order_slot maps
+    // each aggregate to its position in m_ordered, -1 if it isn't ranked.
+    std::vector<t_uindex> m_ordered;
+    t_colcptrvec m_ordered_values;
+    t_colcptrvec m_ordered_keys;
+    std::vector<t_index> m_order_slot;
+
+    // Registered reducers of C++ reducer aggregates, with the strand
+    // columns incremental ones are folded from. Null otherwise.
+    std::vector<t_udf_reducer_csptr> m_reducers;
+    t_colcptrvec m_udf_retract;
+    t_colcptrvec m_udf_combine;
+
     std::vector<t_uindex> m_dst_topo_sorted;
 };
 
@@ -138,11 +159,18 @@ public:
     std::pair<t_table_sptr, t_table_sptr> build_strand_table(
         const t_table& flattened, const t_table& delta, const t_table& prev,
         const t_table& current, const t_table& transitions,
-        const t_aggspecvec& aggspecs, const t_config& config) const;
+        const t_aggspecvec& aggspecs, const t_config& config,
+        t_filter_cache* filter_cache = nullptr) const;
 
     std::pair<t_table_sptr, t_table_sptr> build_strand_table(
         const t_table& flattened, const t_aggspecvec& aggspecs,
-        const t_config& config) const;
+        const t_config& config, t_filter_cache* filter_cache = nullptr) const;
+
+    // Identifies the layout of the strand tables built for aggspecs and
+    // config: trees with the same key build the same strand tables from
+    // the same input tables and filter.
+    t_str get_strand_key(const t_table& flattened,
+        const t_aggspecvec& aggspecs, const t_config& config) const;
 
     void update_shape_from_static(const t_dtree_ctx& ctx);
     void update_aggs_from_static(
@@ -214,6 +242,11 @@ public:
 
     void set_minmax_enabled(bool enabled_state);
 
+    // Rank MEDIAN and sorted FIRST/LAST rows with per node order statistics
+    // instead of rescanning every row under a touched node. Off by default,
+    // see t_order_stats for the memory this costs.
+    void set_order_stats_enabled(bool enabled_state);
+
     void set_feature_state(t_ctx_feature feature, t_bool state);
 
     template <typename ITER_T>
@@ -263,7 +296,13 @@ protected:
     std::vector<t_uindex> get_children(t_uindex idx) const;
     void update_agg_table(t_uindex nidx, t_agg_update_info& info,
         t_uindex src_ridx, t_uindex dst_ridx, t_index nstrands,
-        const t_gstate& gstate);
+        const t_gstate& gstate, const t_dtree_ctx& ctx);
+    void update_order_stats(const t_dtree_ctx& ctx, const t_gstate& gstate,
+        const t_agg_update_info& info, t_uindex nidx, t_uindex src_ridx,
+        t_uindex dst_ridx);
+    void insert_order_stats(const t_gstate& gstate,
+        const t_agg_update_info& info, std::vector<t_order_stats>& stats,
+        const t_tscalar& pkey);
 
     t_bool is_leaf(t_uindex nidx) const;
 
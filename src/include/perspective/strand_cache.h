@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/aggspec.h>
+#include <perspective/shared_ptrs.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+namespace perspective
+{
+
+class t_config;
+class t_filter_cache;
+class t_stree;
+
+// Strand tables of one gnode step, shared by the sparse trees of the
+// contexts registered on the gnode. Trees grouping by the same pivot and
+// sort columns, aggregating the same columns and filtering the same rows
+// share their strand tables, which are built once even when contexts are
+// notified concurrently. The shared tables must not be modified.
+//
+// As with t_filter_cache, tables are only shared between begin_step and
+// end_step, outside a step get() builds them every time.
+class PERSPECTIVE_EXPORT t_strand_cache
+{
+public:
+    typedef std::pair<t_table_sptr, t_table_sptr> t_strands;
+
+    t_strand_cache();
+
+    void begin_step();
+    void end_step();
+
+    // The strands and strand deltas tree.build_strand_table would return
+    t_strands get(const t_stree& tree, const t_table& flattened,
+        const t_table& delta, const t_table& prev, const t_table& current,
+        const t_table& transitions, const t_aggspecvec& aggspecs,
+        const t_config& config, t_filter_cache* filter_cache = nullptr);
+
+    t_strands get(const t_stree& tree, const t_table& flattened,
+        const t_aggspecvec& aggspecs, const t_config& config,
+        t_filter_cache* filter_cache = nullptr);
+
+    // Distinct strand tables of the last step
+    t_uindex get_num_entries() const;
+
+private:
+    struct t_entry
+    {
+        std::once_flag m_once;
+        t_strands m_strands;
+    };
+
+    typedef std::tuple<const t_table*, const t_table*, const t_table*,
+        const t_table*, const t_table*, t_str, t_str>
+        t_key;
+
+    template <typename BUILD_T>
+    t_strands get_helper(const t_stree& tree, const t_table& flattened,
+        const t_table* delta, const t_table* prev, const t_table* current,
+        const t_table* transitions, const t_aggspecvec& aggspecs,
+        const t_config& config, const BUILD_T& build);
+
+    mutable std::mutex m_mutex;
+    t_bool m_active;
+    std::map<t_key, std::shared_ptr<t_entry>> m_entries;
+};
+
+typedef std::shared_ptr<t_strand_cache> t_strand_cache_sptr;
+
+} // end namespace perspective
@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/compat.h>
+#include <perspective/exports.h>
+#include <atomic>
+#include <vector>
+
+namespace perspective
+{
+
+// Phases timed by t_trace_scope. New spans go before TRACE_NUM_SPANS and
+// get a name in trace.cpp.
+enum t_trace_span
+{
+    TRACE_GNODE_PROCESS,
+    TRACE_GNODE_FLATTEN,
+    TRACE_GNODE_LOOKUP,
+    TRACE_GNODE_PROCESS_COLUMNS,
+    TRACE_GNODE_UPDATE_HISTORY,
+    TRACE_GNODE_UPDATE_CONTEXTS,
+    TRACE_GNODE_NOTIFY_CONTEXTS,
+    TRACE_CTX0_NOTIFY,
+    TRACE_CTX1_NOTIFY,
+    TRACE_CTX2_NOTIFY,
+    TRACE_CTX2_NOTIFY_TREE,
+    TRACE_CTX_GROUPED_PKEY_NOTIFY,
+    TRACE_CTX_GROUPED_PKEY_REBUILD,
+    TRACE_CTX_GROUPED_PKEY_SORT_BY,
+    TRACE_NUM_SPANS
+};
+
+struct PERSPECTIVE_EXPORT t_trace_event
+{
+    t_trace_span m_span;
+    // Small per thread id, in the order threads first recorded a span
+    t_uindex m_tid;
+    // Nanoseconds, from psp_curtime
+    t_int64 m_begin;
+    t_int64 m_duration;
+};
+
+PERSPECTIVE_EXPORT extern std::atomic<t_bool> g_trace_enabled;
+
+// Tracing is off unless PSP_LOG_TIME, PSP_LOG_TIME_GNODE_PROCESS or
+// PSP_LOG_TIME_CTX_NOTIFY is set, and can be switched at any time. While
+// it is off a t_trace_scope costs one relaxed load.
+PERSPECTIVE_EXPORT void set_trace_enabled(t_bool enabled);
+
+inline t_bool
+is_trace_enabled()
+{
+    return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+// The buffer keeps the last nevents events, older ones are overwritten.
+// Resizing drops the recorded events.
+PERSPECTIVE_EXPORT void set_trace_capacity(t_uindex nevents);
+PERSPECTIVE_EXPORT t_uindex get_trace_capacity();
+
+PERSPECTIVE_EXPORT void clear_trace();
+
+// Recorded events, oldest first
+PERSPECTIVE_EXPORT std::vector<t_trace_event> get_trace_events();
+
+// Recorded events in the Chrome trace event format, for chrome://tracing
+// or Perfetto.
+PERSPECTIVE_EXPORT t_str get_trace_json();
+
+PERSPECTIVE_EXPORT const char* get_trace_span_name(t_trace_span span);
+
+PERSPECTIVE_EXPORT void record_trace_event(
+    t_trace_span span, t_int64 begin, t_int64 end);
+
+// Records span from construction to end() or destruction, if tracing was
+// enabled when it was constructed.
+class t_trace_scope
+{
+public:
+    explicit t_trace_scope(t_trace_span span)
+        : m_span(span)
+        , m_active(is_trace_enabled())
+        , m_begin(m_active ? psp_curtime() : 0)
+    {
+    }
+
+    ~t_trace_scope() { end(); }
+
+    void
+    end()
+    {
+        if (!m_active)
+            return;
+        m_active = false;
+        record_trace_event(m_span, m_begin, psp_curtime());
+    }
+
+    t_trace_scope(const t_trace_scope&) = delete;
+    t_trace_scope& operator=(const t_trace_scope&) = delete;
+
+private:
+    t_trace_span m_span;
+    t_bool m_active;
+    t_int64 m_begin;
+};
+
+} // end namespace perspective
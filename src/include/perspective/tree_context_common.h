@@ -13,6 +13,7 @@
 #include <perspective/shared_ptrs.h>
 #include <perspective/config.h>
 #include <perspective/gnode_state.h>
+#include <perspective/strand_cache.h>
 #include <perspective/traversal.h>
 
 namespace perspective
@@ -30,13 +31,16 @@ PERSPECTIVE_EXPORT void notify_sparse_tree(t_stree_sptr tree,
     const t_sortsvec& ctx_sortby, const t_table& flattened,
     const t_table& delta, const t_table& prev, const t_table& current,
     const t_table& transitions, const t_table& existed, const t_config& config,
-    const t_gstate& gstate);
+    const t_gstate& gstate, t_filter_cache* filter_cache = nullptr,
+    t_strand_cache* strand_cache = nullptr);
 
 PERSPECTIVE_EXPORT void notify_sparse_tree(t_stree_sptr tree,
     t_trav_sptr traversal, t_bool process_traversal,
     const t_aggspecvec& aggregates, const std::vector<t_sspair>& tree_sortby,
     const t_sortsvec& ctx_sortby, const t_table& flattened,
-    const t_config& config, const t_gstate& gstate);
+    const t_config& config, const t_gstate& gstate,
+    t_filter_cache* filter_cache = nullptr,
+    t_strand_cache* strand_cache = nullptr);
 
 template <typename CONTEXT_T>
 void
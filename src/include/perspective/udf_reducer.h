@@ -0,0 +1,54 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2017, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <memory>
+#include <vector>
+
+namespace perspective
+{
+
+// A native reducer, selected by name from AGGTYPE_UDF_CPP_REDUCE_FLOAT64
+// aggregates. reduce() folds the non null values of every row under a node
+// at depth lvl_depth.
+//
+// Reducers whose result is also their whole running state (sums, products,
+// sums of squares...) can return true from is_incremental(). Nodes then
+// start from initial() and only see the rows that changed: retract() takes
+// a row's old value back out and combine() folds its new value in, so
+// reduce() is never called.
+class PERSPECTIVE_EXPORT t_udf_reducer
+{
+public:
+    virtual ~t_udf_reducer();
+
+    virtual t_float64 reduce(
+        const std::vector<t_float64>& values, t_uindex lvl_depth) const = 0;
+
+    virtual t_bool is_incremental() const;
+    virtual t_float64 initial() const;
+    virtual t_float64 combine(t_float64 acc, t_float64 value) const;
+    virtual t_float64 retract(t_float64 acc, t_float64 value) const;
+};
+
+typedef std::shared_ptr<const t_udf_reducer> t_udf_reducer_csptr;
+
+// Registers reducer under name, replacing any previous one. Aggregates look
+// their reducer up when the tree is updated, so it has to be registered
+// before data reaches a context using it.
+PERSPECTIVE_EXPORT void register_udf_reducer(
+    const t_str& name, t_udf_reducer_csptr reducer);
+
+// Null if nothing is registered under name.
+PERSPECTIVE_EXPORT t_udf_reducer_csptr get_udf_reducer(const t_str& name);
+
+} // end namespace perspective
@@ -26,6 +26,11 @@ public:
     virtual void run(t_uindex gnode_id);
 
 private:
+    // Hands the pending batch of every gnode to its next _process(),
+    // returns whether anything was sent. Requires the pool mutex.
+    t_bool swap_input_ports();
+    void process_gnodes();
+
     t_pool& m_pool;
 };
 
@@ -79,4 +79,35 @@ private:
     t_lstore_sptr m_extents;
 };
 
+// Maps the string ids of src to those of the same strings in dst, interning
+// each string into dst the first time its id is translated. Remapping a
+// column of ids then costs one hash per distinct string instead of one per
+// row.
+class PERSPECTIVE_EXPORT t_vocab_translation
+{
+public:
+    t_vocab_translation(const t_vocab& src, t_vocab& dst);
+
+    t_uindex
+    translate(t_uindex sid)
+    {
+        if (m_identity)
+            return sid;
+        if (sid >= m_ids.size())
+            m_ids.resize(sid + 1, UNMAPPED);
+        t_uindex& did = m_ids[sid];
+        if (did == UNMAPPED)
+            did = m_dst.get_interned(m_src.unintern_c(sid));
+        return did;
+    }
+
+private:
+    static const t_uindex UNMAPPED = std::numeric_limits<t_uindex>::max();
+
+    const t_vocab& m_src;
+    t_vocab& m_dst;
+    t_bool m_identity;
+    std::vector<t_uindex> m_ids;
+};
+
 } // end namespace perspective
@@ -23,8 +23,20 @@
 #include <perspective/none.h>
 #include <perspective/gnode.h>
 #include <perspective/sym_table.h>
+#include <perspective/loader.h>
+#include <perspective/arrow_loader.h>
+#include <perspective/parallel.h>
+#include <perspective/order_stats.h>
+#include <perspective/pkey_index.h>
+#include <perspective/pool.h>
+#include <perspective/multi_sort.h>
+#include <perspective/sort_keys.h>
+#include <perspective/udf_reducer.h>
+#include <perspective/gnode_state.h>
+#include <perspective/trace.h>
 #include <gtest/gtest.h>
 #include <limits>
+#include <numeric>
 #include <cmath>
 #include <sstream>
 
@@ -166,7 +178,123 @@ TEST(TABLE, simplest_test)
     tbl.reserve(5);
 }
 
-#ifndef WIN32
+TEST(TABLE, filter_matches_row_filter)
+{
+    t_schema sch{{"i", "f", "s", "d"},
+        {DTYPE_INT64, DTYPE_FLOAT64, DTYPE_STR, DTYPE_DATE}};
+    std::mt19937 gen(17);
+    std::uniform_int_distribution<t_int64> dist(-5, 5);
+    const char* strs[] = {"a", "b", "ca", "cb"};
+
+    // More rows than a block of words, with nulls and NaNs
+    std::vector<t_tscalvec> rows;
+    for (t_uindex ridx = 0; ridx < 5000; ++ridx)
+    {
+        t_int64 v = dist(gen);
+        t_tscalar f = mktscalar<t_float64>(v / 2.0);
+        if (v == -5)
+            f = mknull(DTYPE_FLOAT64);
+        else if (v == 5)
+            f = mktscalar<t_float64>(std::nan(""));
+        t_tscalar i = v == 4 ? mknull(DTYPE_INT64) : mktscalar<t_int64>(v);
+        t_tscalar str = v == 3 ? mknull(DTYPE_STR)
+                               : mktscalar<const char*>(strs[(v + 5) % 4]);
+        rows.push_back({i, f, str, mktscalar(t_date(2018, 1, 10 + v))});
+    }
+    t_table tbl(sch, rows);
+
+    auto row_filter = [&tbl](t_filter_op combiner, t_ftermvec fterms) {
+        std::vector<t_bool> rv;
+        for (auto& ft : fterms)
+        {
+            ft.coerce_numeric(tbl.get_const_column(ft.m_colname)->get_dtype());
+        }
+        for (t_uindex ridx = 0; ridx < tbl.size(); ++ridx)
+        {
+            t_bool pass = combiner == FILTER_OP_AND;
+            for (const auto& ft : fterms)
+            {
+                auto col = tbl.get_const_column(ft.m_colname);
+                auto cell = col->get_scalar(ridx);
+                t_bool tval = ft(cell);
+                if (combiner == FILTER_OP_AND && (!cell.is_valid() || !tval))
+                {
+                    pass = false;
+                    break;
+                }
+                if (combiner == FILTER_OP_OR && tval)
+                {
+                    pass = true;
+                    break;
+                }
+            }
+            rv.push_back(pass);
+        }
+        return rv;
+    };
+
+    auto d = mktscalar(t_date(2018, 1, 10));
+    std::vector<std::pair<t_filter_op, t_ftermvec>> filters{
+        {FILTER_OP_AND,
+            {t_fterm("i", FILTER_OP_GT, 1_ts, {}),
+                t_fterm("f", FILTER_OP_LTEQ, 2.0_ts, {}),
+                t_fterm("s", FILTER_OP_EQ, "b"_ts, {})}},
+        {FILTER_OP_AND,
+            {t_fterm("f", FILTER_OP_GTEQ, 0_ts, {}, true, false),
+                t_fterm("d", FILTER_OP_NE, d, {}),
+                t_fterm("i", FILTER_OP_IN, mknone(),
+                    {1_ts, mktscalar<t_int64>(-3)})}},
+        {FILTER_OP_AND,
+            {t_fterm("f", FILTER_OP_IS_NAN, mknone(), {}, true, false),
+                t_fterm("s", FILTER_OP_NE, "a"_ts, {}, true, false)}},
+        {FILTER_OP_OR,
+            {t_fterm("i", FILTER_OP_LT, mktscalar<t_int64>(-3), {}),
+                t_fterm("f", FILTER_OP_EQ, 1_ts, {}),
+                t_fterm("s", FILTER_OP_BEGINS_WITH, "c"_ts, {})}},
+        {FILTER_OP_OR,
+            {t_fterm("d", FILTER_OP_LTEQ, d, {}, true, false),
+                t_fterm("f", FILTER_OP_NE, 0.5_ts, {}),
+                t_fterm("i", FILTER_OP_NOT_IN, mknone(), {0_ts})}},
+        {FILTER_OP_OR,
+            {t_fterm("s", FILTER_OP_EQ, "b"_ts, {}),
+                t_fterm("s", FILTER_OP_IN, mknone(), {"a"_ts, "zz"_ts, 1_ts}),
+                t_fterm("s", FILTER_OP_CONTAINS, "B"_ts, {})}},
+        {FILTER_OP_OR,
+            {t_fterm("s", FILTER_OP_NOT_IN, mknone(), {"a"_ts, "b"_ts}, true,
+                 false),
+                t_fterm("s", FILTER_OP_NE, "ca"_ts, {}, true, false),
+                t_fterm("s", FILTER_OP_EQ, 1_ts, {})}},
+        {FILTER_OP_AND,
+            {t_fterm("s", FILTER_OP_IN, mknone(), {"ca"_ts, "cb"_ts}),
+                t_fterm("s", FILTER_OP_ENDS_WITH, "A"_ts, {}, true, false),
+                t_fterm("s", FILTER_OP_GTEQ, "b"_ts, {})}},
+        {FILTER_OP_AND, t_ftermvec{}}, {FILTER_OP_OR, t_ftermvec{}}};
+
+    for (const auto& filter : filters)
+    {
+        auto expected = row_filter(filter.first, filter.second);
+        auto mask = tbl.filter_cpp(filter.first, filter.second);
+        ASSERT_EQ(mask->size(), tbl.size());
+        for (t_uindex ridx = 0; ridx < tbl.size(); ++ridx)
+        {
+            EXPECT_EQ(expected[ridx], mask->get(ridx)) << ridx;
+        }
+
+        t_mask select(tbl.size());
+        for (t_uindex ridx = 0; ridx < tbl.size(); ridx += 3)
+        {
+            select.set(ridx);
+        }
+        mask = tbl.filter_cpp(filter.first, filter.second, &select);
+        for (t_uindex ridx = 0; ridx < tbl.size(); ++ridx)
+        {
+            EXPECT_EQ(expected[ridx] && ridx % 3 == 0, mask->get(ridx)) << ridx;
+        }
+    }
+}
+
+// These rely on PSP_VERBOSE_ASSERT, which is compiled out of release builds
+#if !defined(WIN32) && defined(PSP_DEBUG)
 TEST(GNODE, explicit_pkey)
 {
     t_gnode_options options;
@@ -225,6 +353,37 @@ TEST(STORAGE, extend_1)
     ASSERT_EQ(s.size(), sizeof(t_int64) * 10);
 }
 
+TEST(COLUMN, str_append_and_copy_translate_ids)
+{
+    t_schema sch{{"s"}, {DTYPE_STR}};
+    t_table dst(sch, {{"x"_ts}, {"y"_ts}});
+    t_table src(sch, {{"y"_ts}, {"z"_ts}, {mknull(DTYPE_STR)}, {"z"_ts}});
+    auto scol = src.get_const_column("s");
+
+    auto check = [](t_col_csptr col, const std::vector<const char*>& want) {
+        ASSERT_EQ(col->size(), want.size());
+        for (t_uindex idx = 0; idx < want.size(); ++idx)
+        {
+            auto value = col->get_scalar(idx);
+            EXPECT_EQ(value.is_valid(), want[idx] != nullptr) << idx;
+            if (want[idx])
+                EXPECT_STREQ(value.get_char_ptr(), want[idx]) << idx;
+        }
+    };
+
+    auto acol = dst.get_column("s");
+    acol->append(*scol);
+    check(acol, {"x", "y", "y", "z", nullptr, "z"});
+    // Equal strings share their id
+    EXPECT_EQ(*acol->get_nth<t_uindex>(1), *acol->get_nth<t_uindex>(2));
+    EXPECT_EQ(*acol->get_nth<t_uindex>(3), *acol->get_nth<t_uindex>(5));
+
+    t_table copied(sch, {{"q"_ts}, {"q"_ts}, {"q"_ts}, {"q"_ts}});
+    auto ccol = copied.get_column("s");
+    ccol->copy(scol.get(), {3, 0, 2}, 1);
+    check(ccol, {"q", "z", "y", nullptr});
+}
+
 // TODO add assert eqs here
 TEST(CONTEXT_ONE, pivot_1)
 {
@@ -834,7 +993,8 @@ public:
     t_tscalvec
     get_data()
     {
-        return m_ctx->get_table();
+        return m_ctx->get_data(
+            0, m_ctx->get_row_count(), 0, m_ctx->get_column_count());
     }
 
     void
@@ -844,7 +1004,7 @@ public:
         {
             t_table itbl(m_ischema, sd.first);
             this->m_g->_send_and_process(itbl);
-            EXPECT_EQ(this->m_ctx->get_data(), sd.second);
+            EXPECT_EQ(get_data(), sd.second);
         }
     }
 
@@ -1079,6 +1239,26 @@ TEST_F(F64Ctx1MeanTest, test_3)
 
     run(data);
 }
+
+TEST_F(F64Ctx1MeanTest, test_4)
+{
+    t_testdata data{
+        {{{iop, 1_ts, 1_ts, 3_ts}, {iop, 2_ts, 1_ts, 5_ts},
+             {iop, 3_ts, 2_ts, 4_ts}},
+            {"Grand Aggregate"_ts, 4._ts, 1_ts, 4._ts, 2_ts, 4._ts}},
+        {{{iop, 1_ts, 1_ts, 9_ts}},
+            {"Grand Aggregate"_ts, 6._ts, 1_ts, 7._ts, 2_ts, 4._ts}},
+        {{{iop, 2_ts, 2_ts, 5_ts}},
+            {"Grand Aggregate"_ts, 6._ts, 1_ts, 9._ts, 2_ts, 4.5_ts}},
+        {{{dop, 1_ts, 1_ts, 9_ts}},
+            {"Grand Aggregate"_ts, 4.5_ts, 2_ts, 4.5_ts}},
+        {{{iop, 4_ts, 2_ts, i64_null}},
+            {"Grand Aggregate"_ts, 4.5_ts, 2_ts, 4.5_ts}},
+        {{{iop, 4_ts, 2_ts, 6_ts}},
+            {"Grand Aggregate"_ts, 5._ts, 2_ts, 5._ts}}};
+
+    run(data);
+}
 // clang-format on
 
 class F64Ctx1UniqueTest : public CtxTest<F64Ctx1UniqueTest, t_ctx1>
@@ -1260,6 +1440,93 @@ TEST_F(F64Ctx1MedianTest, test_4) {
 
     run(data);
 }
+
+TEST_F(F64Ctx1MedianTest, test_5) {
+    t_testdata data{
+        {
+            {{iop, 1_ts, 1_ts, 1_ts},
+            {iop, 2_ts, 1_ts, 2_ts},
+            {iop, 3_ts, 1_ts, 3_ts},
+            {iop, 4_ts, 2_ts, 10_ts},
+            {iop, 5_ts, 2_ts, 20_ts}},
+            {"Grand Aggregate"_ts, 3_ts, 1_ts, 2_ts, 2_ts, 20_ts }
+        },
+        {
+            {{iop, 2_ts, 1_ts, 30_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 3_ts, 2_ts, 20_ts }
+        },
+        {
+            {{iop, 3_ts, 2_ts, 3_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 30_ts, 2_ts, 10_ts }
+        },
+        {
+            {{dop, 5_ts, 2_ts, 20_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 30_ts, 2_ts, 10_ts }
+        }
+    };
+
+    run(data);
+}
+
+TEST_F(F64Ctx1MedianTest, test_6) {
+    m_ctx->set_order_stats_enabled(true);
+
+    t_testdata data{
+        {
+            {{iop, 1_ts, 1_ts, 1_ts},
+            {iop, 2_ts, 1_ts, 2_ts},
+            {iop, 3_ts, 1_ts, 3_ts},
+            {iop, 4_ts, 2_ts, 10_ts},
+            {iop, 5_ts, 2_ts, 20_ts}},
+            {"Grand Aggregate"_ts, 3_ts, 1_ts, 2_ts, 2_ts, 20_ts }
+        },
+        {
+            {{iop, 2_ts, 1_ts, 30_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 3_ts, 2_ts, 20_ts }
+        },
+        {
+            {{iop, 3_ts, 2_ts, 3_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 30_ts, 2_ts, 10_ts }
+        },
+        {
+            {{dop, 5_ts, 2_ts, 20_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 30_ts, 2_ts, 10_ts }
+        }
+    };
+
+    run(data);
+}
+
+TEST_F(F64Ctx1MedianTest, test_7) {
+    t_testdata before{
+        {
+            {{iop, 1_ts, 1_ts, 1_ts},
+            {iop, 2_ts, 1_ts, 2_ts},
+            {iop, 3_ts, 1_ts, 3_ts},
+            {iop, 4_ts, 2_ts, 10_ts},
+            {iop, 5_ts, 2_ts, 20_ts}},
+            {"Grand Aggregate"_ts, 3_ts, 1_ts, 2_ts, 2_ts, 20_ts }
+        }
+    };
+    t_testdata after{
+        {
+            {{iop, 2_ts, 1_ts, 30_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 3_ts, 2_ts, 20_ts }
+        },
+        {
+            {{iop, 3_ts, 2_ts, 3_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 30_ts, 2_ts, 10_ts }
+        },
+        {
+            {{dop, 5_ts, 2_ts, 20_ts}},
+            {"Grand Aggregate"_ts, 10_ts, 1_ts, 30_ts, 2_ts, 10_ts }
+        }
+    };
+
+    run(before);
+    m_ctx->set_order_stats_enabled(true);
+    run(after);
+}
 // clang-format on
 
 class F64Ctx1JoinTest : public CtxTest<F64Ctx1JoinTest, t_ctx1>
@@ -1650,6 +1917,27 @@ TEST_F(F64Ctx1WMeanTest, test_4) {
 //     run(data);
 // }
 
+TEST_F(F64Ctx1WMeanTest, test_6) {
+    t_testdata data{
+        {
+            {{iop, 1_ts, 1_ts, 3_ts},
+            {iop, 2_ts, 2_ts, 1_ts},
+            {iop, 3_ts, 2_ts, 4_ts}},
+            {"Grand Aggregate"_ts, 2.6_ts, 1_ts, 3._ts, 2_ts, 2.5_ts }
+        },
+        {
+            {{iop, 2_ts, 2_ts, 3_ts}},
+            {"Grand Aggregate"_ts, 3.4_ts, 1_ts, 3._ts, 2_ts, 3.5_ts }
+        },
+        {
+            {{dop, 3_ts, 2_ts, 4_ts}},
+            {"Grand Aggregate"_ts, 3._ts, 1_ts, 3._ts, 2_ts, 3._ts }
+        }
+    };
+
+    run(data);
+}
+
 // clang-format on
 
 class F64Ctx1FirstTest : public CtxTest<F64Ctx1FirstTest, t_ctx1>
@@ -1699,6 +1987,58 @@ TEST_F(F64Ctx1FirstTest, test_2) {
     run(data);
 }
 
+TEST_F(F64Ctx1FirstTest, test_3) {
+    t_testdata data{
+        {
+            {{iop, 1_ts, 1_ts, 1_ts, 4_ts},
+            {iop, 2_ts, 1_ts, 2_ts, 3_ts},
+            {iop, 3_ts, 1_ts, 3_ts, 2_ts}},
+            {"Grand Aggregate"_ts, 1_ts, 1_ts, 1_ts }
+        },
+        {
+            {{iop, 3_ts, 1_ts, 3_ts, 9_ts}},
+            {"Grand Aggregate"_ts, 3_ts, 1_ts, 3_ts }
+        },
+        {
+            {{dop, 3_ts, 1_ts, 3_ts, 9_ts}},
+            {"Grand Aggregate"_ts, 1_ts, 1_ts, 1_ts }
+        },
+        {
+            {{iop, 4_ts, 2_ts, 7_ts, 5_ts}},
+            {"Grand Aggregate"_ts, 7_ts, 1_ts, 1_ts, 2_ts, 7_ts }
+        }
+    };
+
+    run(data);
+}
+
+TEST_F(F64Ctx1FirstTest, test_4) {
+    m_ctx->set_order_stats_enabled(true);
+
+    t_testdata data{
+        {
+            {{iop, 1_ts, 1_ts, 1_ts, 4_ts},
+            {iop, 2_ts, 1_ts, 2_ts, 3_ts},
+            {iop, 3_ts, 1_ts, 3_ts, 2_ts}},
+            {"Grand Aggregate"_ts, 1_ts, 1_ts, 1_ts }
+        },
+        {
+            {{iop, 3_ts, 1_ts, 3_ts, 9_ts}},
+            {"Grand Aggregate"_ts, 3_ts, 1_ts, 3_ts }
+        },
+        {
+            {{dop, 3_ts, 1_ts, 3_ts, 9_ts}},
+            {"Grand Aggregate"_ts, 1_ts, 1_ts, 1_ts }
+        },
+        {
+            {{iop, 4_ts, 2_ts, 7_ts, 5_ts}},
+            {"Grand Aggregate"_ts, 7_ts, 1_ts, 1_ts, 2_ts, 7_ts }
+        }
+    };
+
+    run(data);
+}
+
 // clang-format on
 
 class F64Ctx1LastTest : public CtxTest<F64Ctx1LastTest, t_ctx1>
@@ -1749,6 +2089,146 @@ TEST_F(F64Ctx1LastTest, test_2) {
 }
 // clang-format on
 
+struct t_sum_squares_reducer : public t_udf_reducer
+{
+    t_float64
+    reduce(const std::vector<t_float64>& values, t_uindex lvl_depth) const
+    {
+        t_float64 rval = 0;
+        for (auto v : values)
+            rval += v * v;
+        return rval;
+    }
+
+    t_bool
+    is_incremental() const
+    {
+        return true;
+    }
+
+    t_float64
+    combine(t_float64 acc, t_float64 value) const
+    {
+        return acc + value * value;
+    }
+
+    t_float64
+    retract(t_float64 acc, t_float64 value) const
+    {
+        return acc - value * value;
+    }
+};
+
+// Spread of the values under a node, scaled by the node's depth.
+struct t_depth_range_reducer : public t_udf_reducer
+{
+    t_float64
+    reduce(const std::vector<t_float64>& values, t_uindex lvl_depth) const
+    {
+        if (values.empty())
+            return 0;
+        auto mm = std::minmax_element(values.begin(), values.end());
+        return (*mm.second - *mm.first) * (lvl_depth + 1);
+    }
+};
+
+class F64Ctx1CppReduceTest : public CtxTest<F64Ctx1CppReduceTest, t_ctx1>
+{
+public:
+    t_schema
+    get_ischema()
+    {
+        return t_schema{{"psp_op", "psp_pkey", "x", "y"},
+            {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_FLOAT64}};
+    }
+
+    t_config
+    get_config()
+    {
+        register_udf_reducer(
+            "sum_squares", std::make_shared<t_sum_squares_reducer>());
+        return t_config{{"x"},
+            t_aggspec("sum_squares_y", AGGTYPE_UDF_CPP_REDUCE_FLOAT64,
+                {{"y", DEPTYPE_COLUMN}}, "sum_squares")};
+    }
+};
+
+// clang-format off
+
+TEST_F(F64Ctx1CppReduceTest, test_1) {
+    t_tscalar f64_null = mknull(DTYPE_FLOAT64);
+    t_testdata data{
+        {
+            {{iop, 1_ts, 1_ts, 1._ts},
+            {iop, 2_ts, 1_ts, 2._ts},
+            {iop, 3_ts, 2_ts, 3._ts}},
+            {"Grand Aggregate"_ts, 14._ts, 1_ts, 5._ts, 2_ts, 9._ts }
+        },
+        {
+            {{iop, 2_ts, 1_ts, 4._ts}},
+            {"Grand Aggregate"_ts, 26._ts, 1_ts, 17._ts, 2_ts, 9._ts }
+        },
+        {
+            {{iop, 1_ts, 2_ts, 1._ts}},
+            {"Grand Aggregate"_ts, 26._ts, 1_ts, 16._ts, 2_ts, 10._ts }
+        },
+        {
+            {{dop, 3_ts, 2_ts, 3._ts}},
+            {"Grand Aggregate"_ts, 17._ts, 1_ts, 16._ts, 2_ts, 1._ts }
+        },
+        {
+            {{iop, 4_ts, 1_ts, f64_null}},
+            {"Grand Aggregate"_ts, 17._ts, 1_ts, 16._ts, 2_ts, 1._ts }
+        }
+    };
+
+    run(data);
+}
+
+// clang-format on
+
+class F64Ctx1CppRangeTest : public CtxTest<F64Ctx1CppRangeTest, t_ctx1>
+{
+public:
+    t_schema
+    get_ischema()
+    {
+        return t_schema{{"psp_op", "psp_pkey", "x", "y"},
+            {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_FLOAT64}};
+    }
+
+    t_config
+    get_config()
+    {
+        register_udf_reducer(
+            "depth_range", std::make_shared<t_depth_range_reducer>());
+        return t_config{{"x"},
+            t_aggspec("range_y", AGGTYPE_UDF_CPP_REDUCE_FLOAT64,
+                {{"y", DEPTYPE_COLUMN}}, "depth_range")};
+    }
+};
+
+// clang-format off
+
+TEST_F(F64Ctx1CppRangeTest, test_1) {
+    t_testdata data{
+        {
+            {{iop, 1_ts, 1_ts, 1._ts},
+            {iop, 2_ts, 1_ts, 2._ts},
+            {iop, 3_ts, 2_ts, 5._ts}},
+            {"Grand Aggregate"_ts, 4._ts, 1_ts, 2._ts, 2_ts, 0._ts }
+        },
+        {
+            {{iop, 2_ts, 1_ts, 4._ts}},
+            {"Grand Aggregate"_ts, 4._ts, 1_ts, 6._ts, 2_ts, 0._ts }
+        }
+    };
+
+    run(data);
+}
+
+// clang-format on
+
 class F64Ctx1HWMTest : public CtxTest<F64Ctx1HWMTest, t_ctx1>
 {
 public:
@@ -2160,51 +2640,96 @@ TEST_F(F64Ctx1SumNotNullTest, test_3) {
 
 // clang-format on
 
-class I64Ctx2SumTest : public CtxTest<I64Ctx2SumTest, t_ctx2>
+class F64Ctx1SumNanTest : public CtxTest<F64Ctx1SumNanTest, t_ctx1>
 {
 public:
     t_schema
     get_ischema()
     {
-        return t_schema{{"psp_op", "psp_pkey", "a", "b", "x"},
-            {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_STR, DTYPE_INT64}};
+        return t_schema{{"psp_op", "psp_pkey", "x", "y"},
+            {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64, DTYPE_FLOAT64}};
     }
 
     t_config
     get_config()
     {
-        return t_config{{"a"}, {"b"}, {{"sum_x", AGGTYPE_SUM, "x"}},
-            TOTALS_HIDDEN, FILTER_OP_AND, {}};
+        return t_config{{"x"}, {"sum_y", AGGTYPE_SUM, "y"}};
     }
 };
 
 // clang-format off
-TEST_F(I64Ctx2SumTest, test_1) {
+TEST_F(F64Ctx1SumNanTest, test_1) {
     t_testdata data{
         {
-            {},
-            {"Grand Aggregate"_ts}
-        }
-    };
-
-    run(data);
-}
-
-TEST_F(I64Ctx2SumTest, test_2) {
-    t_testdata data{
+            {{iop, 1_ts, 1_ts, 1._ts},
+            {iop, 2_ts, 1_ts, s_nan64},
+            {iop, 3_ts, 2_ts, 2._ts}},
+            {"Grand Aggregate"_ts, s_nan64, 1_ts, s_nan64, 2_ts, 2._ts }
+        },
         {
-            {{iop, 1_ts, "0"_ts, "0"_ts, 0_ts},
-            {iop, 2_ts, "0"_ts, "1"_ts, 0_ts},
-            {iop, 3_ts, "1"_ts, "0"_ts, 0_ts},
-            {iop, 4_ts, "1"_ts, "1"_ts, 1_ts}},
-            {"Grand Aggregate"_ts, 0_ts, 1_ts, "0"_ts, 0_ts, 0_ts, "1"_ts, 0_ts, 1_ts}
+            {{iop, 2_ts, 1_ts, 3._ts}},
+            {"Grand Aggregate"_ts, 6._ts, 1_ts, 4._ts, 2_ts, 2._ts }
+        },
+        {
+            {{iop, 1_ts, 2_ts, s_nan64}},
+            {"Grand Aggregate"_ts, s_nan64, 1_ts, 3._ts, 2_ts, s_nan64 }
+        },
+        {
+            {{dop, 1_ts, 2_ts, s_nan64}},
+            {"Grand Aggregate"_ts, 5._ts, 1_ts, 3._ts, 2_ts, 2._ts }
         }
     };
 
     run(data);
 }
 
-TEST_F(I64Ctx2SumTest, test_3) {
+// clang-format on
+
+class I64Ctx2SumTest : public CtxTest<I64Ctx2SumTest, t_ctx2>
+{
+public:
+    t_schema
+    get_ischema()
+    {
+        return t_schema{{"psp_op", "psp_pkey", "a", "b", "x"},
+            {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_STR, DTYPE_INT64}};
+    }
+
+    t_config
+    get_config()
+    {
+        return t_config{{"a"}, {"b"}, {{"sum_x", AGGTYPE_SUM, "x"}},
+            TOTALS_HIDDEN, FILTER_OP_AND, {}};
+    }
+};
+
+// clang-format off
+TEST_F(I64Ctx2SumTest, test_1) {
+    t_testdata data{
+        {
+            {},
+            {"Grand Aggregate"_ts}
+        }
+    };
+
+    run(data);
+}
+
+TEST_F(I64Ctx2SumTest, test_2) {
+    t_testdata data{
+        {
+            {{iop, 1_ts, "0"_ts, "0"_ts, 0_ts},
+            {iop, 2_ts, "0"_ts, "1"_ts, 0_ts},
+            {iop, 3_ts, "1"_ts, "0"_ts, 0_ts},
+            {iop, 4_ts, "1"_ts, "1"_ts, 1_ts}},
+            {"Grand Aggregate"_ts, 0_ts, 1_ts, "0"_ts, 0_ts, 0_ts, "1"_ts, 0_ts, 1_ts}
+        }
+    };
+
+    run(data);
+}
+
+TEST_F(I64Ctx2SumTest, test_3) {
     t_testdata data{
         {
             {{iop, 1_ts, "0"_ts, "0"_ts, 0_ts},
@@ -2302,8 +2827,418 @@ TEST_F(Ctx0Test, test_3) {
 }
 // clang-format on
 
+// Random ticks for the t_ctx0 step tests, over psp_op, psp_pkey, a float
+// "x" and a string "s". Values come from a few choices so sort keys often
+// tie and pkeys from a small range so steps update and delete rows.
+class t_ctx0_test_ticks
+{
+public:
+    t_ctx0_test_ticks(t_uint32 seed, t_int64 npkeys)
+        : m_gen(seed)
+        , m_pkey_dist(0, npkeys - 1)
+        , m_val_dist(0, 9)
+    {
+    }
+
+    t_tscalar
+    pkey()
+    {
+        return mktscalar<t_int64>(m_pkey_dist(m_gen));
+    }
+
+    t_tscalar
+    value()
+    {
+        return mktscalar<t_int64>(m_val_dist(m_gen));
+    }
+
+    t_tscalvec
+    insert(const t_tscalar& pkey)
+    {
+        static const char* strs[] = {"a", "b", "c"};
+        return {iop, pkey, mktscalar<t_float64>(t_float64(m_val_dist(m_gen))),
+            mktscalar<const char*>(strs[m_val_dist(m_gen) % 3])};
+    }
+
+    // A large first step, then small ticks mixing adds, updates and deletes
+    std::vector<t_tscalvec>
+    step(t_uindex step)
+    {
+        t_uindex nrows = step == 0 ? 150 : 6;
+        std::vector<t_tscalvec> rows;
+        for (t_uindex ridx = 0; ridx < nrows; ++ridx)
+        {
+            auto pk = pkey();
+            if (step > 0 && ridx % 3 == 2)
+            {
+                rows.push_back({dop, pk, mknone(), mknone()});
+                continue;
+            }
+            rows.push_back(insert(pk));
+        }
+        return rows;
+    }
+
+private:
+    std::mt19937 m_gen;
+    std::uniform_int_distribution<t_int64> m_pkey_dist;
+    std::uniform_int_distribution<t_int64> m_val_dist;
+};
+
+TEST(CONTEXT_ZERO, sorted_steps_match_full_sort)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x", "s"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_FLOAT64, DTYPE_STR}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+    auto ctx = t_ctx0::build(sch, t_config{{"x", "s"}});
+    gn->register_context("ctx0", ctx);
+
+    t_sortsvec sortby{{0, SORTTYPE_DESCENDING}, {1, SORTTYPE_ASCENDING}};
+    ctx->sort_by(sortby);
+
+    auto get_order = [&ctx]() {
+        std::vector<t_uidxpair> cells;
+        for (t_index ridx = 0; ridx < ctx->get_row_count(); ++ridx)
+        {
+            cells.push_back(t_uidxpair(ridx, 0));
+        }
+        return ctx->get_pkeys(cells);
+    };
+
+    t_ctx0_test_ticks ticks(7, 200);
+
+    for (t_uindex step = 0; step < 30; ++step)
+    {
+        gn->_send_and_process(t_table(sch, ticks.step(step)));
+
+        auto merged = get_order();
+        EXPECT_EQ(t_index(merged.size()), ctx->get_row_count());
+        ctx->sort_by(sortby);
+        EXPECT_EQ(merged, get_order());
+    }
+}
+
+TEST(CONTEXT_ZERO, sort_window_matches_full_sort)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x", "s"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_FLOAT64, DTYPE_STR}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+    auto full = t_ctx0::build(sch, t_config{{"x", "s"}});
+    auto windowed = t_ctx0::build(sch, t_config{{"x", "s"}});
+    gn->register_context("full", full);
+    gn->register_context("windowed", windowed);
+
+    const t_index window = 8;
+    t_sortsvec sortby{{0, SORTTYPE_DESCENDING}, {1, SORTTYPE_ASCENDING}};
+    full->sort_by(sortby);
+    windowed->sort_by(sortby);
+    windowed->set_sort_window(window);
+
+    auto get_order = [](t_ctx0_sptr ctx, t_index nrows) {
+        std::vector<t_uidxpair> cells;
+        for (t_index ridx = 0; ridx < std::min(nrows, ctx->get_row_count());
+             ++ridx)
+        {
+            cells.push_back(t_uidxpair(ridx, 0));
+        }
+        return ctx->get_pkeys(cells);
+    };
+
+    t_ctx0_test_ticks ticks(13, 200);
+
+    for (t_uindex step = 0; step < 40; ++step)
+    {
+        // Ticks move rows in and out of the window, reading past it only
+        // every few steps so most steps merge into a partly sorted index
+        gn->_send_and_process(t_table(sch, ticks.step(step)));
+
+        EXPECT_EQ(full->get_row_count(), windowed->get_row_count());
+        EXPECT_EQ(get_order(full, window), get_order(windowed, window));
+
+        auto full_delta = full->get_cell_delta(0, window - 1);
+        auto windowed_delta = windowed->get_cell_delta(0, window - 1);
+        EXPECT_EQ(full_delta.size(), windowed_delta.size());
+        for (t_uindex idx = 0; idx < std::min(full_delta.size(),
+                                   windowed_delta.size());
+             ++idx)
+        {
+            EXPECT_EQ(full_delta[idx].row, windowed_delta[idx].row);
+        }
+        full->get_step_delta(0, window);
+        windowed->get_step_delta(0, window);
+
+        if (step % 5 == 4)
+        {
+            auto nrows = full->get_row_count();
+            EXPECT_EQ(get_order(full, nrows), get_order(windowed, nrows));
+        }
+    }
+}
+
+TEST(CONTEXT_ZERO, filtered_steps_match_fresh_context)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x", "s", "y"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_FLOAT64, DTYPE_STR, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_config cfg{{"x", "s", "y"}, FILTER_OP_AND,
+        {t_fterm("x", FILTER_OP_GT, 3_ts, {}),
+            t_fterm("s", FILTER_OP_IN, mknone(), {"a"_ts, "b"_ts})}};
+    t_sortsvec sortby{{0, SORTTYPE_ASCENDING}};
+    auto ctx = t_ctx0::build(sch, cfg);
+    gn->register_context("ctx0", ctx);
+    ctx->sort_by(sortby);
+
+    auto get_order = [](t_ctx0_sptr c) {
+        std::vector<t_uidxpair> cells;
+        for (t_index ridx = 0; ridx < c->get_row_count(); ++ridx)
+        {
+            cells.push_back(t_uidxpair(ridx, 0));
+        }
+        return c->get_pkeys(cells);
+    };
+
+    t_ctx0_test_ticks ticks(19, 100);
+
+    for (t_uindex step = 0; step < 30; ++step)
+    {
+        // Updates that only touch the unfiltered column keep their stored
+        // result, the others move rows in and out of the filter
+        t_uindex nrows = step == 0 ? 80 : 8;
+        std::vector<t_tscalvec> rows;
+        for (t_uindex ridx = 0; ridx < nrows; ++ridx)
+        {
+            auto pkey = ticks.pkey();
+            auto y = ticks.value();
+            switch (step == 0 ? 0 : ridx % 4)
+            {
+                case 1:
+                {
+                    rows.push_back({dop, pkey, mknone(), mknone(), mknone()});
+                }
+                break;
+                case 2:
+                {
+                    rows.push_back({iop, pkey, mknone(), mknone(), y});
+                }
+                break;
+                default:
+                {
+                    rows.push_back(ticks.insert(pkey));
+                    rows.back().push_back(y);
+                }
+            }
+        }
+
+        gn->_send_and_process(t_table(sch, rows));
+
+        auto fresh = t_ctx0::build(sch, cfg);
+        gn->register_context("fresh", fresh);
+        fresh->sort_by(sortby);
+        EXPECT_EQ(get_order(fresh), get_order(ctx));
+        gn->_unregister_context("fresh");
+    }
+}
+
+TEST(SORT_KEYS, matches_multisorter)
+{
+    std::vector<t_sorttype> order{SORTTYPE_DESCENDING, SORTTYPE_ASCENDING,
+        SORTTYPE_ASCENDING_ABS};
+    std::vector<t_dtype> dtypes{DTYPE_FLOAT64, DTYPE_STR, DTYPE_INT64};
+    const char* strs[] = {"x", "y", "z"};
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<t_int64> dist(-4, 4);
+
+    for (t_bool handle_nans : {false, true})
+    {
+        t_sort_keys keys;
+        t_sort_keys byte_keys;
+        keys.init(order, handle_nans);
+        byte_keys.init(order, handle_nans, dtypes);
+        t_mselemvec elems;
+
+        for (t_int64 pidx = 0; pidx < 300; ++pidx)
+        {
+            t_int64 v = dist(gen);
+            t_tscalvec row{
+                v == 4 ? mknone() : mktscalar<t_float64>(v == -4 ? NAN : v),
+                mktscalar<const char*>(strs[std::abs(v) % 3]),
+                mktscalar<t_int64>(dist(gen))};
+
+            auto pkey = mktscalar<t_int64>(pidx);
+            t_uindex slot = keys.alloc(pkey);
+            byte_keys.alloc(pkey);
+            for (t_uindex cidx = 0; cidx < row.size(); ++cidx)
+            {
+                keys.set_key(cidx, slot, row[cidx]);
+                byte_keys.set_key(cidx, slot, row[cidx]);
+            }
+            elems.push_back(t_mselem(pkey, row));
+        }
+
+        std::vector<t_uindex> slots(elems.size());
+        std::iota(slots.begin(), slots.end(), 0);
+        auto byte_slots = slots;
+        std::sort(slots.begin(), slots.end(),
+            [&keys](t_uindex a, t_uindex b) { return keys.less(a, b); });
+        std::sort(byte_slots.begin(), byte_slots.end(),
+            [&byte_keys](t_uindex a, t_uindex b) {
+                return byte_keys.less(a, b);
+            });
+        std::sort(elems.begin(), elems.end(), t_multisorter(order, handle_nans));
+
+        for (t_uindex idx = 0; idx < elems.size(); ++idx)
+        {
+            EXPECT_EQ(keys.get_pkey(slots[idx]), elems[idx].m_pkey);
+            EXPECT_EQ(byte_keys.get_pkey(byte_slots[idx]), elems[idx].m_pkey);
+        }
+    }
+}
+
+TEST(SORT_KEYS, byte_keys_match_multisorter)
+{
+    std::vector<std::vector<t_sorttype>> orders{
+        {SORTTYPE_DESCENDING, SORTTYPE_ASCENDING, SORTTYPE_ASCENDING_ABS},
+        {SORTTYPE_ASCENDING, SORTTYPE_DESCENDING, SORTTYPE_DESCENDING_ABS},
+        {SORTTYPE_ASCENDING_ABS, SORTTYPE_NONE, SORTTYPE_ASCENDING}};
+    std::vector<t_dtype> dtypes{DTYPE_FLOAT64, DTYPE_STR, DTYPE_INT64};
+    const char* strs[] = {"x", "y", "zzzzzzzzzz", "zzzzzzzzzy"};
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<t_int64> dist(-4, 4);
+
+    for (const auto& order : orders)
+    {
+        for (t_bool handle_nans : {false, true})
+        {
+            t_sort_keys keys;
+            t_sort_keys byte_keys;
+            keys.init(order, handle_nans);
+            byte_keys.init(order, handle_nans, dtypes);
+            EXPECT_EQ(keys.get_num_encoded_columns(), 0);
+            EXPECT_GT(byte_keys.get_num_encoded_columns(), 0);
+            t_mselemvec elems;
+
+            for (t_int64 pidx = 0; pidx < 300; ++pidx)
+            {
+                t_int64 v = dist(gen);
+                t_tscalvec row{v == 4
+                        ? mknull(DTYPE_FLOAT64)
+                        : mktscalar<t_float64>(v == -4 ? NAN : v / 2.0),
+                    mktscalar<const char*>(strs[std::abs(v) % 4]),
+                    mktscalar<t_int64>(dist(gen))};
+
+                auto pkey = mktscalar<t_int64>(pidx);
+                t_uindex slot = keys.alloc(pkey);
+                byte_keys.alloc(pkey);
+                for (t_uindex cidx = 0; cidx < row.size(); ++cidx)
+                {
+                    keys.set_key(cidx, slot, row[cidx]);
+                    byte_keys.set_key(cidx, slot, row[cidx]);
+                }
+                elems.push_back(t_mselem(pkey, row));
+            }
+
+            std::vector<t_uindex> slots(elems.size());
+            std::iota(slots.begin(), slots.end(), 0);
+            auto byte_slots = slots;
+            std::sort(slots.begin(), slots.end(),
+                [&keys](t_uindex a, t_uindex b) { return keys.less(a, b); });
+            std::sort(byte_slots.begin(), byte_slots.end(),
+                [&byte_keys](t_uindex a, t_uindex b) {
+                    return byte_keys.less(a, b);
+                });
+            std::sort(
+                elems.begin(), elems.end(), t_multisorter(order, handle_nans));
+
+            for (t_uindex idx = 0; idx < elems.size(); ++idx)
+            {
+                EXPECT_EQ(keys.get_pkey(slots[idx]), elems[idx].m_pkey);
+                EXPECT_EQ(
+                    byte_keys.get_pkey(byte_slots[idx]), elems[idx].m_pkey);
+            }
+        }
+    }
+}
+
 TEST(LOG_TEST, test_1) { psp_log(__FILE__, __LINE__, "log_test"); }
 
+TEST(TRACE, records_spans_when_enabled)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_FLOAT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+    auto ctx = t_ctx0::build(sch, t_config{{"x"}});
+    gn->register_context("ctx0", ctx);
+
+    auto send = [&](t_int64 pkey) {
+        gn->_send_and_process(t_table(sch,
+            {{iop, mktscalar<t_int64>(pkey), mktscalar<t_float64>(1)}}));
+    };
+
+    set_trace_enabled(false);
+    clear_trace();
+    send(0);
+    EXPECT_TRUE(get_trace_events().empty());
+
+    set_trace_enabled(true);
+    send(1);
+    set_trace_enabled(false);
+
+    auto events = get_trace_events();
+    std::map<t_trace_span, t_trace_event> by_span;
+    for (const auto& event : events)
+    {
+        by_span[event.m_span] = event;
+    }
+    for (auto span : {TRACE_GNODE_PROCESS, TRACE_GNODE_FLATTEN,
+             TRACE_GNODE_LOOKUP, TRACE_GNODE_PROCESS_COLUMNS,
+             TRACE_GNODE_UPDATE_HISTORY, TRACE_GNODE_NOTIFY_CONTEXTS,
+             TRACE_CTX0_NOTIFY})
+    {
+        EXPECT_EQ(by_span.count(span), 1) << get_trace_span_name(span);
+    }
+
+    // The process span encloses its phases and ends last
+    const auto& process = by_span[TRACE_GNODE_PROCESS];
+    const auto& notify = by_span[TRACE_CTX0_NOTIFY];
+    EXPECT_LE(process.m_begin, notify.m_begin);
+    EXPECT_LE(notify.m_begin + notify.m_duration,
+        process.m_begin + process.m_duration);
+    EXPECT_EQ(events.back().m_span, TRACE_GNODE_PROCESS);
+
+    auto json = get_trace_json();
+    EXPECT_EQ(json.find("{\"traceEvents\":[{\"name\":"), 0);
+    EXPECT_NE(json.find("\"name\":\"ctx0.notify\""), t_str::npos);
+    EXPECT_EQ(json.substr(json.size() - 2), "]}");
+
+    // Only the latest events are kept
+    set_trace_capacity(3);
+    set_trace_enabled(true);
+    send(2);
+    set_trace_enabled(false);
+    events = get_trace_events();
+    EXPECT_EQ(events.size(), 3);
+    EXPECT_EQ(events[0].m_span, TRACE_CTX0_NOTIFY);
+    EXPECT_EQ(events[1].m_span, TRACE_GNODE_NOTIFY_CONTEXTS);
+    EXPECT_EQ(events[2].m_span, TRACE_GNODE_PROCESS);
+
+    set_trace_capacity(0);
+    EXPECT_GT(get_trace_capacity(), 3);
+    EXPECT_TRUE(get_trace_events().empty());
+}
+
 TEST(IS_FLOATING_POINT, test_1)
 {
     EXPECT_TRUE(perspective::is_floating_point(DTYPE_FLOAT64));
@@ -2389,4 +3324,1234 @@ TEST(GNODE_TEST, get_registered_contexts)
     EXPECT_EQ(gn->get_registered_contexts().size(), 0);
 
     gn->reset();
-}
\ No newline at end of file
+}
+
+TEST(LOADER, expand_validity)
+{
+    // rows 0, 2 and 9 valid
+    t_uint8 bitmap[] = {0x05, 0x02};
+    std::vector<t_status> out(10);
+    expand_validity(bitmap, 0, 10, out.data());
+    std::vector<t_status> expected{STATUS_VALID, STATUS_INVALID, STATUS_VALID,
+        STATUS_INVALID, STATUS_INVALID, STATUS_INVALID, STATUS_INVALID,
+        STATUS_INVALID, STATUS_INVALID, STATUS_VALID};
+    EXPECT_EQ(out, expected);
+}
+
+TEST(LOADER, load_table)
+{
+    std::vector<t_int64> i{1, 2, 3};
+    std::vector<t_float64> f{1.5, 2.5, 3.5};
+    const char* sdata = "abcdef";
+    std::vector<t_int32> soffsets{0, 1, 3, 6};
+    t_uint8 fvalid = 0x05;
+
+    auto tbl = load_table(
+        {
+            t_column_buffer("i", DTYPE_INT64, i.data(), 3),
+            t_column_buffer("f", DTYPE_FLOAT64, f.data(), 3, &fvalid),
+            t_column_buffer("s", sdata, soffsets.data(), 3),
+        },
+        3);
+
+    EXPECT_EQ(tbl->size(), 3);
+    EXPECT_EQ(tbl->get_const_column("i")->get_scalar(2), 3_ts);
+    EXPECT_EQ(tbl->get_const_column("f")->get_scalar(0), 1.5_ts);
+    EXPECT_FALSE(tbl->get_const_column("f")->is_valid(1));
+    EXPECT_TRUE(tbl->get_const_column("f")->is_valid(2));
+    EXPECT_EQ(tbl->get_const_column("s")->get_scalar(1), "bc"_ts);
+    EXPECT_EQ(tbl->get_const_column("s")->get_scalar(2), "def"_ts);
+}
+
+TEST(LOADER, rejects_bad_buffers)
+{
+    std::vector<t_int64> i{1, 2, 3};
+    const char* sdata = "abc";
+
+    // a buffer shorter than the table would be read past its end
+    t_column_buffer short_buf("i", DTYPE_INT64, i.data(), 2);
+    EXPECT_THROW(load_table({short_buf}, 3), std::invalid_argument);
+
+    t_column_buffer no_offsets("s", sdata, nullptr, 3);
+    EXPECT_THROW(load_table({no_offsets}, 3), std::invalid_argument);
+
+    auto tbl = load_table({t_column_buffer("i", DTYPE_INT64, i.data(), 3)}, 3);
+    EXPECT_THROW(fill_column(tbl->_get_column("i"),
+                     t_column_buffer("i", DTYPE_INT32, i.data(), 3)),
+        std::invalid_argument);
+    EXPECT_THROW(fill_column(tbl->_get_column("i"),
+                     t_column_buffer("i", DTYPE_INT64, i.data(), 4)),
+        std::invalid_argument);
+}
+
+TEST(LOADER, load_table_into_gnode)
+{
+    std::vector<t_int64> pkey{1, 2, 1};
+    std::vector<t_int64> x{10, 20, 30};
+
+    auto tbl = load_table({t_column_buffer("k", DTYPE_INT64, pkey.data(), 3),
+                              t_column_buffer("x", DTYPE_INT64, x.data(), 3)},
+        3, "k");
+
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = tbl->get_schema();
+    auto gn = t_gnode::build(options);
+    auto ctx = t_ctx1::build(
+        tbl->get_schema(), t_config({"k"}, {"sum_x", AGGTYPE_SUM, "x"}));
+    gn->register_context("ctx", ctx);
+    gn->_send_and_process(*tbl);
+
+    t_tscalvec expected{"Grand Aggregate"_ts, 50_ts, 1_ts, 30_ts, 2_ts, 20_ts};
+    EXPECT_EQ(ctx->get_data(0, ctx->get_row_count(), 0, 2), expected);
+}
+
+TEST(LOADER, unpack_bits_words)
+{
+    // 3 bytes of head, two full words (all set, mixed) and a ragged tail
+    std::vector<t_uint8> bitmap(24, 0xFF);
+    bitmap[12] = 0x0F;
+    bitmap[23] = 0x00;
+    t_uindex offset = 5;
+    t_uindex nrows = 180;
+    std::vector<t_uint8> out(nrows);
+    unpack_bits(bitmap.data(), offset, nrows, out.data());
+
+    for (t_uindex idx = 0; idx < nrows; ++idx)
+    {
+        t_uindex bit = idx + offset;
+        EXPECT_EQ(out[idx], (bitmap[bit / 8] >> (bit % 8)) & 1);
+    }
+}
+
+struct t_arrow_test_column
+{
+    ArrowSchema m_schema;
+    ArrowArray m_array;
+    std::vector<const void*> m_buffers;
+};
+
+void
+arrow_test_init(t_arrow_test_column& c, const char* name, const char* format,
+    t_int64 length, t_int64 null_count, std::vector<const void*> buffers)
+{
+    std::memset(&c.m_schema, 0, sizeof(ArrowSchema));
+    std::memset(&c.m_array, 0, sizeof(ArrowArray));
+    c.m_buffers = buffers;
+    c.m_schema.format = format;
+    c.m_schema.name = name;
+    c.m_array.length = length;
+    c.m_array.null_count = null_count;
+    c.m_array.n_buffers = c.m_buffers.size();
+    c.m_array.buffers = c.m_buffers.data();
+}
+
+TEST(ARROW_LOADER, format_to_dtype)
+{
+    EXPECT_EQ(arrow_format_to_dtype("l"), DTYPE_INT64);
+    EXPECT_EQ(arrow_format_to_dtype("g"), DTYPE_FLOAT64);
+    EXPECT_EQ(arrow_format_to_dtype("u"), DTYPE_STR);
+    EXPECT_EQ(arrow_format_to_dtype("tdD"), DTYPE_DATE);
+    EXPECT_EQ(arrow_format_to_dtype("tsm:UTC"), DTYPE_TIME);
+    EXPECT_EQ(arrow_format_to_dtype("tsn:"), DTYPE_TIME);
+    EXPECT_EQ(arrow_format_to_dtype("U"), DTYPE_NONE);
+    EXPECT_EQ(arrow_format_to_dtype("+l"), DTYPE_NONE);
+}
+
+TEST(ARROW_LOADER, record_batch)
+{
+    std::vector<t_int64> i{7, 8, 9, 10};
+    t_uint8 ivalid = 0x0D;
+    std::vector<t_int32> days{0, 17532, -1, 1};
+    t_uint8 bools = 0x06;
+    std::vector<t_int64> ts{1000000000, 2000000000, -1, -1000};
+
+    // dictionary encoded strings with a null in slot 1
+    const char* dchars = "aaabb";
+    std::vector<t_int32> doffsets{0, 3, 5};
+    std::vector<t_int8> dindices{1, 99, 0, 1};
+    t_uint8 dvalid = 0x0D;
+
+    t_arrow_test_column ci, cd, cb, ct, cs, cdict;
+    arrow_test_init(ci, "i", "l", 4, 1, {&ivalid, i.data()});
+    arrow_test_init(cd, "d", "tdD", 4, 0, {nullptr, days.data()});
+    arrow_test_init(cb, "b", "b", 4, 0, {nullptr, &bools});
+    arrow_test_init(ct, "t", "tsu:", 4, 0, {nullptr, ts.data()});
+    arrow_test_init(cs, "s", "c", 4, 1, {&dvalid, dindices.data()});
+    arrow_test_init(cdict, "", "u", 2, 0, {nullptr, doffsets.data(), dchars});
+    cs.m_schema.dictionary = &cdict.m_schema;
+    cs.m_array.dictionary = &cdict.m_array;
+
+    std::vector<ArrowSchema*> schemas{
+        &ci.m_schema, &cd.m_schema, &cb.m_schema, &ct.m_schema, &cs.m_schema};
+    std::vector<ArrowArray*> arrays{
+        &ci.m_array, &cd.m_array, &cb.m_array, &ct.m_array, &cs.m_array};
+
+    t_arrow_test_column batch;
+    arrow_test_init(batch, "", "+s", 4, 0, {nullptr});
+    batch.m_schema.n_children = schemas.size();
+    batch.m_schema.children = schemas.data();
+    batch.m_array.n_children = arrays.size();
+    batch.m_array.children = arrays.data();
+
+    auto tbl = load_arrow_table(&batch.m_schema, &batch.m_array);
+    EXPECT_EQ(tbl->size(), 4);
+
+    auto icol = tbl->get_const_column("i");
+    EXPECT_EQ(icol->get_scalar(0), 7_ts);
+    EXPECT_FALSE(icol->is_valid(1));
+    EXPECT_EQ(icol->get_scalar(3), 10_ts);
+
+    auto dcol = tbl->get_const_column("d");
+    EXPECT_EQ(dcol->get_scalar(0), mktscalar(t_date(1970, 0, 1)));
+    EXPECT_EQ(dcol->get_scalar(1), mktscalar(t_date(2018, 0, 1)));
+    EXPECT_EQ(dcol->get_scalar(2), mktscalar(t_date(1969, 11, 31)));
+
+    auto bcol = tbl->get_const_column("b");
+    EXPECT_EQ(bcol->get_scalar(0), s_false);
+    EXPECT_EQ(bcol->get_scalar(1), s_true);
+
+    auto tcol = tbl->get_const_column("t");
+    EXPECT_EQ(tcol->get_scalar(1), mktscalar(t_time(2000000)));
+    // pre epoch microseconds round down to the previous millisecond
+    EXPECT_EQ(tcol->get_scalar(2), mktscalar(t_time(-1)));
+    EXPECT_EQ(tcol->get_scalar(3), mktscalar(t_time(-1)));
+
+    auto scol = tbl->get_const_column("s");
+    EXPECT_EQ(scol->get_scalar(0), "bb"_ts);
+    EXPECT_FALSE(scol->is_valid(1));
+    EXPECT_EQ(scol->get_scalar(2), "aaa"_ts);
+    EXPECT_EQ(scol->get_scalar(3), "bb"_ts);
+}
+
+TEST(ARROW_LOADER, unsupported_format)
+{
+    std::vector<t_int64> i{7, 8};
+    std::vector<t_int32> offsets{0, 1, 2};
+    const char* chars = "ab";
+
+    t_arrow_test_column ci, cs;
+    arrow_test_init(ci, "i", "l", 2, 0, {nullptr, i.data()});
+    // large utf8, not supported
+    arrow_test_init(cs, "s", "U", 2, 0, {nullptr, offsets.data(), chars});
+
+    std::vector<ArrowSchema*> schemas{&ci.m_schema, &cs.m_schema};
+    std::vector<ArrowArray*> arrays{&ci.m_array, &cs.m_array};
+
+    t_arrow_test_column batch;
+    arrow_test_init(batch, "", "+s", 2, 0, {nullptr});
+    batch.m_schema.n_children = schemas.size();
+    batch.m_schema.children = schemas.data();
+    batch.m_array.n_children = arrays.size();
+    batch.m_array.children = arrays.data();
+
+    EXPECT_THROW(load_arrow_table(&batch.m_schema, &batch.m_array),
+        std::invalid_argument);
+
+    // Dictionaries are only supported for strings
+    cs.m_schema.format = "c";
+    cs.m_schema.dictionary = &ci.m_schema;
+    EXPECT_THROW(load_arrow_table(&batch.m_schema, &batch.m_array),
+        std::invalid_argument);
+
+    // with integer indices
+    t_arrow_test_column cdict;
+    arrow_test_init(cdict, "", "u", 2, 0, {nullptr, offsets.data(), chars});
+    cs.m_schema.format = "g";
+    cs.m_schema.dictionary = &cdict.m_schema;
+    cs.m_array.dictionary = &cdict.m_array;
+    EXPECT_THROW(load_arrow_table(&batch.m_schema, &batch.m_array),
+        std::invalid_argument);
+
+    cs.m_schema.format = "s";
+    EXPECT_EQ(load_arrow_table(&batch.m_schema, &batch.m_array)->size(), 2);
+
+    // schema and array must be matching struct arrays
+    batch.m_array.n_children = 1;
+    EXPECT_THROW(load_arrow_table(&batch.m_schema, &batch.m_array),
+        std::invalid_argument);
+
+    batch.m_array.n_children = arrays.size();
+    batch.m_schema.format = "+l";
+    EXPECT_THROW(load_arrow_table(&batch.m_schema, &batch.m_array),
+        std::invalid_argument);
+}
+
+TEST(GNODE_TEST, parallel_process_wide_table)
+{
+    // Enough columns of every storage width that the per column loop in
+    // _process is split across workers
+    std::vector<t_str> names{"psp_op", "psp_pkey"};
+    std::vector<t_dtype> types{DTYPE_UINT8, DTYPE_INT64};
+    for (t_uindex idx = 0; idx < 60; ++idx)
+    {
+        t_dtype dtype = idx % 3 == 0
+            ? DTYPE_INT64
+            : (idx % 3 == 1 ? DTYPE_FLOAT64 : DTYPE_STR);
+        names.push_back("c" + std::to_string(idx));
+        types.push_back(dtype);
+    }
+    t_schema sch(names, types);
+
+    auto make_rows = [&types](t_int64 base) {
+        std::vector<t_tscalvec> rows;
+        for (t_int64 ridx = 0; ridx < 20; ++ridx)
+        {
+            t_tscalvec row{iop, mktscalar<t_int64>(ridx % 10)};
+            for (t_uindex cidx = 2; cidx < types.size(); ++cidx)
+            {
+                switch (types[cidx])
+                {
+                    case DTYPE_INT64:
+                        row.push_back(mktscalar<t_int64>(base + ridx));
+                        break;
+                    case DTYPE_FLOAT64:
+                        row.push_back(mktscalar<t_float64>(base * 0.5));
+                        break;
+                    default:
+                        row.push_back(base % 2 ? "odd"_ts : "even"_ts);
+                }
+            }
+            rows.push_back(row);
+        }
+        return rows;
+    };
+
+    auto run = [&]() {
+        t_gnode_options options;
+        options.m_gnode_type = GNODE_TYPE_PKEYED;
+        options.m_port_schema = sch;
+        auto gn = t_gnode::build(options);
+        for (t_int64 base = 0; base < 4; ++base)
+        {
+            t_table tbl(sch, make_rows(base));
+            gn->_send_and_process(tbl);
+        }
+        return gn->get_sorted_pkeyed_table()->get_scalvec();
+    };
+
+    set_num_threads(1);
+    auto serial = run();
+    set_num_threads(4);
+    auto parallel = run();
+    set_num_threads(0);
+
+    // 10 distinct pkeys, every column but psp_op
+    EXPECT_EQ(serial.size(), 10 * (names.size() - 1));
+    EXPECT_EQ(serial, parallel);
+}
+
+TEST(CTX2, parallel_tree_notify)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "a", "b", "c", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_STR, DTYPE_STR,
+            DTYPE_INT64}};
+    const char* strs[] = {"p", "q", "r", "s"};
+
+    // Two row pivots, so a tree per row pivot depth next to the column tree
+    auto run = [&]() {
+        t_gnode_options options;
+        options.m_gnode_type = GNODE_TYPE_PKEYED;
+        options.m_port_schema = sch;
+        auto gn = t_gnode::build(options);
+        auto ctx = t_ctx2::build(sch,
+            t_config{{"a", "b"}, {"c"}, {{"sum_x", AGGTYPE_SUM, "x"}},
+                TOTALS_BEFORE, FILTER_OP_AND, {}});
+        gn->register_context("ctx2", ctx);
+        ctx->set_depth(HEADER_ROW, 2);
+        ctx->set_depth(HEADER_COLUMN, 1);
+
+        std::mt19937 gen(24);
+        std::uniform_int_distribution<t_int64> dist(0, 39);
+        std::vector<std::vector<t_str>> cells;
+        std::vector<t_uindex> ntree_spans;
+        for (t_uindex step = 0; step < 5; ++step)
+        {
+            std::vector<t_tscalvec> rows;
+            for (t_uindex ridx = 0; ridx < 30; ++ridx)
+            {
+                t_int64 v = dist(gen);
+                rows.push_back({iop, mktscalar<t_int64>(dist(gen)),
+                    mktscalar<const char*>(strs[v % 4]),
+                    mktscalar<const char*>(strs[(v / 4) % 4]),
+                    mktscalar<const char*>(strs[(v / 16) % 4]),
+                    mktscalar<t_int64>(v)});
+            }
+
+            clear_trace();
+            set_trace_enabled(true);
+            gn->_send_and_process(t_table(sch, rows));
+            set_trace_enabled(false);
+
+            t_uindex nspans = 0;
+            for (const auto& event : get_trace_events())
+            {
+                nspans += event.m_span == TRACE_CTX2_NOTIFY_TREE;
+            }
+            ntree_spans.push_back(nspans);
+            // Strings point into the context, which doesn't outlive run
+            std::vector<t_str> step_cells;
+            for (const auto& cell : ctx->get_data(
+                     0, ctx->get_row_count(), 0, ctx->get_column_count()))
+            {
+                step_cells.push_back(cell.to_string());
+            }
+            cells.push_back(step_cells);
+        }
+
+        EXPECT_EQ(ntree_spans, std::vector<t_uindex>(5, 3));
+        return cells;
+    };
+
+    set_num_threads(1);
+    auto serial = run();
+    set_num_threads(4);
+    auto parallel = run();
+    set_num_threads(0);
+    clear_trace();
+
+    EXPECT_GT(serial.back().size(), 16);
+    EXPECT_EQ(serial, parallel);
+}
+
+TEST(GNODE_TEST, num_threads)
+{
+    set_num_threads(1);
+    EXPECT_EQ(get_num_threads(), 1);
+    set_num_threads(0);
+    EXPECT_GE(get_num_threads(), 1);
+}
+
+TEST(POOL, processes_gnodes_independently)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64}};
+
+    t_pool pool;
+    std::mutex mtx;
+    std::vector<t_uindex> processed;
+    pool.set_gnode_processed_callback([&mtx, &processed](t_uindex id) {
+        std::lock_guard<std::mutex> lg(mtx);
+        processed.push_back(id);
+    });
+
+    std::vector<t_gnode_sptr> gnodes;
+    std::vector<t_ctx1_sptr> ctxs;
+    for (t_uindex idx = 0; idx < 4; ++idx)
+    {
+        t_gnode_options options;
+        options.m_gnode_type = GNODE_TYPE_PKEYED;
+        options.m_port_schema = sch;
+        auto gn = t_gnode::build(options);
+        auto ctx = t_ctx1::build(sch, t_config({"x"}, {AGGTYPE_SUM, "x"}));
+        gn->register_context("ctx1", ctx);
+        EXPECT_EQ(pool.register_gnode(gn.get()), idx);
+        gnodes.push_back(gn);
+        ctxs.push_back(ctx);
+    }
+
+    set_num_threads(4);
+    for (t_uindex idx = 0; idx < 4; ++idx)
+    {
+        std::vector<t_tscalvec> rows;
+        for (t_uindex ridx = 0; ridx <= idx; ++ridx)
+        {
+            rows.push_back({iop, mktscalar<t_int64>(ridx),
+                mktscalar<t_int64>(ridx)});
+        }
+        pool.send(idx, 0, t_table(sch, rows));
+    }
+    EXPECT_TRUE(pool.get_data_remaining());
+    pool._process_helper();
+    set_num_threads(0);
+
+    EXPECT_FALSE(pool.get_data_remaining());
+    std::sort(processed.begin(), processed.end());
+    EXPECT_EQ(processed, (std::vector<t_uindex>{0, 1, 2, 3}));
+    EXPECT_EQ(pool.get_gnodes_last_updated(),
+        (std::vector<t_uindex>{0, 1, 2, 3}));
+
+    for (t_uindex idx = 0; idx < 4; ++idx)
+    {
+        EXPECT_EQ(gnodes[idx]->get_table()->size(), idx + 1);
+        EXPECT_EQ(ctxs[idx]->get_row_count(), idx + 2);
+    }
+}
+
+TEST(PORT, double_buffered_send)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64}};
+    auto make_rows = [&sch](t_int64 begin, t_int64 end) {
+        std::vector<t_tscalvec> rows;
+        for (t_int64 pkey = begin; pkey < end; ++pkey)
+        {
+            rows.push_back(
+                {iop, mktscalar<t_int64>(pkey), mktscalar<t_int64>(pkey)});
+        }
+        return std::make_shared<t_table>(sch, rows);
+    };
+
+    t_port port(sch);
+    port.init();
+
+    port.send(*make_rows(0, 100));
+    EXPECT_EQ(port.get_pending_size(), 100);
+    EXPECT_EQ(port.get_table()->size(), 0);
+    EXPECT_TRUE(port.swap());
+    EXPECT_EQ(port.get_table()->size(), 100);
+    EXPECT_EQ(port.get_pending_size(), 0);
+
+    // Sent while the first batch is processed
+    port.send(*make_rows(100, 160));
+    auto first = port.get_table();
+    t_uindex capacity = first->get_capacity();
+    port.release_or_clear();
+    EXPECT_EQ(port.get_table(), first);
+    EXPECT_EQ(first->size(), 0);
+    EXPECT_EQ(first->get_capacity(), capacity);
+
+    EXPECT_TRUE(port.swap());
+    auto second = port.get_table();
+    EXPECT_NE(second, first);
+    EXPECT_EQ(second->size(), 60);
+    EXPECT_EQ(*second->get_const_column("x")->get_nth<t_int64>(0), 100);
+
+    // The tables alternate, so neither is reallocated
+    port.send(*make_rows(160, 240));
+    port.release_or_clear();
+    EXPECT_TRUE(port.swap());
+    EXPECT_EQ(port.get_table(), first);
+    EXPECT_EQ(first->size(), 80);
+    port.release_or_clear();
+    EXPECT_FALSE(port.swap());
+
+    // An owned table is taken as is when nothing is pending...
+    auto owned = make_rows(240, 250);
+    port.send(owned);
+    EXPECT_TRUE(port.swap());
+    EXPECT_EQ(port.get_table(), owned);
+
+    // ... and appended otherwise, also when the table being processed
+    // still has rows
+    port.send(*make_rows(250, 252));
+    port.send(make_rows(252, 255));
+    EXPECT_EQ(port.get_pending_size(), 5);
+    EXPECT_TRUE(port.swap());
+    EXPECT_EQ(port.get_table(), owned);
+    EXPECT_EQ(owned->size(), 15);
+    EXPECT_EQ(*owned->get_const_column("x")->get_nth<t_int64>(14), 254);
+
+    // A batch far smaller than the table drops it
+    port.release_or_clear();
+    port.send(*make_rows(0, 1000));
+    EXPECT_TRUE(port.swap());
+    port.release_or_clear();
+    port.send(*make_rows(0, 1));
+    port.swap();
+    port.release_or_clear();
+    port.send(*make_rows(0, 1));
+    port.swap();
+    port.release_or_clear();
+    EXPECT_LT(port.get_table()->get_capacity(), 1000);
+}
+
+TEST(POOL, takes_sent_tables)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64}};
+
+    t_pool pool;
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+    auto ctx = t_ctx0::build(sch, t_config{{"x"}});
+    gn->register_context("ctx0", ctx);
+    pool.register_gnode(gn.get());
+
+    for (t_int64 step = 0; step < 3; ++step)
+    {
+        std::vector<t_tscalvec> rows;
+        for (t_int64 pkey = 0; pkey < 4; ++pkey)
+        {
+            rows.push_back({iop, mktscalar<t_int64>(pkey),
+                mktscalar<t_int64>(pkey * 10 + step)});
+        }
+        pool.send(0, 0, std::make_shared<t_table>(sch, rows));
+        pool.send(0, 0,
+            t_table(sch,
+                {{iop, mktscalar<t_int64>(4), mktscalar<t_int64>(step)}}));
+        EXPECT_TRUE(pool.get_data_remaining());
+        pool._process_helper();
+        EXPECT_FALSE(pool.get_data_remaining());
+
+        EXPECT_EQ(gn->get_table()->size(), 5);
+        EXPECT_EQ(ctx->get_row_count(), 5);
+        auto x = gn->get_table()->get_const_column("x");
+        t_tscalvec expected{mktscalar<t_int64>(step),
+            mktscalar<t_int64>(10 + step), mktscalar<t_int64>(20 + step),
+            mktscalar<t_int64>(30 + step), mktscalar<t_int64>(step)};
+        t_tscalvec values;
+        for (t_uindex idx = 0; idx < 5; ++idx)
+        {
+            values.push_back(x->get_scalar(idx));
+        }
+        EXPECT_EQ(values, expected);
+    }
+}
+
+TEST(GNODE_TEST, parallel_sort_threshold)
+{
+    set_parallel_sort_threshold(10);
+    EXPECT_EQ(get_parallel_sort_threshold(), 10);
+    set_parallel_sort_threshold(0);
+    EXPECT_GT(get_parallel_sort_threshold(), 10);
+
+    t_schema sch{{"psp_op", "psp_pkey", "x", "s"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_FLOAT64, DTYPE_STR}};
+    std::vector<t_tscalvec> rows;
+    for (t_int64 pkey = 0; pkey < 5000; ++pkey)
+    {
+        rows.push_back({iop, mktscalar<t_int64>(pkey),
+            mktscalar<t_float64>(t_float64((pkey * 7919) % 97)),
+            (pkey % 3) ? "a"_ts : "b"_ts});
+    }
+    t_sortsvec sortby{{1, SORTTYPE_ASCENDING}, {0, SORTTYPE_DESCENDING}};
+
+    auto run = [&]() {
+        t_gnode_options options;
+        options.m_gnode_type = GNODE_TYPE_PKEYED;
+        options.m_port_schema = sch;
+        auto gn = t_gnode::build(options);
+        auto ctx = t_ctx0::build(sch, t_config{{"x", "s"}});
+        gn->register_context("ctx0", ctx);
+        gn->_send_and_process(t_table(sch, rows));
+        ctx->sort_by(sortby);
+
+        std::vector<t_uidxpair> cells;
+        for (t_index ridx = 0; ridx < ctx->get_row_count(); ++ridx)
+        {
+            cells.push_back(t_uidxpair(ridx, 0));
+        }
+        return ctx->get_pkeys(cells);
+    };
+
+    set_num_threads(1);
+    auto serial = run();
+    set_num_threads(4);
+    set_parallel_sort_threshold(1);
+    auto parallel = run();
+    set_parallel_sort_threshold(0);
+    set_num_threads(0);
+
+    EXPECT_EQ(serial.size(), 5000);
+    EXPECT_EQ(serial, parallel);
+}
+
+TEST(GNODE_TEST, shared_filter_masks)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x", "s", "y"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_FLOAT64, DTYPE_STR, DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_fterm x_gt("x", FILTER_OP_GT, mktscalar<t_float64>(3), {});
+    t_fterm s_in("s", FILTER_OP_IN, mknone(), {"a"_ts, "b"_ts});
+    t_ftermvec fterms{x_gt, s_in};
+    t_aggspecvec aggs{t_aggspec(AGGTYPE_SUM, "y")};
+
+    // a and b share the masks of their filter, d has its own
+    auto ctx_a = t_ctx0::build(sch, t_config({"x", "s", "y"}, FILTER_OP_AND,
+                                        fterms));
+    auto ctx_b = t_ctx0::build(sch,
+        t_config({"x", "s", "y"}, FILTER_OP_AND, {s_in, x_gt, s_in}));
+    auto ctx_d = t_ctx0::build(sch, t_config({"x", "s", "y"}, FILTER_OP_AND,
+                                        t_ftermvec{x_gt}));
+    auto ctx_p = t_ctx1::build(sch, t_config({"s"}, aggs, FILTER_OP_AND,
+                                        fterms));
+    gn->register_context("a", ctx_a);
+    gn->register_context("b", ctx_b);
+    gn->register_context("d", ctx_d);
+    gn->register_context("p", ctx_p);
+
+    auto get_pkeys = [](t_ctx0_sptr c) {
+        std::vector<t_uidxpair> cells;
+        for (t_index ridx = 0; ridx < c->get_row_count(); ++ridx)
+        {
+            cells.push_back(t_uidxpair(ridx, 0));
+        }
+        auto pkeys = c->get_pkeys(cells);
+        std::sort(pkeys.begin(), pkeys.end());
+        return pkeys;
+    };
+
+    auto get_totals = [](t_ctx1_sptr c) {
+        return c->get_data(0, c->get_row_count(), 0, 2);
+    };
+
+    std::mt19937 gen(23);
+    std::uniform_int_distribution<t_int64> pkey_dist(0, 49);
+    std::uniform_int_distribution<t_int64> val_dist(0, 9);
+    const char* strs[] = {"a", "b", "c"};
+
+    for (t_uindex step = 0; step < 10; ++step)
+    {
+        std::vector<t_tscalvec> rows;
+        for (t_uindex ridx = 0; ridx < 20; ++ridx)
+        {
+            rows.push_back({iop, mktscalar<t_int64>(pkey_dist(gen)),
+                mktscalar<t_float64>(t_float64(val_dist(gen))),
+                mktscalar<const char*>(strs[val_dist(gen) % 3]),
+                mktscalar<t_int64>(val_dist(gen))});
+        }
+        gn->_send_and_process(t_table(sch, rows));
+
+        // The first step filters the loaded table once for a, b and p and
+        // once for d. Later ones filter the changed rows of the current
+        // table once for a and b and once for d, and the previous and
+        // current tables for p
+        EXPECT_EQ(gn->get_filter_cache()->get_num_masks(), step ? 4 : 2);
+
+        auto fresh = t_ctx0::build(
+            sch, t_config({"x", "s", "y"}, FILTER_OP_AND, fterms));
+        gn->register_context("fresh", fresh);
+        auto fresh_d = t_ctx0::build(sch,
+            t_config({"x", "s", "y"}, FILTER_OP_AND, t_ftermvec{x_gt}));
+        gn->register_context("fresh_d", fresh_d);
+        auto fresh_p = t_ctx1::build(
+            sch, t_config({"s"}, aggs, FILTER_OP_AND, fterms));
+        gn->register_context("fresh_p", fresh_p);
+
+        EXPECT_EQ(get_pkeys(ctx_a), get_pkeys(fresh));
+        EXPECT_EQ(get_pkeys(ctx_b), get_pkeys(fresh));
+        EXPECT_EQ(get_pkeys(ctx_d), get_pkeys(fresh_d));
+        EXPECT_EQ(get_totals(ctx_p), get_totals(fresh_p));
+
+        gn->_unregister_context("fresh");
+        gn->_unregister_context("fresh_d");
+        gn->_unregister_context("fresh_p");
+    }
+}
+
+TEST(GNODE_TEST, shared_strand_tables)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "a", "b", "x", "y"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_STR, DTYPE_STR, DTYPE_FLOAT64,
+            DTYPE_INT64}};
+    t_gnode_options options;
+    options.m_gnode_type = GNODE_TYPE_PKEYED;
+    options.m_port_schema = sch;
+    auto gn = t_gnode::build(options);
+
+    t_fterm x_gt("x", FILTER_OP_GT, mktscalar<t_float64>(3), {});
+    t_fterm a_in("a", FILTER_OP_IN, mknone(), {"p"_ts, "q"_ts});
+    t_aggspecvec sum_y{t_aggspec(AGGTYPE_SUM, "y")};
+
+    // Trees grouping by a share their strands with the same filter, count
+    // and sum read the same column. The column tree of q groups by b like
+    // b1, its row tree by a and b.
+    std::vector<std::pair<t_str, t_config>> configs{
+        {"a1", t_config({"a"}, sum_y)},
+        {"a2", t_config({"a"}, {t_aggspec(AGGTYPE_COUNT, "y")})},
+        {"b1", t_config({"b"}, sum_y)},
+        {"f1", t_config({"a"}, sum_y, FILTER_OP_AND, {x_gt, a_in})},
+        {"f2", t_config({"a"}, sum_y, FILTER_OP_AND, {a_in, x_gt, a_in})}};
+    t_config q_config{
+        {"a"}, {"b"}, sum_y, TOTALS_BEFORE, FILTER_OP_AND, {}};
+
+    std::vector<t_ctx1_sptr> ctxs;
+    for (const auto& kv : configs)
+    {
+        auto ctx = t_ctx1::build(sch, kv.second);
+        gn->register_context(kv.first, ctx);
+        ctxs.push_back(ctx);
+    }
+    auto q = t_ctx2::build(sch, q_config);
+    gn->register_context("q", q);
+    q->set_depth(HEADER_ROW, 1);
+    q->set_depth(HEADER_COLUMN, 1);
+
+    auto get_cells = [](const t_tscalvec& data) {
+        std::vector<t_str> rv;
+        for (const auto& cell : data)
+        {
+            rv.push_back(cell.to_string());
+        }
+        return rv;
+    };
+
+    auto get_ctx1_cells = [&get_cells](t_ctx1_sptr c) {
+        c->set_depth(1);
+        return get_cells(c->get_data(
+            0, c->get_row_count(), 0, c->get_column_count()));
+    };
+
+    std::mt19937 gen(25);
+    std::uniform_int_distribution<t_int64> pkey_dist(0, 39);
+    std::uniform_int_distribution<t_int64> val_dist(0, 9);
+    const char* strs[] = {"p", "q", "r"};
+
+    for (t_uindex step = 0; step < 6; ++step)
+    {
+        std::vector<t_tscalvec> rows;
+        for (t_uindex ridx = 0; ridx < 20; ++ridx)
+        {
+            rows.push_back({step % 3 == 2 ? dop : iop,
+                mktscalar<t_int64>(pkey_dist(gen)),
+                mktscalar<const char*>(strs[val_dist(gen) % 3]),
+                mktscalar<const char*>(strs[val_dist(gen) % 3]),
+                mktscalar<t_float64>(t_float64(val_dist(gen))),
+                mktscalar<t_int64>(val_dist(gen))});
+        }
+        gn->_send_and_process(t_table(sch, rows));
+
+        // a, filtered a, b and a then b
+        EXPECT_EQ(gn->get_strand_cache()->get_num_entries(), 4);
+
+        for (t_uindex idx = 0; idx < configs.size(); ++idx)
+        {
+            auto fresh = t_ctx1::build(sch, configs[idx].second);
+            gn->register_context("fresh", fresh);
+            EXPECT_EQ(get_ctx1_cells(ctxs[idx]), get_ctx1_cells(fresh))
+                << configs[idx].first;
+            gn->_unregister_context("fresh");
+        }
+
+        auto fresh_q = t_ctx2::build(sch, q_config);
+        gn->register_context("fresh_q", fresh_q);
+        fresh_q->set_depth(HEADER_ROW, 1);
+        fresh_q->set_depth(HEADER_COLUMN, 1);
+        EXPECT_EQ(get_cells(q->get_data(
+                      0, q->get_row_count(), 0, q->get_column_count())),
+            get_cells(fresh_q->get_data(0, fresh_q->get_row_count(), 0,
+                fresh_q->get_column_count())));
+        gn->_unregister_context("fresh_q");
+    }
+}
+
+TEST(PKEY_INDEX, insert_erase_grow)
+{
+    t_pkey_index index;
+    index.init(DTYPE_INT64);
+
+    for (t_int64 key = 0; key < 1000; ++key)
+    {
+        index.insert(mktscalar(key * 7), key);
+    }
+    EXPECT_EQ(index.size(), 1000);
+
+    for (t_int64 key = 0; key < 1000; key += 2)
+    {
+        t_uindex idx;
+        EXPECT_TRUE(index.erase(mktscalar(key * 7), idx));
+        EXPECT_EQ(idx, key);
+    }
+    EXPECT_EQ(index.size(), 500);
+
+    t_uindex idx;
+    EXPECT_FALSE(index.erase(mktscalar<t_int64>(0), idx));
+
+    for (t_int64 key = 0; key < 1000; ++key)
+    {
+        auto lk = index.lookup(mktscalar(key * 7));
+        EXPECT_EQ(lk.m_exists, key % 2 == 1);
+        if (lk.m_exists)
+            EXPECT_EQ(lk.m_idx, key);
+    }
+
+    // reinsertion reuses tombstones and overwrites existing rows
+    index.insert(mktscalar<t_int64>(0), 42);
+    index.insert(mktscalar<t_int64>(7), 43);
+    EXPECT_EQ(index.size(), 501);
+    EXPECT_EQ(index.lookup(mktscalar<t_int64>(0)).m_idx, 42);
+    EXPECT_EQ(index.lookup(mktscalar<t_int64>(7)).m_idx, 43);
+
+    // keys of another dtype are never found
+    EXPECT_FALSE(index.lookup(mktscalar<t_int32>(7)).m_exists);
+
+    t_uindex count = 0;
+    index.for_each([&count](t_uindex) { ++count; });
+    EXPECT_EQ(count, 501);
+
+    index.clear();
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_FALSE(index.lookup(mktscalar<t_int64>(7)).m_exists);
+}
+
+TEST(PKEY_INDEX, null_and_float_keys)
+{
+    t_pkey_index index;
+    index.init(DTYPE_FLOAT64);
+
+    index.insert(mktscalar(0.0), 1);
+    index.insert(mktscalar(1.5), 2);
+    EXPECT_FALSE(index.lookup(mknone()).m_exists);
+    EXPECT_FALSE(index.lookup(mktscalar(-0.0)).m_exists);
+
+    index.insert(mknone(), 3);
+    index.insert(mktscalar(-0.0), 4);
+    EXPECT_EQ(index.size(), 4);
+    EXPECT_EQ(index.lookup(mknone()).m_idx, 3);
+    EXPECT_EQ(index.lookup(mktscalar(0.0)).m_idx, 1);
+    EXPECT_EQ(index.lookup(mktscalar(-0.0)).m_idx, 4);
+    EXPECT_EQ(index.lookup(mktscalar(1.5)).m_idx, 2);
+
+    t_uindex idx;
+    EXPECT_TRUE(index.erase(mknone(), idx));
+    EXPECT_EQ(idx, 3);
+    EXPECT_FALSE(index.lookup(mknone()).m_exists);
+    EXPECT_EQ(index.size(), 3);
+}
+
+TEST(PKEY_INDEX, null_keys)
+{
+    t_pkey_index index;
+    index.init(DTYPE_INT64);
+
+    // keys compare as scalars, nulls of each dtype and none are distinct
+    index.insert(mknull(DTYPE_INT64), 1);
+    index.insert(mknull(DTYPE_FLOAT64), 2);
+    index.insert(mknone(), 3);
+    index.insert(mktscalar<t_int64>(0), 4);
+    EXPECT_EQ(index.size(), 4);
+
+    EXPECT_EQ(index.lookup(mknull(DTYPE_INT64)).m_idx, 1);
+    EXPECT_EQ(index.lookup(mknull(DTYPE_FLOAT64)).m_idx, 2);
+    EXPECT_EQ(index.lookup(mknone()).m_idx, 3);
+    EXPECT_EQ(index.lookup(mktscalar<t_int64>(0)).m_idx, 4);
+    EXPECT_FALSE(index.lookup(mknull(DTYPE_STR)).m_exists);
+    EXPECT_FALSE(index.lookup(mkclear(DTYPE_INT64)).m_exists);
+
+    index.insert(mknull(DTYPE_INT64), 5);
+    EXPECT_EQ(index.size(), 4);
+    EXPECT_EQ(index.lookup(mknull(DTYPE_INT64)).m_idx, 5);
+
+    t_uindex idx;
+    EXPECT_TRUE(index.erase(mknull(DTYPE_FLOAT64), idx));
+    EXPECT_EQ(idx, 2);
+    EXPECT_FALSE(index.erase(mknull(DTYPE_FLOAT64), idx));
+    EXPECT_EQ(index.lookup(mknull(DTYPE_INT64)).m_idx, 5);
+    EXPECT_EQ(index.lookup(mknone()).m_idx, 3);
+
+    std::vector<t_uindex> rows;
+    index.for_each([&rows](t_uindex idx) { rows.push_back(idx); });
+    std::sort(rows.begin(), rows.end());
+    EXPECT_EQ(rows, std::vector<t_uindex>({3, 4, 5}));
+}
+
+TEST(PKEY_INDEX, mismatched_dtype)
+{
+    t_pkey_index index;
+    index.init(DTYPE_INT64);
+
+    index.insert(mktscalar<t_int64>(7), 1);
+    index.insert(mktscalar<t_int32>(7), 2);
+    index.insert(mktscalar(7.0), 3);
+
+    // string keys of another dtype are copied, not borrowed
+    char buf[] = "a string too long to be stored inplace 7";
+    index.insert(mktscalar<const char*>(buf), 4);
+    buf[0] = 'b';
+
+    EXPECT_EQ(index.size(), 4);
+    EXPECT_EQ(index.lookup(mktscalar<t_int64>(7)).m_idx, 1);
+    EXPECT_EQ(index.lookup(mktscalar<t_int32>(7)).m_idx, 2);
+    EXPECT_EQ(index.lookup(mktscalar(7.0)).m_idx, 3);
+    EXPECT_EQ(
+        index.lookup("a string too long to be stored inplace 7"_ts).m_idx, 4);
+    EXPECT_FALSE(
+        index.lookup("b string too long to be stored inplace 7"_ts).m_exists);
+    EXPECT_FALSE(index.lookup(mktscalar<t_int32>(8)).m_exists);
+
+    t_uindex idx;
+    EXPECT_TRUE(index.erase(mktscalar<t_int32>(7), idx));
+    EXPECT_EQ(idx, 2);
+    EXPECT_FALSE(index.lookup(mktscalar<t_int32>(7)).m_exists);
+    EXPECT_EQ(index.lookup(mktscalar<t_int64>(7)).m_idx, 1);
+    EXPECT_EQ(index.size(), 3);
+}
+
+TEST(PKEY_INDEX, not_supported)
+{
+    // keys of a dtype the table can't hold are all kept aside
+    t_pkey_index index;
+    index.init(DTYPE_F64PAIR);
+
+    for (t_int64 key = 0; key < 100; ++key)
+    {
+        index.insert(mktscalar(key), key);
+    }
+    EXPECT_EQ(index.size(), 100);
+    EXPECT_EQ(index.lookup(mktscalar<t_int64>(42)).m_idx, 42);
+    EXPECT_FALSE(index.lookup(mktscalar<t_int64>(100)).m_exists);
+
+    t_uindex idx;
+    EXPECT_TRUE(index.erase(mktscalar<t_int64>(42), idx));
+    EXPECT_EQ(idx, 42);
+    EXPECT_FALSE(index.lookup(mktscalar<t_int64>(42)).m_exists);
+
+    index.clear();
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_FALSE(index.lookup(mktscalar<t_int64>(7)).m_exists);
+}
+
+TEST(PKEY_INDEX, str_keys_share_vocab)
+{
+    t_vocab vocab;
+    vocab.init(false);
+    t_uindex nstrings = vocab.get_vlenidx();
+
+    t_pkey_index index;
+    index.init(DTYPE_STR, &vocab);
+    index.insert("a"_ts, 0);
+    index.insert("b"_ts, 1);
+    index.insert("a"_ts, 2);
+
+    EXPECT_EQ(index.size(), 2);
+    EXPECT_EQ(vocab.get_vlenidx(), nstrings + 2);
+    EXPECT_EQ(index.lookup("a"_ts).m_idx, 2);
+    EXPECT_EQ(index.lookup("b"_ts).m_idx, 1);
+    EXPECT_FALSE(index.lookup("c"_ts).m_exists);
+}
+
+template <typename F>
+void
+check_lookup_batch(const t_schema& sch, const std::vector<t_tscalvec>& data,
+    const t_tscalvec& probes, F check)
+{
+    t_gstate state(sch.drop({"psp_op", "psp_pkey"}), sch);
+    state.init();
+    t_table tbl(sch, data);
+    state.update_history(&tbl);
+    state.update_history(&tbl);
+
+    t_schema psch{{"psp_pkey"}, {sch.get_dtype("psp_pkey")}};
+    std::vector<t_tscalvec> prows;
+    for (const auto& p : probes)
+        prows.push_back({p});
+    t_table ptbl(psch, prows);
+
+    std::vector<t_rlookup> out;
+    state.lookup_batch(*ptbl.get_const_column("psp_pkey"), out);
+    ASSERT_EQ(out.size(), probes.size());
+
+    for (t_uindex idx = 0; idx < probes.size(); ++idx)
+    {
+        auto expected = state.lookup(probes[idx]);
+        EXPECT_EQ(out[idx].m_exists, expected.m_exists);
+        EXPECT_EQ(out[idx].m_idx, expected.m_idx);
+        check(probes[idx], out[idx]);
+    }
+}
+
+TEST(GSTATE, lookup_batch_int64)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64}};
+    std::vector<t_tscalvec> data;
+    for (t_int64 key = 0; key < 100; ++key)
+    {
+        data.push_back({key % 10 == 0 ? dop : iop, mktscalar(key), 1_ts});
+    }
+
+    t_tscalvec probes;
+    for (t_int64 key = -5; key < 105; ++key)
+        probes.push_back(mktscalar(key));
+
+    check_lookup_batch(sch, data, probes,
+        [](const t_tscalar& pkey, const t_rlookup& lk) {
+            t_int64 key = pkey.to_int64();
+            EXPECT_EQ(lk.m_exists, key >= 0 && key < 100 && key % 10 != 0);
+        });
+}
+
+TEST(GSTATE, lookup_batch_str)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x"},
+        {DTYPE_UINT8, DTYPE_STR, DTYPE_INT64}};
+    std::vector<t_tscalvec> data{{iop, "a"_ts, 1_ts},
+        {iop, "a rather long key"_ts, 2_ts}, {dop, "c"_ts, 3_ts},
+        {iop, "d"_ts, 4_ts}};
+
+    t_tscalvec probes{"d"_ts, "a"_ts, "b"_ts, "c"_ts, "a"_ts,
+        "a rather long key"_ts, mknone()};
+
+    check_lookup_batch(sch, data, probes,
+        [](const t_tscalar& pkey, const t_rlookup& lk) {
+            t_str key = pkey.is_valid() ? pkey.to_string() : "";
+            EXPECT_EQ(lk.m_exists,
+                key == "a" || key == "d" || key == "a rather long key");
+        });
+}
+
+TEST(GSTATE, lookup_batch_null)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_INT64}};
+    std::vector<t_tscalvec> data{{iop, 1_ts, 1_ts},
+        {iop, mknull(DTYPE_INT64), 2_ts}, {iop, 3_ts, 3_ts}};
+
+    t_tscalvec probes{mknull(DTYPE_INT64), 1_ts, 2_ts, mknull(DTYPE_INT64)};
+
+    check_lookup_batch(sch, data, probes,
+        [](const t_tscalar& pkey, const t_rlookup& lk) {
+            EXPECT_EQ(lk.m_exists, !pkey.is_valid() || pkey.to_int64() == 1);
+        });
+}
+
+TEST(GSTATE, update_history_applies_batches)
+{
+    t_schema sch{{"psp_op", "psp_pkey", "x", "s", "b", "d"},
+        {DTYPE_UINT8, DTYPE_INT64, DTYPE_FLOAT64, DTYPE_STR, DTYPE_BOOL,
+            DTYPE_INT32}};
+    t_gstate state(sch.drop({"psp_op", "psp_pkey"}), sch);
+    state.init();
+
+    std::vector<t_str> cols{"x", "s", "b", "d"};
+    std::map<t_int64, std::vector<t_tscalar>> expected;
+    std::mt19937 gen(29);
+    std::uniform_int_distribution<t_int64> dist(0, 9);
+    const char* strs[] = {"a", "b", "c", "d", "e"};
+
+    auto make_value = [&](t_uindex cidx) {
+        t_int64 v = dist(gen);
+        switch (cidx)
+        {
+            case 0:
+                return mktscalar<t_float64>(v + 0.5);
+            case 1:
+                return mktscalar<const char*>(strs[v % 5]);
+            case 2:
+                return mktscalar<t_bool>(v % 2 == 0);
+            default:
+                return mktscalar<t_int32>(t_int32(v));
+        }
+    };
+
+    // Step 0 loads an empty state, steps 1 and 2 only add new pkeys, fully
+    // valid and then with nulls and cleared values, later steps mix updates,
+    // inserts and deletes
+    for (t_int64 step = 0; step < 12; ++step)
+    {
+        std::vector<t_tscalvec> rows;
+        for (t_int64 pkey = 0; pkey < 80; ++pkey)
+        {
+            t_bool in_batch = step < 3 ? pkey / 20 == step : dist(gen) < 4;
+            if (!in_batch)
+                continue;
+
+            if (step >= 3 && dist(gen) < 2)
+            {
+                rows.push_back({dop, mktscalar<t_int64>(pkey), mknone(),
+                    mknone(), mknone(), mknone()});
+                expected.erase(pkey);
+                continue;
+            }
+
+            t_tscalvec row{iop, mktscalar<t_int64>(pkey)};
+            auto& values = expected[pkey];
+            values.resize(cols.size(), mknull(DTYPE_NONE));
+            for (t_uindex cidx = 0; cidx < cols.size(); ++cidx)
+            {
+                t_int64 kind = step < 2 ? 9 : dist(gen);
+                t_dtype dtype = sch.get_dtype(cols[cidx]);
+                if (kind == 0)
+                {
+                    row.push_back(mknull(dtype));
+                }
+                else if (kind == 1)
+                {
+                    row.push_back(mkclear(dtype));
+                    values[cidx] = mknull(dtype);
+                }
+                else
+                {
+                    row.push_back(make_value(cidx));
+                    values[cidx] = row.back();
+                }
+            }
+            rows.push_back(row);
+        }
+
+        t_table tbl(sch, rows);
+        state.update_history(tbl.flatten().get());
+
+        EXPECT_EQ(state.mapping_size(), expected.size());
+        for (t_int64 pkey = 0; pkey < 80; ++pkey)
+        {
+            auto key = mktscalar<t_int64>(pkey);
+            auto iter = expected.find(pkey);
+            ASSERT_EQ(state.has_pkey(key), iter != expected.end());
+            if (iter == expected.end())
+                continue;
+
+            for (t_uindex cidx = 0; cidx < cols.size(); ++cidx)
+            {
+                auto value = state.get(key, cols[cidx]);
+                const auto& want = iter->second[cidx];
+                ASSERT_EQ(value.is_valid(), want.is_valid())
+                    << step << " " << pkey << " " << cols[cidx];
+                if (want.is_valid())
+                    EXPECT_EQ(value.to_string(), want.to_string());
+            }
+        }
+    }
+}
+
+TEST(ORDER_STATS, ranks_and_replaces)
+{
+    t_order_stats stats;
+    EXPECT_TRUE(stats.empty());
+    EXPECT_EQ(stats.nth(0), mknone());
+    EXPECT_EQ(stats.min_value(), mknone());
+
+    for (t_int64 pkey = 0; pkey < 5; ++pkey)
+    {
+        stats.insert(mktscalar(pkey), mktscalar(10 - pkey), mktscalar(pkey));
+    }
+    EXPECT_EQ(stats.size(), 5);
+    EXPECT_EQ(stats.nth(0), 4_ts);
+    EXPECT_EQ(stats.nth(4), 0_ts);
+    EXPECT_EQ(stats.min_value(), 4_ts);
+    EXPECT_EQ(stats.max_value(), 0_ts);
+
+    stats.insert(0_ts, 1_ts, 0_ts);
+    EXPECT_EQ(stats.size(), 5);
+    EXPECT_EQ(stats.min_value(), 0_ts);
+    EXPECT_EQ(stats.nth(2), 3_ts);
+
+    stats.erase(0_ts);
+    stats.erase(7_ts);
+    EXPECT_EQ(stats.size(), 4);
+    EXPECT_EQ(stats.min_value(), 4_ts);
+}
+
+TEST(ORDER_STATS, ties_and_nans)
+{
+    t_order_stats stats;
+    stats.insert(1_ts, 5_ts, "a"_ts);
+    stats.insert(3_ts, 5_ts, "c"_ts);
+    stats.insert(2_ts, 5_ts, "b"_ts);
+
+    // the greatest pkey wins among equal keys
+    EXPECT_EQ(stats.min_value(), "c"_ts);
+    EXPECT_EQ(stats.max_value(), "c"_ts);
+
+    t_float64 nan = std::numeric_limits<t_float64>::quiet_NaN();
+    t_order_stats floats;
+    floats.insert(1_ts, mktscalar(nan), 1_ts);
+    floats.insert(2_ts, mktscalar(2.0), 2_ts);
+    floats.insert(3_ts, mktscalar(nan), 3_ts);
+    floats.insert(4_ts, mktscalar(1.0), 4_ts);
+
+    EXPECT_EQ(floats.min_value(), 4_ts);
+    EXPECT_EQ(floats.nth(1), 2_ts);
+    EXPECT_EQ(floats.max_value(), 3_ts);
+
+    floats.erase(3_ts);
+    floats.erase(1_ts);
+    EXPECT_EQ(floats.max_value(), 2_ts);
+}